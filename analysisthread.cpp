@@ -0,0 +1,101 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "analysisthread.h"
+#include "audiomonitor.h"
+
+
+/*!
+  The constructor sets up the thread without monitors. The thread needs to be
+  started by the caller.
+*/
+AnalysisThread::AnalysisThread(QObject *parent)
+    : QThread(parent), itsStopRequest(0)
+{
+}
+
+
+/*!
+  The destructor terminates the thread.
+*/
+AnalysisThread::~AnalysisThread()
+{
+    stop();
+}
+
+
+/*!
+  addMonitor adds an AudioMonitor whose data is analysed by this thread.
+*/
+void AnalysisThread::addMonitor(AudioMonitor *monitor)
+{
+    QMutexLocker locker(&itsLock);
+    itsMonitors.append(monitor);
+}
+
+
+/*!
+  removeMonitor removes the given AudioMonitor. If its data is currently
+  analysed, it waits for the analysis to finish.
+*/
+void AnalysisThread::removeMonitor(AudioMonitor *monitor)
+{
+    QMutexLocker locker(&itsLock);
+    itsMonitors.removeAll(monitor);
+}
+
+
+/*!
+  wakeUp signals new audio data to the thread.
+*/
+void AnalysisThread::wakeUp()
+{
+    itsWakeUps.release();
+}
+
+
+/*!
+  stop terminates the thread and waits for its end.
+*/
+void AnalysisThread::stop()
+{
+    itsStopRequest = 1;
+    wakeUp();
+    wait();
+}
+
+
+/*!
+  run waits for new audio data and lets all monitors analyse their pending
+  data then.
+*/
+void AnalysisThread::run()
+{
+    forever {
+        itsWakeUps.acquire();
+
+        // all pending data gets processed at once
+        itsWakeUps.tryAcquire(itsWakeUps.available());
+
+        if (itsStopRequest)
+            break;
+
+        QMutexLocker locker(&itsLock);
+        foreach (AudioMonitor *monitor, itsMonitors)
+            monitor->analyze();
+    }
+}
@@ -0,0 +1,67 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ANALYSISTHREAD_H
+#define ANALYSISTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QList>
+
+
+// forward class declaration
+class AudioMonitor;
+
+
+/*!
+  AnalysisThread performs the audio analysis of its AudioMonitor instances
+  outside of the main thread. The monitors queue the captured audio data and
+  wake up the thread, which processes all pending data then.
+
+  This decouples the audio analysis from the main thread, which also renders
+  the user interface and performs synchronous DBus calls.
+*/
+class AnalysisThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit AnalysisThread(QObject *parent = 0);
+    ~AnalysisThread();
+
+    void addMonitor(AudioMonitor *monitor);
+    void removeMonitor(AudioMonitor *monitor);
+
+    void wakeUp();
+    void stop();
+
+protected:
+    void run();
+
+private:
+    //! the monitors whose data is analysed by this thread
+    QList<AudioMonitor*> itsMonitors;
+    //! protects the monitor list
+    QMutex itsLock;
+    //! counts the pending wake up requests
+    QSemaphore itsWakeUps;
+    //! set as the thread shall terminate
+    QAtomicInt itsStopRequest;
+};
+
+#endif // ANALYSISTHREAD_H
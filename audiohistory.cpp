@@ -0,0 +1,215 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "audiohistory.h"
+#include "wavwriter.h"
+
+#include <QVector>
+#include <QDebug>
+
+
+/*!
+  The constructor sets up a disabled history.
+*/
+AudioHistory::AudioHistory()
+    : itsBlockCount(0), itsHead(0), itsFilled(0), itsSamples(0), itsRate(0)
+{
+}
+
+
+/*!
+  setup allocates the history for the given sample rate and duration in
+  seconds. A duration of 0 disables it.
+*/
+void AudioHistory::setup(int rate, int duration)
+{
+    QMutexLocker locker(&itsLock);
+
+    itsRate = rate;
+    itsBlockCount = 0;
+    if (duration > 0)
+        itsBlockCount = ((qint64)rate * duration + BLOCK_SAMPLES-1) / BLOCK_SAMPLES + 1;
+
+    itsBlocks.fill(0, itsBlockCount * BLOCK_BYTES);
+    itsPeaks.fill(0, itsBlockCount);
+    itsCounters.fill(0, itsBlockCount);
+    itsHead = 0;
+    itsFilled = 0;
+    itsSamples = 0;
+    itsState.predictor = 0;
+    itsState.index = 0;
+}
+
+
+/*!
+  isEnabled returns true if the history keeps audio.
+*/
+bool AudioHistory::isEnabled() const
+{
+    return itsBlockCount > 0;
+}
+
+
+/*!
+  write compresses the given samples into the history, overwriting the oldest
+  block when the ring is full.
+*/
+void AudioHistory::write(const qint16 *samples, int count)
+{
+    QMutexLocker locker(&itsLock);
+    if (itsBlockCount == 0)
+        return;
+
+    for (int i = 0; i < count; ++i) {
+        uchar *block = (uchar*)itsBlocks.data() + itsHead * BLOCK_BYTES;
+
+        if (itsSamples == 0) {
+            // the first sample starts a new block with the coder state
+            itsState.predictor = samples[i];
+            block[0] = (quint16)samples[i] & 0xff;
+            block[1] = (quint16)samples[i] >> 8;
+            block[2] = itsState.index;
+            block[3] = 0;
+        }
+        else {
+            // two samples per byte, the earlier one in the low nibble
+            quint8 code = ImaAdpcm::encode(&itsState, samples[i]);
+            uchar *byte = block + HEADER_BYTES + (itsSamples-1) / 2;
+            if ((itsSamples-1) % 2 == 0)
+                *byte = code;
+            else
+                *byte |= code << 4;
+        }
+
+        if (++itsSamples == BLOCK_SAMPLES) {
+            itsSamples = 0;
+            itsHead = (itsHead + 1) % itsBlockCount;
+            itsFilled = qMin(itsFilled + 1, itsBlockCount - 1);
+            itsPeaks[itsHead] = 0;
+            itsCounters[itsHead] = 0;
+        }
+    }
+}
+
+
+/*!
+  mark notes the volume and audio counter of the latest analysis interval at
+  the block being written. It is called by the analysis thread after the
+  interval is written.
+*/
+void AudioHistory::mark(int volume, int counter)
+{
+    QMutexLocker locker(&itsLock);
+    if (itsBlockCount == 0)
+        return;
+
+    itsPeaks[itsHead] = qMax(itsPeaks.at(itsHead), volume);
+    itsCounters[itsHead] = qMax(itsCounters.at(itsHead), counter);
+}
+
+
+/*!
+  copyBlocks copies the complete blocks of the history to the given array, the
+  oldest block first, and returns the sample rate. The block being written is
+  left out. The peak volume and the maximum audio counter are those marked
+  during the copied blocks, including the block being written, as it holds
+  the end of the latest interval. It returns false if the history is disabled.
+*/
+bool AudioHistory::copyBlocks(QByteArray *blocks, int *rate, int *peak, int *counter) const
+{
+    QMutexLocker locker(&itsLock);
+    if (itsBlockCount == 0)
+        return false;
+
+    blocks->clear();
+    blocks->reserve(itsFilled * BLOCK_BYTES);
+    *peak = itsPeaks.at(itsHead);
+    *counter = itsCounters.at(itsHead);
+    for (int i = itsFilled; i > 0; --i) {
+        int block = (itsHead - i + itsBlockCount) % itsBlockCount;
+        blocks->append(itsBlocks.constData() + block * BLOCK_BYTES, BLOCK_BYTES);
+        *peak = qMax(*peak, itsPeaks.at(block));
+        *counter = qMax(*counter, itsCounters.at(block));
+    }
+    *rate = itsRate;
+
+    return true;
+}
+
+
+/*!
+  decodeBlock decompresses the given number of samples of a block.
+*/
+int AudioHistory::decodeBlock(const uchar *block, int samples, qint16 *result)
+{
+    ImaAdpcm::State state;
+    state.predictor = (qint16)(block[0] | (block[1] << 8));
+    state.index = block[2];
+
+    if (samples > 0)
+        result[0] = state.predictor;
+    for (int i = 1; i < samples; ++i) {
+        quint8 byte = block[HEADER_BYTES + (i-1) / 2];
+        quint8 code = ((i-1) % 2 == 0) ? (byte & 0x0f) : (byte >> 4);
+        result[i] = ImaAdpcm::decode(&state, code);
+    }
+
+    return samples;
+}
+
+
+/*!
+  save writes the whole history to a WAV file, the oldest audio first. It
+  returns false on errors.
+*/
+bool AudioHistory::save(const QString &fileName) const
+{
+    // take a snapshot, the analysis continues meanwhile
+    itsLock.lock();
+    // a deep copy, such that the analysis thread keeps its unshared buffer
+    QByteArray blocks(itsBlocks.constData(), itsBlocks.size());
+    int head = itsHead;
+    int filled = itsFilled;
+    int samples = itsSamples;
+    int blockCount = itsBlockCount;
+    int rate = itsRate;
+    itsLock.unlock();
+
+    if (blockCount == 0)
+        return false;
+
+    WavWriter writer;
+    if (!writer.open(fileName, rate)) {
+        qWarning() << "Cannot write audio history to" << fileName << ":" << writer.errorString();
+        return false;
+    }
+
+    // complete blocks, followed by the one being written
+    QVector<qint16> buffer(BLOCK_SAMPLES);
+    const uchar *data = (const uchar*)blocks.constData();
+    for (int i = filled; i >= 0; --i) {
+        int block = (head - i + blockCount) % blockCount;
+        int count = (i > 0) ? BLOCK_SAMPLES : samples;
+        decodeBlock(data + block * BLOCK_BYTES, count, buffer.data());
+        if (!writer.write(buffer.constData(), count)) {
+            qWarning() << "Cannot write audio history to" << fileName << ":" << writer.errorString();
+            return false;
+        }
+    }
+
+    return writer.close();
+}
@@ -0,0 +1,93 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef AUDIOHISTORY_H
+#define AUDIOHISTORY_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "imaadpcm.h"
+
+/*!
+  AudioHistory keeps the most recent audio of a room, such that the moments
+  before a notification can be listened to afterwards.
+
+  The audio is stored IMA ADPCM compressed in a ring of fixed size blocks,
+  allocated once by setup. Each block starts with the coder state, so the
+  oldest block can be overwritten without affecting the others. A minute of
+  8 kHz audio takes 240 kB.
+
+  write is called by the analysis thread, save by any other thread. save only
+  copies the compressed blocks while holding the lock, the decompression and
+  the file output do not hold up the audio analysis. copyBlocks likewise hands
+  the compressed history to the EventRecorder.
+
+  mark notes the volume and audio counter of each analysis interval at the
+  block being written, such that a copy of the history knows its peak volume
+  and maximum counter.
+*/
+class AudioHistory
+{
+public:
+    AudioHistory();
+
+    void setup(int rate, int duration);
+    bool isEnabled() const;
+
+    void write(const qint16 *samples, int count);
+    void mark(int volume, int counter);
+    bool save(const QString &fileName) const;
+
+    bool copyBlocks(QByteArray *blocks, int *rate, int *peak, int *counter) const;
+
+    //! size of a compressed block in bytes
+    const static int BLOCK_BYTES = 256;
+    //! size of the block header with the coder state
+    const static int HEADER_BYTES = 4;
+    //! number of samples per block, the first one is stored in the header
+    const static int BLOCK_SAMPLES = 1 + (BLOCK_BYTES - HEADER_BYTES) * 2;
+
+private:
+
+    static int decodeBlock(const uchar *block, int samples, qint16 *result);
+
+    //! protects the block ring
+    mutable QMutex itsLock;
+    //! the ring of compressed blocks
+    QByteArray itsBlocks;
+    //! number of blocks of the ring
+    int itsBlockCount;
+    //! index of the block being written
+    int itsHead;
+    //! number of complete blocks in the ring
+    int itsFilled;
+    //! number of samples in the block being written
+    int itsSamples;
+    //! highest volume marked per block
+    QVector<int> itsPeaks;
+    //! highest audio counter marked per block
+    QVector<int> itsCounters;
+    //! encoder state
+    ImaAdpcm::State itsState;
+    //! sample rate in Hz
+    int itsRate;
+};
+
+#endif // AUDIOHISTORY_H
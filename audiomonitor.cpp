@@ -16,23 +16,29 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "audiomonitor.h"
-
-#include <stdlib.h>
-#include <cmath>
+#include "analysisthread.h"
 
 #include <QDebug>
 #include <QAudioDeviceInfo>
 #include <QAudioInput>
 #include <QTimer>
+#include <string.h>
 
 
 /*!
-  The constructor initializes the audio device and negotiates the audio stream
-  format. The audio sampling is started but immediately suspended. The
+  The constructor initializes the given audio device and negotiates the audio
+  stream format. The audio sampling is started but immediately suspended. The
   application has to resume it to receive audio data.
 */
-AudioMonitor::AudioMonitor(const Settings *settings, QObject *parent)
-    :QIODevice(parent), itsSettings(settings)
+AudioMonitor::AudioMonitor(const Settings *settings, const QAudioDeviceInfo &device,
+                           QObject *parent)
+    :QIODevice(parent), itsSettings(settings), itsDevice(0),
+      itsName(device.deviceName()),
+      itsVolumeScale(VolumeScale::defaultType()),
+      itsNoiseFloor(NOISE_FLOOR_BUCKETS, settings->NOISE_FLOOR_PERCENTILE,
+                    settings->NOISE_FLOOR_TIME_CONSTANT*1000 / settings->AUDIO_SAMPLE_INTERVAL),
+      itsAudioTrigger(settings), itsDutyCycle(0), itsIgnoredDecisions(0),
+      itsAnalysisThread(0), itsResetRequest(0), itsResetDone(0), itsNoiseRequest(0)
 {
     // open IODevice
     open(QIODevice::WriteOnly);
@@ -41,7 +47,7 @@ AudioMonitor::AudioMonitor(const Settings *settings, QObject *parent)
     QAudioFormat itsAudioFormat;
 
     // this is what we want
-    itsAudioFormat.setFrequency(8000);
+    itsAudioFormat.setFrequency(itsSettings->AUDIO_ANALYSIS_RATE);
     itsAudioFormat.setChannels(1);
     itsAudioFormat.setSampleSize(16);
     itsAudioFormat.setSampleType(QAudioFormat::SignedInt);
@@ -49,26 +55,399 @@ AudioMonitor::AudioMonitor(const Settings *settings, QObject *parent)
     itsAudioFormat.setCodec("audio/pcm");
 
     // this is what we get
-    QAudioDeviceInfo info(QAudioDeviceInfo::defaultInputDevice());
-    if (!info.isFormatSupported(itsAudioFormat)) {
-        itsAudioFormat = info.nearestFormat(itsAudioFormat);
+    if (!device.isFormatSupported(itsAudioFormat)) {
+        itsAudioFormat = device.nearestFormat(itsAudioFormat);
         qWarning() << "Could not get desired audio format. Nearest available format has"
                    << "frequency" << itsAudioFormat.frequency()
+                   << "channels" << itsAudioFormat.channels()
                    << "sample size" << itsAudioFormat.sampleSize();
     }
-    if (itsAudioFormat.sampleSize() != 16) {
-        qCritical() << "Audio device doesn't support needed format, exiting.";
-        exit(1);
+    if (!setupFormat(itsAudioFormat)) {
+        qCritical() << "Audio device" << itsName << "provides no supported format";
         return;
     }
 
     // create device
-    itsDevice = new QAudioInput(itsAudioFormat, this);
+    itsDevice = new QAudioInput(device, itsAudioFormat, this);
     itsDevice->setNotifyInterval(itsSettings->AUDIO_SAMPLE_INTERVAL);
+}
+
+
+/*!
+  This constructor sets up an AudioMonitor without audio device. The audio data
+  of the given format needs to be written to the monitor by the caller.
+*/
+AudioMonitor::AudioMonitor(const Settings *settings, const QAudioFormat &format,
+                           QObject *parent)
+    :QIODevice(parent), itsSettings(settings), itsDevice(0),
+      itsVolumeScale(VolumeScale::defaultType()),
+      itsNoiseFloor(NOISE_FLOOR_BUCKETS, settings->NOISE_FLOOR_PERCENTILE,
+                    settings->NOISE_FLOOR_TIME_CONSTANT*1000 / settings->AUDIO_SAMPLE_INTERVAL),
+      itsAudioTrigger(settings), itsDutyCycle(0), itsIgnoredDecisions(0),
+      itsAnalysisThread(0), itsResetRequest(0), itsResetDone(0), itsNoiseRequest(0)
+{
+    // open IODevice
+    open(QIODevice::WriteOnly);
+
+    if (!setupFormat(format))
+        qCritical() << "Audio format not supported.";
+}
+
+
+/*!
+  name returns the name of the monitored audio input device.
+*/
+QString AudioMonitor::name() const
+{
+    return itsName;
+}
+
+
+/*!
+  isValid returns true if the audio format is supported by the analysis.
+*/
+bool AudioMonitor::isValid() const
+{
+    return itsFormatKernel.isValid();
+}
+
+
+/*!
+  setupFormat checks the given audio format and initializes the analysis state.
+  Audio of a higher sample rate than AUDIO_ANALYSIS_RATE gets decimated to it,
+  so the analysis behaves equally for all devices. For lower rates, the
+  subinterval length is scaled to the sample rate, such that it keeps its
+  duration. The analysis intervals have a fixed duration of
+  AUDIO_SAMPLE_INTERVAL. If the level analysis is filtered or the noise is
+  suppressed, the audio is converted to S16 mono as well. It returns false if
+  the format is not supported.
+*/
+bool AudioMonitor::setupFormat(const QAudioFormat &format)
+{
+    itsFormat = format;
+    itsAnalysisFormat = format;
     itsActive = false;
 
+    // setup decimation of high sample rates to native S16 mono
+    itsInputKernel.setup(format, LevelKernel::TYPE_SCALAR);
+    bool decimate = itsInputKernel.isValid() &&
+            itsDecimator.setup(format.frequency(), itsSettings->AUDIO_ANALYSIS_RATE, CONVERT_CHUNK);
+
+    // the filter coefficients depend on the negotiated sample rate
+    int filterRate = 0;
+    if (itsInputKernel.isValid())
+        filterRate = decimate ? itsSettings->AUDIO_ANALYSIS_RATE : format.frequency();
+    itsFilter.setup(filterRate, itsSettings->itsFilterDcBlock, itsSettings->itsFilterHighPass,
+                    itsSettings->itsFilterAWeighting);
+    itsSuppressor.setup(filterRate, qMax(0, itsSettings->itsNoiseSuppression));
+
+    if (decimate || itsFilter.isEnabled() || itsSuppressor.isEnabled()) {
+        if (decimate)
+            itsAnalysisFormat.setFrequency(itsSettings->AUDIO_ANALYSIS_RATE);
+        itsAnalysisFormat.setChannels(1);
+        itsAnalysisFormat.setSampleSize(16);
+        itsAnalysisFormat.setSampleType(QAudioFormat::SignedInt);
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        itsAnalysisFormat.setByteOrder(QAudioFormat::LittleEndian);
+#else
+        itsAnalysisFormat.setByteOrder(QAudioFormat::BigEndian);
+#endif
+    }
+    if (decimate) {
+        itsDecimatedBuffer.resize(itsDecimator.maxOutput());
+
+        qDebug() << "Decimating audio from" << format.frequency() << "Hz to"
+                 << itsAnalysisFormat.frequency() << "Hz";
+    }
+
+    itsConvertBuffer.resize(CONVERT_CHUNK);
+
+    // setup audio history, at the analysis rate, only kept for the event clips
+    int rate = itsAnalysisFormat.frequency();
+    int history = itsSettings->itsClipQuota > 0 ? itsSettings->itsHistoryDuration : 0;
+    itsHistory.setup(rate, qBound(0, history, MAX_HISTORY_DURATION));
+
+    // setup the detectors rating the audio, at the analysis rate
+    setupPipeline(rate);
+
+    // the cascade runs the detectors only once the counter reached its level,
+    // starting with the pre-roll of the recent audio
+    itsCascadeWindow = 0;
+    if ( (itsSettings->itsCascadeWindow > 0) && !itsPipeline.isEmpty() )
+        itsCascadeWindow = itsSettings->itsCascadeWindow * rate;
+    itsCascadeLevel = qBound(0, itsSettings->itsCascadeLevel, 100)
+            * itsSettings->THRESHOLD_VALUE * COUNTER_SCALE_FACTOR / 100;
+    itsCascadeRemaining = 0;
+    itsPreRoll.fill(0, itsCascadeWindow > 0 ? CASCADE_PRE_ROLL * rate / 1000 : 0);
+    itsPreRollPos = 0;
+    itsCascadeAwakeFrames = 0;
+    itsCascadeFrames = 0;
+    itsDutyCycle = itsPipeline.isEmpty() ? 0 : 1000;
+
+    // setup analysis intervals
+    itsBlockSize = qMax(1, itsSettings->AUDIO_SAMPLE_SUBINTERVAL * rate / itsSettings->AUDIO_ANALYSIS_RATE);
+    itsIntervalFrames = qMax(2, rate * itsSettings->AUDIO_SAMPLE_INTERVAL / 1000);
+    itsIntervalBlocks = (itsIntervalFrames-1) / itsBlockSize;
+    itsIntervalPos = 0;
+    itsIntervalEnergy = 0;
+    itsBlockPeak = 0;
+    itsBlocks.fill(LevelBlock(), MAX_CHUNK_BLOCKS);
+
+    // setup sliding window, if configured
+    int period = itsSettings->AUDIO_SAMPLE_INTERVAL;
+    itsWindowBlocks = 0;
+    if (itsSettings->itsAudioWindow > 0) {
+        int blockFrames = itsBlockSize * 1000;
+        itsWindowBlocks = qMax(1, itsSettings->itsAudioWindow * rate / blockFrames);
+        itsHopBlocks = qBound(1, itsSettings->itsAudioHop * rate / blockFrames, itsWindowBlocks);
+        itsWindow.setup(itsWindowBlocks);
+        itsHopPos = 0;
+        itsBlockPos = 0;
+        period = itsHopBlocks * blockFrames / rate;
+
+        qDebug() << "Sliding window of" << itsWindowBlocks << "subintervals, hop"
+                 << itsHopBlocks << "subintervals";
+    }
+
+    // the noise floor fades with time, independent of the decision rate
+    itsNoiseFloor.setTimeConstant(itsSettings->NOISE_FLOOR_TIME_CONSTANT*1000 / qMax(1, period));
+
     // reset counter
     itsCounter = 0;
+    itsCounterFraction = 0;
+
+    // select the fastest level analysis kernel of this CPU
+    setKernel(LevelKernel::best(itsBlockSize));
+
+    if (!itsFormatKernel.isValid()) {
+        qCritical() << "Unsupported audio format: sample type" << format.sampleType()
+                    << "sample size" << format.sampleSize()
+                    << "channels" << format.channels();
+        return false;
+    }
+
+    return true;
+}
+
+
+/*!
+  setupPipeline sets up the detectors rating the audio of the given sample
+  rate. A pipeline file of the settings defines them freely. Otherwise, the
+  stock pipeline follows the detector settings: the spectral detector or the
+  Goertzel filters of the selected frequencies, the pitch detector and the
+  cry classifier each need to reach their threshold, if enabled. The classifier
+  is optional, without model the audio just is not rated. Rather than all
+  detectors, the ensemble rule may require any of them, the majority vote or
+  the mean. Then, the volume threshold becomes a member of the ensemble.
+*/
+void AudioMonitor::setupPipeline(int rate)
+{
+    if (!itsSettings->itsPipelineFile.isEmpty()) {
+        if (itsPipeline.load(itsSettings->itsPipelineFile, rate))
+            return;
+        qWarning() << "Using the stock pipeline instead of" << itsSettings->itsPipelineFile;
+    }
+
+    itsPipeline.setup(rate);
+    QStringList gates;
+    QString probability;
+
+    if (itsSettings->itsSpectralThreshold > 0) {
+        QStringList frequencies;
+        foreach (int frequency, itsSettings->itsToneFrequencies)
+            frequencies.append(QString::number(frequency));
+        QVariantMap parameters;
+        parameters.insert("frequencies", frequencies);
+        if (itsPipeline.addNode("spectral", frequencies.isEmpty() ? "spectral" : "goertzel", parameters))
+            addGate("spectral", itsSettings->itsSpectralThreshold, &gates);
+    }
+    if ( (itsSettings->itsPitchThreshold > 0) &&
+         itsPipeline.addNode("pitch", "pitch", QVariantMap()) )
+        addGate("pitch", itsSettings->itsPitchThreshold, &gates);
+    if (!itsSettings->itsClassifierFile.isEmpty()) {
+        QVariantMap parameters;
+        parameters.insert("model", itsSettings->itsClassifierFile);
+        if (itsPipeline.addNode("classifier", "classifier", parameters)) {
+            probability = "classifier";
+            if (itsSettings->itsClassifierThreshold > 0)
+                addGate("classifier", itsSettings->itsClassifierThreshold, &gates);
+        }
+    }
+
+    // by default, all detectors need to reach their threshold
+    QString rule = itsSettings->itsEnsembleRule;
+    if ( (rule != "any") && (rule != "vote") && (rule != "mean") )
+        rule = "all";
+    if ( (rule != "all") && !gates.isEmpty() &&
+         itsPipeline.addNode("level", "level", QVariantMap()) )
+        gates.append("level");
+    if (!gates.isEmpty()) {
+        QVariantMap parameters;
+        parameters.insert("inputs", gates);
+        itsPipeline.addNode("gate", rule, parameters);
+    }
+
+    itsPipeline.schedule(gates.isEmpty() ? QString() : "gate", probability);
+}
+
+
+/*!
+  addGate adds a threshold node of the given detector node to the stock
+  pipeline and appends it to the given gates.
+*/
+void AudioMonitor::addGate(const QString &detector, int threshold, QStringList *gates)
+{
+    QVariantMap parameters;
+    parameters.insert("input", detector);
+    parameters.insert("threshold", threshold);
+    if (itsPipeline.addNode(detector + "Gate", "threshold", parameters))
+        gates->append(detector + "Gate");
+}
+
+
+/*!
+  setKernel selects the level analysis kernel for native S16 mono audio. Unless
+  demanded otherwise, the fastest one of this CPU is used.
+*/
+void AudioMonitor::setKernel(LevelKernel::Type kernel)
+{
+    if (!LevelKernel::isAvailable(kernel, itsBlockSize)) {
+        qWarning() << "Level analysis kernel" << LevelKernel::name(kernel)
+                   << "not available, using scalar kernel";
+        kernel = LevelKernel::TYPE_SCALAR;
+    }
+
+    itsFormatKernel.setup(itsAnalysisFormat, kernel);
+    qDebug() << "Using level analysis kernel" << LevelKernel::name(kernel);
+}
+
+
+/*!
+  setVolumeScale selects the float or the fixed point volume computation. The
+  default is chosen at build time.
+*/
+void AudioMonitor::setVolumeScale(VolumeScale::Type type)
+{
+    itsVolumeScale = type;
+    qDebug() << "Using volume computation" << VolumeScale::name(type);
+}
+
+
+/*!
+  setTaskPool runs the detectors in parallel on the given task pool, which
+  needs to exist as long as the monitor. It must not be called while audio is
+  captured.
+*/
+void AudioMonitor::setTaskPool(TaskPool *pool)
+{
+    itsPipeline.setPool(pool);
+}
+
+
+/*!
+  setFingerprintIndex sets the sounds to be ignored, which needs to exist as
+  long as the monitor. Loud audio recognized as one of them does not count.
+  The sounds are recognized at the analysis rate only. It must not be called
+  while audio is captured.
+*/
+void AudioMonitor::setFingerprintIndex(const FingerprintIndex *index)
+{
+    itsFingerprinter.setup(itsInputKernel.isValid() ? itsAnalysisFormat.frequency() : 0, index);
+}
+
+
+/*!
+  setAnalysisThread assigns the thread which performs the audio analysis. The
+  captured audio data gets queued for this thread from now on. It must not be
+  called while audio is captured.
+*/
+void AudioMonitor::setAnalysisThread(AnalysisThread *thread)
+{
+    if (itsAnalysisThread)
+        itsAnalysisThread->removeMonitor(this);
+
+    itsAnalysisThread = thread;
+
+    if (itsAnalysisThread) {
+        // the queue memory is allocated once
+        itsRingBuffer.allocate(itsFormat.frequency() * itsInputKernel.frameSize() *
+                               RING_BUFFER_DURATION);
+        itsAnalysisThread->addMonitor(this);
+    }
+}
+
+
+/*!
+  resetCounter requests to clear the audio duration counter. It is applied by
+  the analysis before processing the next audio data. Analysis results based
+  on the old counter value, which are not yet delivered, are dropped.
+*/
+void AudioMonitor::resetCounter()
+{
+    itsResetRequest.ref();
+}
+
+
+/*!
+  learnNoise requests to learn the profile of the background noise from the
+  audio of the given number of seconds, like the activation delay. It is
+  applied by the analysis before processing the next audio data. Without noise
+  suppression, the request is ignored.
+*/
+void AudioMonitor::learnNoise(int seconds)
+{
+    if (seconds > 0)
+        itsNoiseRequest.fetchAndStoreOrdered(seconds);
+}
+
+
+/*!
+  overruns returns the number of audio buffers that got lost since the
+  analysis thread fell behind.
+*/
+int AudioMonitor::overruns() const
+{
+    return itsRingBuffer.overruns();
+}
+
+
+/*!
+  dutyCycle returns the share of the audio analysed by the detectors and the
+  classifier in per mille. Without cascade, this is all or nothing.
+*/
+int AudioMonitor::dutyCycle() const
+{
+    return itsDutyCycle;
+}
+
+
+/*!
+  detectorStatistics returns a summary of the processing time of the detectors
+  and of their agreement with the decisions, empty if they did not run yet.
+*/
+QString AudioMonitor::detectorStatistics() const
+{
+    return itsPipeline.statistics();
+}
+
+
+/*!
+  ignoredDecisions returns the number of loud decisions which did not count,
+  as the audio was recognized as a sound to be ignored.
+*/
+int AudioMonitor::ignoredDecisions() const
+{
+    return itsIgnoredDecisions;
+}
+
+
+/*!
+  fingerprint returns the landmarks of the recent audio, to be added to the
+  sounds to be ignored. It is empty without index of ignored sounds.
+*/
+QVector<Landmark> AudioMonitor::fingerprint() const
+{
+    return itsFingerprinter.recent();
 }
 
 
@@ -81,6 +460,10 @@ AudioMonitor::~AudioMonitor()
     if (itsActive)
         stop();
 
+    // detach from analysis thread
+    if (itsAnalysisThread)
+        itsAnalysisThread->removeMonitor(this);
+
     // close IODevice
     close();
 }
@@ -92,9 +475,19 @@ AudioMonitor::~AudioMonitor()
 */
 bool AudioMonitor::start()
 {
+    // there is nothing to capture without supported audio format
+    if (!isValid())
+        return false;
+
     // start capturing
     // check whether we are already active before
     if (!itsActive) {
+        // without device the data gets written by the caller
+        if (itsDevice == 0) {
+            itsActive = true;
+            return true;
+        }
+
         itsDevice->start(this);
 
         // check for success
@@ -118,7 +511,8 @@ void AudioMonitor::stop()
 {
     // stop capturing
     itsActive = false;
-    itsDevice->stop();
+    if (itsDevice)
+        itsDevice->stop();
 }
 
 
@@ -136,75 +530,526 @@ qint64 AudioMonitor::readData(char *data, qint64 maxlen)
 
 
 /*!
-  writeData implements the central audio analysis functionality. It processes
-  the audio queue in quantities of AUDIO_SAMPLE_SUBINTERVAL. For each such
-  buffer it determines the maximum audio sample value and adds this to a
-  cummulated energy variable. After processing the whole data buffer this energy
-  variable is rescaled and represents the amplitude value, which is signalled
-  to the outside then.
-
-  writeData also compares this audio amplitude with the given threshold of the
-  application settings and handles the time based audio counter based on this.
-  If the volume is above the threshold the configurable increment is added to
-  the counter, otherwise the counter is decremented. The counter is reported
-  together with the volume in the signal.
+  writeData receives the captured audio data. With an analysis thread, the data
+  is queued for it. Otherwise, the data gets analysed immediately and the
+  result is signalled.
 */
 qint64 AudioMonitor::writeData(const char *data, qint64 len)
 {
-    quint32 curEnergy = 0;
-    qint16 max = 0;
-    qint16 samples = len/2;   // change data type to keep efficient
-
-    // sample format is S16LE, only!
-    const qint16 *buffer = (qint16*)data;
-
-    // derive energy
-    for (int i = 0; i < samples; ++i) {
-        // store maximum
-        if (*buffer > max)
-            max = *buffer;
-
-        // subinterval expired
-        if ((i % itsSettings->AUDIO_SAMPLE_SUBINTERVAL) == 0) {
-            // add current maximum and reset it
-            curEnergy += max;
-            //qDebug() << "add" << max << "new value:" << curEnergy;
-            max = 0;
+    if (itsAnalysisThread) {
+        if (!itsRingBuffer.write(data, len))
+            qWarning() << "Audio analysis overrun, dropped" << len << "bytes";
+        itsAnalysisThread->wakeUp();
+    }
+    else {
+        processAudio(data, len);
+    }
+
+    return len;
+}
+
+
+/*!
+  analyze processes all queued audio data. It gets called by the analysis
+  thread.
+*/
+void AudioMonitor::analyze()
+{
+    const char *data;
+    int len;
+
+    while ((data = itsRingBuffer.peek(&len)) != 0) {
+        processAudio(data, len);
+        itsRingBuffer.release();
+    }
+}
+
+
+/*!
+  reportResult forwards the analysis result of an audio interval. Without
+  analysis thread, it is signalled directly. Otherwise, the results are
+  collected and their delivery to the main thread is scheduled as the first
+  result of a new batch arrives.
+*/
+void AudioMonitor::reportResult(int counter, int value, int floor, int probability)
+{
+    if (itsAnalysisThread == 0) {
+        emit update(counter, value, floor, probability);
+        return;
+    }
+
+    Result result;
+    result.counter = counter;
+    result.value = value;
+    result.floor = floor;
+    result.probability = probability;
+    result.reset = itsResetDone;
+
+    QMutexLocker locker(&itsResultLock);
+    if (itsResults.isEmpty())
+        QMetaObject::invokeMethod(this, "deliverResults", Qt::QueuedConnection);
+    itsResults.append(result);
+}
+
+
+/*!
+  deliverResults signals the collected analysis results in the main thread.
+  Results that were computed before the latest counter reset are dropped.
+*/
+void AudioMonitor::deliverResults()
+{
+    itsResultLock.lock();
+    QVector<Result> results = itsResults;
+    itsResults.clear();
+    itsResultLock.unlock();
+
+    for (int i = 0; i < results.size(); ++i) {
+        // the receiver may reset the counter, so check for each result
+        if (results.at(i).reset != itsResetRequest)
+            continue;
+
+        emit update(results.at(i).counter, results.at(i).value, results.at(i).floor,
+                    results.at(i).probability);
+    }
+}
+
+
+/*!
+  processAudio passes the captured audio data to the analysis. Audio of high
+  sample rates is converted to S16 mono and decimated to AUDIO_ANALYSIS_RATE
+  first, in chunks of CONVERT_CHUNK frames. The audio of the analysis rate is
+  kept in the history. If configured, the noise is suppressed afterwards for
+  the detectors and the level analysis, and the level analysis gets the audio
+  filtered, also converted to S16 mono.
+*/
+void AudioMonitor::processAudio(const char *data, qint64 len)
+{
+    const int frameSize = itsInputKernel.frameSize();
+    qint64 frames = len / frameSize;
+
+    // apply pending noise profile request
+    int seconds = itsNoiseRequest.fetchAndStoreOrdered(0);
+    if (seconds > 0)
+        itsSuppressor.learn(seconds * itsAnalysisFormat.frequency());
+
+    // the history is written first, such that it covers a triggering buffer
+    if (!itsDecimator.isActive() && !itsFilter.isEnabled() && !itsSuppressor.isEnabled()) {
+        if (itsHistory.isEnabled() || !itsPipeline.isEmpty() || itsFingerprinter.isEnabled())
+            recordNative(data, frames);
+        analyzeFrames(data, frames);
+        return;
+    }
+
+    while (frames > 0) {
+        int n = qMin<qint64>(frames, CONVERT_CHUNK);
+        itsInputKernel.convert(data, n, itsConvertBuffer.data());
+        qint16 *native = itsConvertBuffer.data();
+        int count = n;
+        if (itsDecimator.isActive()) {
+            count = itsDecimator.process(itsConvertBuffer.constData(), n,
+                                         itsDecimatedBuffer.data());
+            native = itsDecimatedBuffer.data();
         }
 
-        // process next sample
-        buffer++;
+        // the history keeps the original audio, the detectors get it noise
+        // suppressed and the level analysis filtered as well
+        itsHistory.write(native, count);
+        itsSuppressor.process(native, count, native);
+        writeDetectors(native, count);
+        itsFilter.process(native, count);
+        analyzeFrames((const char*)native, count);
+
+        data += n * frameSize;
+        frames -= n;
+    }
+}
+
+
+/*!
+  recordNative passes the given frames to the history and the spectral
+  detectors. Unless the audio is native S16 mono, it gets converted in chunks of
+  CONVERT_CHUNK frames.
+*/
+void AudioMonitor::recordNative(const char *data, qint64 frames)
+{
+    if (itsInputKernel.isNative()) {
+        recordNative((const qint16*)data, frames);
+        return;
+    }
+
+    const int frameSize = itsInputKernel.frameSize();
+    while (frames > 0) {
+        int n = qMin<qint64>(frames, CONVERT_CHUNK);
+        itsInputKernel.convert(data, n, itsConvertBuffer.data());
+        recordNative(itsConvertBuffer.constData(), n);
+
+        data += n * frameSize;
+        frames -= n;
+    }
+}
+
+
+/*!
+  recordNative passes the given S16 mono frames of the analysis rate to the
+  history and all detectors.
+*/
+void AudioMonitor::recordNative(const qint16 *data, int frames)
+{
+    itsHistory.write(data, frames);
+    writeDetectors(data, frames);
+}
+
+
+/*!
+  writeDetectors passes the given S16 mono frames of the analysis rate to all
+  detectors. With the cascade, the detectors only get the frames while woken,
+  otherwise the frames are kept in the pre-roll. The fingerprinter gets all
+  frames, it is cheap.
+*/
+void AudioMonitor::writeDetectors(const qint16 *data, int frames)
+{
+    itsFingerprinter.write(data, frames);
+
+    if (itsCascadeWindow == 0) {
+        itsPipeline.write(data, frames);
+        return;
+    }
+    if (itsCascadeRemaining > 0)
+        itsPipeline.write(data, frames);
+
+    // keep the most recent frames in the pre-roll ring
+    const int size = itsPreRoll.size();
+    if (frames > size) {
+        data += frames - size;
+        frames = size;
+    }
+    while (frames > 0) {
+        int n = qMin(frames, size - itsPreRollPos);
+        memcpy(itsPreRoll.data() + itsPreRollPos, data, n * sizeof(qint16));
+        itsPreRollPos = (itsPreRollPos + n) % size;
+        data += n;
+        frames -= n;
     }
+}
+
+
+/*!
+  wakeDetectors starts the detectors for the cascade window. They first get
+  the pre-roll, oldest frames first, such that the onset of the sound is rated
+  as well.
+*/
+void AudioMonitor::wakeDetectors()
+{
+    itsPipeline.write(itsPreRoll.constData() + itsPreRollPos, itsPreRoll.size() - itsPreRollPos);
+    itsPipeline.write(itsPreRoll.constData(), itsPreRollPos);
+
+    itsCascadeAwakeFrames += itsPreRoll.size();
+    itsCascadeRemaining = itsCascadeWindow;
+}
+
+
+/*!
+  sleepDetectors stops the detectors at the end of the cascade window. Their
+  state is reset, the next window starts from the pre-roll again.
+*/
+void AudioMonitor::sleepDetectors()
+{
+    itsPipeline.reset();
+    itsCascadeRemaining = 0;
+}
+
+
+/*!
+  saveHistory writes the audio history of the room to the given WAV file,
+  without interrupting the audio analysis. It returns false if the history is
+  disabled or on errors.
+*/
+bool AudioMonitor::saveHistory(const QString &fileName) const
+{
+    return itsHistory.save(fileName);
+}
 
+
+/*!
+  copyHistory copies the compressed audio history of the room and returns its
+  sample rate, peak volume and maximum audio counter, without interrupting the
+  audio analysis. It returns false if the history is disabled.
+*/
+bool AudioMonitor::copyHistory(QByteArray *blocks, int *rate, int *peak, int *counter) const
+{
+    return itsHistory.copyBlocks(blocks, rate, peak, counter);
+}
+
+
+/*!
+  analyzeFrames passes the audio frames of the analysis format to the fixed
+  interval or to the sliding window analysis.
+*/
+void AudioMonitor::analyzeFrames(const char *data, qint64 frames)
+{
+    if (itsWindowBlocks > 0)
+        analyzeWindow(data, frames);
+    else
+        analyzeInterval(data, frames);
+}
+
+
+/*!
+  analyzeInterval implements the central audio analysis functionality. It splits
+  the audio stream into intervals of AUDIO_SAMPLE_INTERVAL duration,
+  independent of the buffer sizes delivered by the audio device. The first
+  frame of an interval forms a subinterval on its own, the following frames
+  are processed in subintervals of AUDIO_SAMPLE_SUBINTERVAL duration. For each
+  subinterval it determines the maximum audio sample value and adds this to a
+  cummulated energy variable. The incomplete subinterval at the end of an
+  interval is ignored.
+
+  The complete subintervals are analysed block wise by the FormatKernel, in
+  chunks of at most MAX_CHUNK_BLOCKS. Subintervals which are split between two
+  audio buffers are analysed piecewise.
+*/
+void AudioMonitor::analyzeInterval(const char *data, qint64 frames)
+{
+    const int frameSize = itsFormatKernel.frameSize();
+
+    while (frames > 0) {
+        int n;
+        int blockEnd = 1 + itsIntervalBlocks * itsBlockSize;
+
+        if (itsIntervalPos == 0) {
+            // the very first frame closes the initial subinterval on its own
+            LevelBlock block;
+            itsFormatKernel.analyzePartial(data, 1, &block);
+            itsIntervalEnergy = block.peak;
+            n = 1;
+        }
+        else if (itsIntervalPos < blockEnd) {
+            int blockPos = (itsIntervalPos-1) % itsBlockSize;
+            if ((blockPos == 0) && (frames >= itsBlockSize)) {
+                // complete subintervals are handled by the level kernel
+                int blocks = qMin<qint64>(frames / itsBlockSize, MAX_CHUNK_BLOCKS);
+                blocks = qMin(blocks, (blockEnd - itsIntervalPos) / itsBlockSize);
+                itsFormatKernel.analyze(data, blocks, itsBlockSize, itsBlocks.data());
+
+                // add the maximum of each subinterval
+                for (int i = 0; i < blocks; ++i)
+                    itsIntervalEnergy += itsBlocks[i].peak;
+                n = blocks * itsBlockSize;
+            }
+            else {
+                // subinterval split between audio buffers
+                n = qMin<qint64>(itsBlockSize - blockPos, frames);
+                LevelBlock block;
+                itsFormatKernel.analyzePartial(data, n, &block);
+                itsBlockPeak = qMax<int>(itsBlockPeak, block.peak);
+
+                if (blockPos + n == itsBlockSize) {
+                    itsIntervalEnergy += itsBlockPeak;
+                    itsBlockPeak = 0;
+                }
+            }
+        }
+        else {
+            // skip the incomplete subinterval at the end of the interval
+            n = qMin<qint64>(itsIntervalFrames - itsIntervalPos, frames);
+        }
+
+        data += n * frameSize;
+        frames -= n;
+        itsIntervalPos += n;
+
+        if (itsIntervalPos == itsIntervalFrames) {
+            finishInterval();
+            itsIntervalPos = 0;
+        }
+    }
+}
+
+
+/*!
+  analyzeWindow implements the sliding window analysis, which decides with
+  lower latency than the fixed intervals. The audio stream is split into
+  consecutive subintervals of AUDIO_SAMPLE_SUBINTERVAL duration, independent
+  of the buffer sizes delivered by the audio device. The maximum audio sample
+  value of each subinterval enters the SlidingWindow. After each hop of
+  itsHopBlocks subintervals, the sum of the window is evaluated.
+*/
+void AudioMonitor::analyzeWindow(const char *data, qint64 frames)
+{
+    const int frameSize = itsFormatKernel.frameSize();
+
+    while (frames > 0) {
+        int n;
+
+        if ((itsBlockPos == 0) && (frames >= itsBlockSize)) {
+            // complete subintervals are handled by the level kernel
+            int blocks = qMin<qint64>(frames / itsBlockSize, MAX_CHUNK_BLOCKS);
+            itsFormatKernel.analyze(data, blocks, itsBlockSize, itsBlocks.data());
+
+            for (int i = 0; i < blocks; ++i)
+                addWindowBlock(itsBlocks[i].peak);
+            n = blocks * itsBlockSize;
+        }
+        else {
+            // subinterval split between audio buffers
+            n = qMin<qint64>(itsBlockSize - itsBlockPos, frames);
+            LevelBlock block;
+            itsFormatKernel.analyzePartial(data, n, &block);
+            itsBlockPeak = qMax<int>(itsBlockPeak, block.peak);
+
+            itsBlockPos += n;
+            if (itsBlockPos == itsBlockSize) {
+                addWindowBlock(itsBlockPeak);
+                itsBlockPeak = 0;
+                itsBlockPos = 0;
+            }
+        }
+
+        data += n * frameSize;
+        frames -= n;
+    }
+}
+
+
+/*!
+  addWindowBlock adds the maximum of a subinterval to the sliding window and
+  evaluates the window at the end of each hop. The volume is derived from the
+  mean subinterval maximum of the window, as for the fixed intervals.
+*/
+void AudioMonitor::addWindowBlock(int peak)
+{
+    itsWindow.add(peak);
+
+    if (++itsHopPos < itsHopBlocks)
+        return;
+    itsHopPos = 0;
+
+    int volume = VolumeScale::volume(itsVolumeScale, itsSettings->itsAudioAmplify,
+                                     itsWindow.energy(), itsBlockSize,
+                                     itsWindow.count() * itsBlockSize);
+    evaluate(volume, itsHopBlocks * itsBlockSize);
+}
+
+
+/*!
+  finishInterval derives the volume of the completed audio interval. The
+  cummulated energy variable is rescaled and represents the amplitude value.
+*/
+void AudioMonitor::finishInterval()
+{
     // scale volume
-    int volume = itsSettings->itsAudioAmplify *
-                 log(curEnergy*itsSettings->AUDIO_SAMPLE_SUBINTERVAL/(float)samples);
-    // inhibit negative values from logarithm
-    if (volume < 0)
-        volume = 0;
+    int volume = VolumeScale::volume(itsVolumeScale, itsSettings->itsAudioAmplify,
+                                     itsIntervalEnergy, itsBlockSize, itsIntervalFrames);
+
+    evaluate(volume, itsIntervalFrames);
+}
+
+
+/*!
+  evaluate tracks the noise floor of the room and compares the audio amplitude
+  with the volume threshold, which adapts to the noise floor. It handles the
+  time based audio counter based on this. If the volume is above the threshold
+  the configurable increment is added to the counter, otherwise the counter is
+  decremented. Both are given per AUDIO_SAMPLE_INTERVAL and get scaled to the
+  given number of frames, the remainder is carried over. The counter is
+  reported together with the volume and the noise floor.
+  If detectors are set up, the volume only counts as above the threshold if
+  the audio since the last decision also passes their pipeline, see
+  setupPipeline. A pipeline with a level node rates the volume itself, as one
+  of its detectors. The cry probability of the pipeline is reported as well.
+  With the cascade, these detectors only run for a limited window once the
+  counter reached the cascade level. While they sleep, the counter is held at
+  this level, so only audio confirmed by the detectors raises the alarm.
+  Loud audio recognized as a sound the user marked to be ignored never counts.
+*/
+void AudioMonitor::evaluate(int volume, int frames)
+{
+    // apply pending counter reset
+    int reset = itsResetRequest;
+    if (reset != itsResetDone) {
+        itsCounter = 0;
+        itsCounterFraction = 0;
+        itsResetDone = reset;
+    }
+
+    // track the background noise
+    itsNoiseFloor.add(volume);
+    int floor = itsNoiseFloor.level();
+
+    // wake the sleeping detectors, if the counter reached the cascade level
+    bool loud = (volume > itsAudioTrigger.volumeThreshold(floor));
+    bool ignored = itsFingerprinter.isMatching();
+    if ( (itsCascadeWindow > 0) && (itsCascadeRemaining == 0) && loud && !ignored &&
+         (itsCounter >= itsCascadeLevel) )
+        wakeDetectors();
+    bool rated = (itsCascadeWindow == 0) || (itsCascadeRemaining > 0);
+
+    // loud sounds not rated as crying do not count, unless the pipeline rates
+    // the loudness itself
+    int probability = -1;
+    if ( rated && !itsPipeline.isEmpty() ) {
+        itsPipeline.evaluate(loud ? 100 : 0);
+        loud = itsPipeline.passes() && (loud || itsPipeline.usesLevel());
+        probability = itsPipeline.probability();
+    }
+
+    // known sounds, like the heating or a door, do not count
+    if (loud && ignored) {
+        loud = false;
+        itsIgnoredDecisions.ref();
+    }
 
     // update timer counter
-    if (volume > itsSettings->THRESHOLD_VALUE) {
+    int previous = itsCounter;
+    if (loud) {
         // increment counter
-        itsCounter += itsSettings->itsDurationInfluence;
+        itsCounterFraction += itsSettings->itsDurationInfluence * frames;
+        itsCounter += itsCounterFraction / itsIntervalFrames;
+        itsCounterFraction %= itsIntervalFrames;
 
         // check for overflow
         if (itsCounter / COUNTER_SCALE_FACTOR > itsSettings->VOLUME_COUNTER_MAX) {
             // overflow, clip it
             itsCounter = itsSettings->VOLUME_COUNTER_MAX * COUNTER_SCALE_FACTOR;
+            itsCounterFraction = 0;
         }
     }
     else {
         // decrement counter
-        itsCounter -= itsSettings->VOLUME_COUNTER_DEC;
+        itsCounterFraction -= itsSettings->VOLUME_COUNTER_DEC * frames;
+        itsCounter += itsCounterFraction / itsIntervalFrames;
+        itsCounterFraction %= itsIntervalFrames;
 
         // check for underflow
-        if (itsCounter < 0)
+        if (itsCounter < 0) {
             itsCounter = 0;
+            itsCounterFraction = 0;
+        }
     }
 
-    // signal the resulting values
-    emit update(itsCounter / COUNTER_SCALE_FACTOR, volume);
+    // without the detectors, the counter does not rise above the cascade level
+    if (itsCascadeWindow > 0) {
+        int limit = qMax(itsCascadeLevel, previous);
+        if (!rated && (itsCounter > limit)) {
+            itsCounter = limit;
+            itsCounterFraction = 0;
+        }
 
-    return len;
+        // the detectors sleep again after the window
+        itsCascadeFrames += frames;
+        if (rated) {
+            itsCascadeAwakeFrames += frames;
+            itsCascadeRemaining = qMax(0, itsCascadeRemaining - frames);
+            if (itsCascadeRemaining == 0)
+                sleepDetectors();
+        }
+        itsDutyCycle = qMin<qint64>(1000, itsCascadeAwakeFrames * 1000 / itsCascadeFrames);
+    }
+
+    // note the values at the audio history, for the event clip index
+    if (itsHistory.isEnabled())
+        itsHistory.mark(volume, itsCounter / COUNTER_SCALE_FACTOR);
+
+    // signal the resulting values
+    reportResult(itsCounter / COUNTER_SCALE_FACTOR, volume, floor, probability);
 }
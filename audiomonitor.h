@@ -17,7 +17,29 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
 */
 #include <QObject>
 #include <QAudioInput>
+#include <QAudioDeviceInfo>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInt>
 #include "settings.h"
+#include "levelkernel.h"
+#include "formatkernel.h"
+#include "decimator.h"
+#include "biquadchain.h"
+#include "noisesuppressor.h"
+#include "noisefloor.h"
+#include "volumescale.h"
+#include "slidingwindow.h"
+#include "dspgraph.h"
+#include "fingerprinter.h"
+#include "audiohistory.h"
+#include "audiotrigger.h"
+#include "audioringbuffer.h"
+
+
+// forward class declarations
+class AnalysisThread;
+class TaskPool;
 
 
 /*!
@@ -32,40 +54,217 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
   threshold defined in the application Settings and performs the time based
   audio analysis using a counter variable (itsCounter). The threshold check of
   the counter variable is performed outside of AudioMonitor.
+
+  If an AnalysisThread is assigned, the captured audio data is only queued in
+  an AudioRingBuffer and analysed by that thread. The analysis results are
+  collected and delivered as batch to the main thread, where the update signal
+  is emitted. Otherwise, the analysis is performed directly as the data is
+  written.
+
+  Without an audio device, AudioMonitor can be fed by writing audio data of the
+  given format directly. This is used by the offline replay tool.
 */
 class AudioMonitor : public QIODevice
 {
     Q_OBJECT
 public:
-    AudioMonitor(const Settings *settings, QObject *parent);
+    AudioMonitor(const Settings *settings, const QAudioDeviceInfo &device, QObject *parent);
+    AudioMonitor(const Settings *settings, const QAudioFormat &format, QObject *parent);
     ~AudioMonitor();
 
+    QString name() const;
+    bool isValid() const;
+
     bool start();
     void stop();
 
+    void setKernel(LevelKernel::Type kernel);
+    void setVolumeScale(VolumeScale::Type type);
+    void setAnalysisThread(AnalysisThread *thread);
+    void setTaskPool(TaskPool *pool);
+    void setFingerprintIndex(const FingerprintIndex *index);
+
+    void resetCounter();
+    void learnNoise(int seconds);
+    void analyze();
+
+    int overruns() const;
+    int dutyCycle() const;
+    QString detectorStatistics() const;
+    int ignoredDecisions() const;
+    QVector<Landmark> fingerprint() const;
+    bool saveHistory(const QString &fileName) const;
+    bool copyHistory(QByteArray *blocks, int *rate, int *peak, int *counter) const;
+
 private:
     qint64 readData(char *data, qint64 maxlen);
     qint64 writeData(const char *data, qint64 len);
 
+    bool setupFormat(const QAudioFormat &format);
+    void processAudio(const char *data, qint64 len);
+    void recordNative(const char *data, qint64 frames);
+    void recordNative(const qint16 *data, int frames);
+    void writeDetectors(const qint16 *data, int frames);
+    void setupPipeline(int rate);
+    void addGate(const QString &detector, int threshold, QStringList *gates);
+    void wakeDetectors();
+    void sleepDetectors();
+    void analyzeFrames(const char *data, qint64 frames);
+    void analyzeInterval(const char *data, qint64 frames);
+    void analyzeWindow(const char *data, qint64 frames);
+    void addWindowBlock(int peak);
+    void finishInterval();
+    void evaluate(int volume, int frames);
+    void reportResult(int counter, int value, int floor, int probability);
+
+private slots:
+    void deliverResults();
+
 signals:
-    //! reports a new audio sample with its value and the time based threshold	counter
-    void update(int counter, int value);
+    //! reports a new audio sample with its value, the time based threshold	counter,
+    //! the noise floor of the room and the cry probability, -1 without classifier
+    void update(int counter, int value, int floor, int probability);
 
 
 public:
-    //! audio duration counter
-    int itsCounter;
-
     //! active audio sampling state flag
     bool itsActive;
 
 private:
+    //! analysis result of one audio buffer
+    struct Result {
+        int counter;
+        int value;
+        int floor;
+        int probability;
+        //! counter reset request the result is based on
+        int reset;
+    };
+
     const static int COUNTER_SCALE_FACTOR = 5;
+    //! audio duration the ring buffer can hold, in seconds
+    const static int RING_BUFFER_DURATION = 4;
+    //! maximum number of subintervals analysed by one kernel call
+    const static int MAX_CHUNK_BLOCKS = 256;
+    //! audio replayed to the detectors when woken by the cascade, in milliseconds
+    const static int CASCADE_PRE_ROLL = 2000;
+    //! maximum number of frames converted or decimated by one call
+    const static int CONVERT_CHUNK = 1024;
+    //! maximum duration of the audio history in seconds
+    const static int MAX_HISTORY_DURATION = 600;
+    //! number of volume values covered by the noise floor histogram
+    const static int NOISE_FLOOR_BUCKETS = 256;
 
     //! reference to global application settings
     const Settings * const itsSettings;
 
-    //! the audio input device
+    //! the audio input device, not present in offline operation
     QAudioInput *itsDevice;
+
+    //! name of the audio input device
+    QString itsName;
+
+    //! the captured audio format, used for conversion prior to decimation
+    FormatKernel itsInputKernel;
+    //! decimator to the analysis rate, active for higher capture rates
+    Decimator itsDecimator;
+    //! converted and decimated samples of the current chunk
+    QVector<qint16> itsConvertBuffer;
+    QVector<qint16> itsDecimatedBuffer;
+    //! filter of the level analysis at the analysis rate, if configured
+    BiquadChain itsFilter;
+    //! noise suppression ahead of the detection, if configured
+    NoiseSuppressor itsSuppressor;
+
+    //! compressed audio of the recent past, at the analysis rate
+    AudioHistory itsHistory;
+
+    //! audio format of the level analysis
+    QAudioFormat itsAnalysisFormat;
+    //! the level analysis kernel of the audio format, selected at runtime
+    FormatKernel itsFormatKernel;
+
+    //! per subinterval analysis results of the current chunk
+    QVector<LevelBlock> itsBlocks;
+
+    //! number of frames of a subinterval
+    int itsBlockSize;
+    //! number of frames of an analysis interval
+    int itsIntervalFrames;
+    //! number of complete subintervals of an analysis interval
+    int itsIntervalBlocks;
+    //! number of frames of the current interval processed so far
+    int itsIntervalPos;
+    //! cummulated subinterval maxima of the current interval
+    quint64 itsIntervalEnergy;
+    //! maximum of the current subinterval, if split between audio buffers
+    int itsBlockPeak;
+
+    //! number of subintervals of the sliding window, 0 for fixed intervals
+    int itsWindowBlocks;
+    //! number of subintervals between two decisions of the sliding window
+    int itsHopBlocks;
+    //! number of subintervals since the last decision
+    int itsHopPos;
+    //! number of frames of the current subinterval processed so far
+    int itsBlockPos;
+    //! the subinterval maxima of the sliding window
+    SlidingWindow itsWindow;
+
+    //! the negotiated audio format
+    QAudioFormat itsFormat;
+
+    //! volume computation, float or fixed point
+    VolumeScale::Type itsVolumeScale;
+
+    //! audio duration counter, owned by the analysing thread
+    int itsCounter;
+    //! remainder of the counter in frames, for decisions shorter than an interval
+    int itsCounterFraction;
+    //! background noise estimation, owned by the analysing thread
+    NoiseFloor itsNoiseFloor;
+    //! threshold check of the volume values
+    AudioTrigger itsAudioTrigger;
+    //! the detectors rating the audio as crying, owned by the analysing thread
+    DspGraph itsPipeline;
+
+    //! frames the detectors run once woken by the cascade, 0 to run them all the time
+    int itsCascadeWindow;
+    //! counter value waking the detectors, the counter stays below while they sleep
+    int itsCascadeLevel;
+    //! frames the detectors keep running, 0 while they sleep
+    int itsCascadeRemaining;
+    //! recent audio of the analysis rate, replayed to the detectors when woken
+    QVector<qint16> itsPreRoll;
+    //! write position of the pre-roll ring
+    int itsPreRollPos;
+    //! frames analysed by the detectors and in total, owned by the analysing thread
+    qint64 itsCascadeAwakeFrames;
+    qint64 itsCascadeFrames;
+    //! share of the audio analysed by the detectors, in per mille
+    QAtomicInt itsDutyCycle;
+
+    //! recognizes the sounds the user marked to be ignored, if any
+    Fingerprinter itsFingerprinter;
+    //! number of loud decisions ignored as known sounds
+    QAtomicInt itsIgnoredDecisions;
+
+    //! the thread performing the analysis, if any
+    AnalysisThread *itsAnalysisThread;
+
+    //! queue of captured audio data to analyse
+    AudioRingBuffer itsRingBuffer;
+
+    //! analysis results not yet delivered to the main thread
+    QVector<Result> itsResults;
+    //! protects itsResults
+    QMutex itsResultLock;
+
+    //! number of counter reset requests
+    QAtomicInt itsResetRequest;
+    //! number of counter reset requests already applied by the analysis
+    int itsResetDone;
+    //! requested duration in seconds to learn the noise profile from, 0 if none
+    QAtomicInt itsNoiseRequest;
 };
 
@@ -0,0 +1,184 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "audioringbuffer.h"
+
+#include <string.h>
+
+
+/*!
+  The constructor sets up an empty ring without memory. It needs to be
+  allocated before use.
+*/
+AudioRingBuffer::AudioRingBuffer()
+    : itsHead(0), itsTail(0), itsPeekSize(0), itsOverruns(0),
+      itsDroppedBytes(0)
+{
+}
+
+
+/*!
+  allocate reserves the ring memory of the given size in bytes and empties the
+  ring. It must not be called while producer or consumer are active.
+*/
+void AudioRingBuffer::allocate(int capacity)
+{
+    itsBuffer.fill(0, recordSize(capacity - HEADER_SIZE));
+    itsHead = 0;
+    itsTail = 0;
+    itsPeekSize = 0;
+}
+
+
+/*!
+  capacity returns the size of the ring memory in bytes.
+*/
+int AudioRingBuffer::capacity() const
+{
+    return itsBuffer.size();
+}
+
+
+/*!
+  recordSize returns the ring memory needed for an audio buffer of the given
+  length. Records are aligned to the header size.
+*/
+int AudioRingBuffer::recordSize(int len)
+{
+    return (HEADER_SIZE + len + HEADER_SIZE-1) & ~(HEADER_SIZE-1);
+}
+
+
+/*!
+  write appends a copy of the given audio buffer to the ring. If the record
+  does not fit as a contiguous block, it is dropped and false is returned.
+  A record that does not fit at the end of the memory wraps around to its
+  beginning; the unused end is marked by a wrap marker then.
+  The write position never catches up with the read position, since equal
+  positions denote an empty ring.
+*/
+bool AudioRingBuffer::write(const char *data, int len)
+{
+    char *buffer = itsBuffer.data();
+    int size = itsBuffer.size();
+    int need = recordSize(len);
+    int head = itsHead;
+    int tail = itsTail.fetchAndAddAcquire(0);
+    int pos = -1;
+
+    if (head >= tail) {
+        // free space at the end and, after wrapping, before the read position
+        if ( (head + need < size) || ((head + need == size) && (tail != 0)) )
+            pos = head;
+        else if (need < tail)
+            pos = 0;
+    }
+    else {
+        // free space between write and read position
+        if (head + need < tail)
+            pos = head;
+    }
+
+    if (pos < 0) {
+        // the consumer falls behind, drop the data
+        itsOverruns.ref();
+        itsDroppedBytes.fetchAndAddRelaxed(len);
+        return false;
+    }
+
+    // mark the unused end of the memory
+    if (pos != head) {
+        qint32 marker = WRAP_MARKER;
+        memcpy(buffer + head, &marker, HEADER_SIZE);
+    }
+
+    // store record
+    qint32 recordLen = len;
+    memcpy(buffer + pos, &recordLen, HEADER_SIZE);
+    memcpy(buffer + pos + HEADER_SIZE, data, len);
+
+    // publish it
+    head = pos + need;
+    if (head == size)
+        head = 0;
+    itsHead.fetchAndStoreRelease(head);
+
+    return true;
+}
+
+
+/*!
+  peek returns the oldest record of the ring and stores its length in len. It
+  returns 0 if the ring is empty. The record stays valid until release gets
+  called.
+*/
+const char *AudioRingBuffer::peek(int *len)
+{
+    const char *buffer = itsBuffer.constData();
+    int head = itsHead.fetchAndAddAcquire(0);
+    int tail = itsTail;
+
+    if (tail == head)
+        return 0;
+
+    qint32 recordLen;
+    memcpy(&recordLen, buffer + tail, HEADER_SIZE);
+
+    // skip the unused end of the memory
+    if (recordLen == WRAP_MARKER) {
+        tail = 0;
+        itsTail.fetchAndStoreRelease(tail);
+        memcpy(&recordLen, buffer, HEADER_SIZE);
+    }
+
+    itsPeekSize = recordSize(recordLen);
+    *len = recordLen;
+    return buffer + tail + HEADER_SIZE;
+}
+
+
+/*!
+  release frees the record returned by the last peek call.
+*/
+void AudioRingBuffer::release()
+{
+    int tail = itsTail + itsPeekSize;
+    if (tail == itsBuffer.size())
+        tail = 0;
+
+    itsPeekSize = 0;
+    itsTail.fetchAndStoreRelease(tail);
+}
+
+
+/*!
+  overruns returns the number of records dropped since the ring is full.
+*/
+int AudioRingBuffer::overruns() const
+{
+    return itsOverruns;
+}
+
+
+/*!
+  droppedBytes returns the number of audio bytes dropped since the ring is
+  full.
+*/
+int AudioRingBuffer::droppedBytes() const
+{
+    return itsDroppedBytes;
+}
@@ -0,0 +1,78 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <QByteArray>
+#include <QAtomicInt>
+
+
+/*!
+  AudioRingBuffer is a lock-free single producer, single consumer queue of
+  audio buffers. The memory is allocated once and each written buffer is kept
+  as one contiguous record, such that the consumer can process it in place
+  without copying.
+
+  The producer (the audio capture) writes records by write(). The consumer
+  (the analysis thread) accesses the oldest record by peek() and frees it by
+  release(). If the consumer falls behind and a record does not fit anymore, it
+  gets dropped and the overrun counters are incremented.
+*/
+class AudioRingBuffer
+{
+public:
+    AudioRingBuffer();
+
+    void allocate(int capacity);
+    int capacity() const;
+
+    // producer interface
+    bool write(const char *data, int len);
+
+    // consumer interface
+    const char *peek(int *len);
+    void release();
+
+    int overruns() const;
+    int droppedBytes() const;
+
+private:
+    static int recordSize(int len);
+
+private:
+    const static int HEADER_SIZE = 4;
+    const static qint32 WRAP_MARKER = -1;
+
+    //! the record memory
+    QByteArray itsBuffer;
+
+    //! write position, owned by the producer
+    QAtomicInt itsHead;
+    //! read position, owned by the consumer
+    QAtomicInt itsTail;
+
+    //! size of the record returned by peek
+    int itsPeekSize;
+
+    //! number of dropped records
+    QAtomicInt itsOverruns;
+    //! number of dropped audio bytes
+    QAtomicInt itsDroppedBytes;
+};
+
+#endif // AUDIORINGBUFFER_H
@@ -0,0 +1,49 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "audiotrigger.h"
+
+
+/*!
+  The constructor stores the reference to the application settings.
+*/
+AudioTrigger::AudioTrigger(const Settings *settings)
+    : itsSettings(settings)
+{
+}
+
+
+/*!
+  isTriggered returns true if the audio counter exceeds the notification
+  threshold.
+*/
+bool AudioTrigger::isTriggered(int counter) const
+{
+    return counter > itsSettings->THRESHOLD_VALUE;
+}
+
+
+/*!
+  volumeThreshold returns the volume above which the audio counter increases,
+  given the noise floor of the room. It keeps a margin to the noise floor, such
+  that steady background noise like fans does not count. In quiet rooms, the
+  fixed threshold applies.
+*/
+int AudioTrigger::volumeThreshold(int floor) const
+{
+    return qMax(itsSettings->THRESHOLD_VALUE, floor + itsSettings->NOISE_FLOOR_MARGIN);
+}
@@ -0,0 +1,44 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef AUDIOTRIGGER_H
+#define AUDIOTRIGGER_H
+
+#include "settings.h"
+
+
+/*!
+  AudioTrigger performs the threshold check of the audio duration counter
+  reported by AudioMonitor. It decides whether the parents have to be notified.
+
+  The check is kept separate from Babyphone such that the offline replay tool
+  uses the very same decision logic as the application.
+*/
+class AudioTrigger
+{
+public:
+    explicit AudioTrigger(const Settings *settings);
+
+    bool isTriggered(int counter) const;
+    int volumeThreshold(int floor) const;
+
+private:
+    //! reference to global application settings
+    const Settings * const itsSettings;
+};
+
+#endif // AUDIOTRIGGER_H
@@ -0,0 +1,93 @@
+# babyphone - A baby monitor application for Maemo/MeeGo (Nokia N900, N950, N9).
+#     Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+#
+#     This program is free software: you can redistribute it and/or modify
+#     it under the terms of the GNU General Public License as published by
+#     the Free Software Foundation, either version 3 of the License, or
+#     (at your option) any later version.
+#
+#     This program is distributed in the hope that it will be useful,
+#     but WITHOUT ANY WARRANTY; without even the implied warranty of
+#     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#     GNU General Public License for more details.
+#
+#     You should have received a copy of the GNU General Public License
+#     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# The audio analysis core of babyphone, shared by the application and the
+# offline replay tool. Include it by "include(babyphone-core.pri)".
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+# all supported ARM devices (N900, N950, N9) provide NEON
+contains(QT_ARCH, arm) {
+  QMAKE_CXXFLAGS += -mfpu=neon
+}
+
+# integer-only volume computation for CPUs with a weak FPU, enable it by
+# "qmake CONFIG+=fixedpoint"
+fixedpoint {
+  DEFINES += BABYPHONE_FIXED_POINT
+}
+
+
+SOURCES += \
+    $$PWD/audiomonitor.cpp \
+    $$PWD/audioringbuffer.cpp \
+    $$PWD/analysisthread.cpp \
+    $$PWD/audiotrigger.cpp \
+    $$PWD/levelkernel.cpp \
+    $$PWD/formatkernel.cpp \
+    $$PWD/decimator.cpp \
+    $$PWD/biquadchain.cpp \
+    $$PWD/noisefloor.cpp \
+    $$PWD/volumescale.cpp \
+    $$PWD/slidingwindow.cpp \
+    $$PWD/imaadpcm.cpp \
+    $$PWD/audiohistory.cpp \
+    $$PWD/wavwriter.cpp \
+    $$PWD/eventrecorder.cpp \
+    $$PWD/levelstore.cpp \
+    $$PWD/spectraldetector.cpp \
+    $$PWD/noisesuppressor.cpp \
+    $$PWD/goertzelbank.cpp \
+    $$PWD/pitchdetector.cpp \
+    $$PWD/mfccextractor.cpp \
+    $$PWD/cryclassifier.cpp \
+    $$PWD/dspgraph.cpp \
+    $$PWD/taskpool.cpp \
+    $$PWD/fingerprintindex.cpp \
+    $$PWD/fingerprinter.cpp \
+    $$PWD/settings.cpp \
+    $$PWD/contact.cpp
+
+HEADERS += \
+    $$PWD/audiomonitor.h \
+    $$PWD/audioringbuffer.h \
+    $$PWD/analysisthread.h \
+    $$PWD/audiotrigger.h \
+    $$PWD/levelkernel.h \
+    $$PWD/formatkernel.h \
+    $$PWD/decimator.h \
+    $$PWD/biquadchain.h \
+    $$PWD/noisefloor.h \
+    $$PWD/volumescale.h \
+    $$PWD/slidingwindow.h \
+    $$PWD/imaadpcm.h \
+    $$PWD/audiohistory.h \
+    $$PWD/wavwriter.h \
+    $$PWD/eventrecorder.h \
+    $$PWD/levelstore.h \
+    $$PWD/spectraldetector.h \
+    $$PWD/noisesuppressor.h \
+    $$PWD/goertzelbank.h \
+    $$PWD/pitchdetector.h \
+    $$PWD/mfccextractor.h \
+    $$PWD/cryclassifier.h \
+    $$PWD/dspgraph.h \
+    $$PWD/taskpool.h \
+    $$PWD/fingerprintindex.h \
+    $$PWD/fingerprinter.h \
+    $$PWD/settings.h \
+    $$PWD/contact.h
@@ -17,15 +17,18 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
 */
 #include "babyphone.h"
 #include <QDebug>
+#include <QDir>
+#include <QDateTime>
+#include <QRegExp>
 
 
 /*!
   the constructor instantiates the main subclasses for the functionality, i.e.
-  the audio monitor, the call monitor and the user notifier. Afterwards it
+  the audio monitors, the call monitor and the user notifier. Afterwards it
   starts audio capturing.
 */
 Babyphone::Babyphone(const Settings *settings, QObject *parent) :
-    QObject(parent), itsSettings(settings)
+    QObject(parent), itsSettings(settings), itsAudioTrigger(settings)
 {
     // setup profile switcher
     itsProfileSwitcher = new ProfileSwitcher(itsSettings, this);
@@ -34,9 +37,16 @@ Babyphone::Babyphone(const Settings *settings, QObject *parent) :
     itsState = STATE_OFF;
     itsNotificationPending = false;
 
-    // setup audio monitor
-    itsAudioMonitor = new AudioMonitor(itsSettings, this);
-    connect(itsAudioMonitor, SIGNAL(update(int, int)), this, SLOT(refreshAudioData(int, int)));
+    // setup audio monitors
+    setupAudio();
+
+    // setup event recorder
+    itsEventRecorder = new EventRecorder(this);
+    itsEventRecorder->start(QThread::LowPriority);
+
+    // setup level series
+    if (!itsSettings->itsLevelStoreFile.isEmpty())
+        itsLevelStore.open(itsSettings->itsLevelStoreFile);
 
     // setup call monitor
     itsCallMonitor = new CallMonitor(itsSettings, this);
@@ -56,9 +66,95 @@ Babyphone::Babyphone(const Settings *settings, QObject *parent) :
 }
 
 
+/*!
+  setupAudio creates an audio monitor for each configured audio input device,
+  or for the default device if none is configured. The audio analysis is spread
+  over a pool of analysis threads, sized to the number of CPU cores. The cores
+  left over run the detectors of a room in parallel. The monitors share the
+  index of the sounds to be ignored.
+*/
+void Babyphone::setupAudio()
+{
+    QList<QAudioDeviceInfo> devices;
+    if (itsSettings->itsAudioDevices.isEmpty()) {
+        devices.append(QAudioDeviceInfo::defaultInputDevice());
+    }
+    else {
+        QList<QAudioDeviceInfo> available = QAudioDeviceInfo::availableDevices(QAudio::AudioInput);
+        foreach (const QString &name, itsSettings->itsAudioDevices) {
+            int i;
+            for (i = 0; i < available.size(); ++i) {
+                if (available.at(i).deviceName() == name) {
+                    devices.append(available.at(i));
+                    break;
+                }
+            }
+            if (i == available.size())
+                qWarning() << "Audio input device not found:" << name;
+        }
+
+        if (devices.isEmpty()) {
+            qWarning() << "No configured audio input device found, using default device";
+            devices.append(QAudioDeviceInfo::defaultInputDevice());
+        }
+    }
+
+    // setup audio monitors
+    foreach (const QAudioDeviceInfo &device, devices) {
+        AudioMonitor *monitor = new AudioMonitor(itsSettings, device, this);
+        if (!monitor->isValid()) {
+            // a room we cannot analyse would only block the audio start
+            qWarning() << "Skipping audio input device" << monitor->name();
+            delete monitor;
+            continue;
+        }
+        connect(monitor, SIGNAL(update(int, int, int, int)),
+                this, SLOT(refreshAudioData(int, int, int, int)));
+        itsAudioMonitors.append(monitor);
+    }
+    if (itsAudioMonitors.isEmpty())
+        qCritical() << "No audio input device with supported format found";
+    itsRoomCounter.fill(0, itsAudioMonitors.size());
+    itsRoomValue.fill(0, itsAudioMonitors.size());
+    itsRoomFloor.fill(0, itsAudioMonitors.size());
+    itsRoomProbability.fill(-1, itsAudioMonitors.size());
+    itsPublishTime = 0;
+
+    // setup audio analysis threads
+    // they are created after the monitors to get destroyed after them, too
+    int threads = qBound(1, QThread::idealThreadCount(), itsAudioMonitors.size());
+    for (int i = 0; i < threads; ++i) {
+        AnalysisThread *thread = new AnalysisThread(this);
+        itsAnalysisThreads.append(thread);
+        thread->start(QThread::HighPriority);
+    }
+    for (int i = 0; i < itsAudioMonitors.size(); ++i)
+        itsAudioMonitors.at(i)->setAnalysisThread(itsAnalysisThreads.at(i % threads));
+
+    // the remaining cores run the detectors of the monitors in parallel
+    // the pool is created after the monitors to get destroyed after them, too
+    int workers = qMax(0, QThread::idealThreadCount() - threads);
+    itsTaskPool = new TaskPool(workers, this);
+    foreach (AudioMonitor *monitor, itsAudioMonitors)
+        monitor->setTaskPool(itsTaskPool);
+
+    // the index is created after the monitors to get destroyed after them, too
+    itsFingerprintIndex = new FingerprintIndex(itsSettings->AUDIO_ANALYSIS_RATE, this);
+    if (!itsSettings->itsIgnoredSoundsFile.isEmpty()) {
+        itsFingerprintIndex->load(itsSettings->itsIgnoredSoundsFile);
+        foreach (AudioMonitor *monitor, itsAudioMonitors)
+            monitor->setFingerprintIndex(itsFingerprintIndex);
+    }
+
+    qDebug() << "Monitoring" << itsAudioMonitors.size() << "rooms using"
+             << threads << "analysis threads and" << workers << "detector threads";
+}
+
+
 /*!
   setState switches the application state of babyphone.
-  On enabling, it clears the statistics counters.
+  On enabling, it clears the statistics counters and the audio monitors learn
+  the background noise during the activation delay.
 */
 void Babyphone::setState(State state)
 {
@@ -71,6 +167,11 @@ void Babyphone::setState(State state)
         itsUserNotifier->itsCallCounterInvoke = 0;
         itsUserNotifier->itsCallCounterTaken = 0;
         itsUserNotifier->itsCallCounterTimeout = 0;
+
+        if (state == STATE_WAITING) {
+            foreach (AudioMonitor *monitor, itsAudioMonitors)
+                monitor->learnNoise(itsSettings->itsActivationDelay);
+        }
     }
 
     qDebug() << "New application state:" << (state == STATE_OFF ? "off" :
@@ -98,18 +199,109 @@ QString Babyphone::getStatistics() const
         text = tr("No notifications took place.");
     }
 
+    // report the triggering room, if there are several
+    if ( (itsAudioMonitors.size() > 1) && (!itsTriggerRoom.isEmpty()) )
+        text += tr("\nLast notification by: %1").arg(itsTriggerRoom);
+
+    // report lost audio data
+    int overruns = 0;
+    foreach (AudioMonitor *monitor, itsAudioMonitors)
+        overruns += monitor->overruns();
+    if (overruns > 0)
+        text += tr("\nAudio analysis overruns: %1").arg(overruns);
+
+    // report the share of audio the cascade woke the detectors for
+    if ( (itsSettings->itsCascadeWindow > 0) && (!itsAudioMonitors.isEmpty()) ) {
+        int dutyCycle = 0;
+        foreach (AudioMonitor *monitor, itsAudioMonitors)
+            dutyCycle += monitor->dutyCycle();
+        dutyCycle /= itsAudioMonitors.size();
+        text += tr("\nDetector duty cycle: %1%").arg(dutyCycle / 10.0, 0, 'f', 1);
+    }
+
+    // report the loud audio ignored as known sounds
+    int ignored = 0;
+    foreach (AudioMonitor *monitor, itsAudioMonitors)
+        ignored += monitor->ignoredDecisions();
+    if (itsFingerprintIndex->sounds() > 0)
+        text += tr("\nIgnored sounds: %1, recognized %2 times")
+                .arg(itsFingerprintIndex->sounds()).arg(ignored);
+
+    // report the detector latency and agreement of each room
+    foreach (AudioMonitor *monitor, itsAudioMonitors) {
+        QString statistics = monitor->detectorStatistics();
+        if (statistics.isEmpty())
+            continue;
+        if (itsAudioMonitors.size() > 1)
+            text += "\n" + monitor->name() + ":";
+        text += "\n" + statistics;
+    }
+
     return text;
 }
 
 
 /*!
-  startAudio starts audio capturing. In case of failures it starts a retry
-  timer.
+  getTriggerRoom returns the name of the room which caused the last
+  notification.
+*/
+QString Babyphone::getTriggerRoom() const
+{
+    return itsTriggerRoom;
+}
+
+
+/*!
+  getVolumeThreshold returns the volume threshold of a room with the given
+  noise floor.
+*/
+int Babyphone::getVolumeThreshold(int floor) const
+{
+    return itsAudioTrigger.volumeThreshold(floor);
+}
+
+
+/*!
+  getLevelStore returns the persistent series of the audio levels.
+*/
+const LevelStore *Babyphone::getLevelStore() const
+{
+    return &itsLevelStore;
+}
+
+
+/*!
+  ignoreLastNotification adds the sound which caused the last notification to
+  the sounds to be ignored and saves them. From now on, the sound does not
+  count anymore. It returns false if there is no notification sound or on
+  errors.
+*/
+bool Babyphone::ignoreLastNotification()
+{
+    if (itsTriggerFingerprint.isEmpty())
+        return false;
+
+    if (itsFingerprintIndex->addSound(itsTriggerFingerprint) < 0)
+        return false;
+    itsTriggerFingerprint.clear();
+
+    return itsFingerprintIndex->save(itsSettings->itsIgnoredSoundsFile);
+}
+
+
+/*!
+  startAudio starts audio capturing of all rooms. In case of failures it starts
+  a retry timer.
 */
 void Babyphone::startAudio()
 {
     qDebug() << "Start audio capturing";
-    bool success = itsAudioMonitor->start();
+    bool success = true;
+    foreach (AudioMonitor *monitor, itsAudioMonitors) {
+        // on retries, only start the failed ones
+        if ( (!monitor->itsActive) && (!monitor->start()) )
+            success = false;
+    }
 
     if (success == false) {
         qWarning() << "starting of audio failed, retrying later";
@@ -125,32 +317,72 @@ void Babyphone::stopAudio()
 {
     // suspend audio monitoring
     qDebug() << "Stop audio capturing";
-    itsAudioMonitor->stop();
+    foreach (AudioMonitor *monitor, itsAudioMonitors)
+        monitor->stop();
 }
 
 
 /*!
-  refreshAudioData periodically receives the audio samples from the AudioMonitor,
-  and performs the threshold check to initiate a phone call if needed.
+  refreshAudioData periodically receives the audio samples from the
+  AudioMonitors, and performs the threshold check of the sending room to
+  initiate a phone call if needed.
+  The GUI gets the loudest values of all rooms, together with the noise floor
+  and the cry probability of the loudest room. They are published on the update
+  of any room, but about once per result period of a room only, such that a
+  room which fails to capture does not stop them. The counter and the volume
+  are stored in the level series, too.
 */
-void Babyphone::refreshAudioData(int counter, int value)
+void Babyphone::refreshAudioData(int counter, int value, int floor, int probability)
 {
-    // update GUI
-    emit newAudioData(counter, value);
+    AudioMonitor *monitor = qobject_cast<AudioMonitor*>(sender());
+    int room = itsAudioMonitors.indexOf(monitor);
+    if (room < 0)
+        return;
+
+    itsRoomCounter[room] = counter;
+    itsRoomValue[room] = value;
+    itsRoomFloor[room] = floor;
+    itsRoomProbability[room] = probability;
+
+    // update GUI, some slack keeps the pace if the rooms report out of phase
+    int period = (itsSettings->itsAudioWindow > 0) ? itsSettings->itsAudioHop
+                                                   : itsSettings->AUDIO_SAMPLE_INTERVAL;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - itsPublishTime >= period * 3 / 4) {
+        itsPublishTime = now;
+        int maxCounter = 0;
+        int loudest = 0;
+        for (int i = 0; i < itsAudioMonitors.size(); ++i) {
+            maxCounter = qMax(maxCounter, itsRoomCounter.at(i));
+            if (itsRoomValue.at(i) > itsRoomValue.at(loudest))
+                loudest = i;
+        }
+        itsLevelStore.append(now, maxCounter, itsRoomValue.at(loudest));
+        emit newAudioData(maxCounter, itsRoomValue.at(loudest), itsRoomFloor.at(loudest),
+                          itsRoomProbability.at(loudest));
+    }
 
     // check for noise
     if ( (itsState == STATE_ON) &&
-         (counter > itsSettings->THRESHOLD_VALUE) &&
+         (itsAudioTrigger.isTriggered(counter)) &&
          (!itsCallMonitor->itsCallPending) &&
          (!itsNotificationPending) )
     {
-        qDebug() << "Audio threshold reached. Notifying user.";
+        qDebug() << "Audio threshold reached in room" << monitor->name()
+                 << ". Notifying user.";
+        itsTriggerRoom = monitor->name();
 
-        // reset audio monitor warning
-        itsAudioMonitor->itsCounter = 0;
+        // keep the audio that led to the notification
+        recordEvent(monitor);
+        // and its landmarks, in case the user marks the sound to be ignored
+        itsTriggerFingerprint = monitor->fingerprint();
+
+        // reset audio monitor warnings of all rooms
+        foreach (AudioMonitor *roomMonitor, itsAudioMonitors)
+            roomMonitor->resetCounter();
 
         // notify user
-        if (itsUserNotifier->Notify() == true) {
+        if (itsUserNotifier->Notify(itsTriggerRoom) == true) {
             // store event
             itsNotificationPending = true;
 
@@ -170,6 +402,38 @@ void Babyphone::refreshAudioData(int counter, int value)
 }
 
 
+/*!
+  recordEvent stores the audio history of the given room as event clip, named
+  by the room and the current time. The peak volume and the maximum audio
+  counter of the history are listed in the clip index. The clip is written and
+  the disk quota is enforced by the recorder thread, the audio capturing
+  continues meanwhile.
+*/
+void Babyphone::recordEvent(const AudioMonitor *monitor)
+{
+    QByteArray blocks;
+    int rate, peak, counter;
+    if ( (itsSettings->itsClipQuota <= 0) ||
+         !monitor->copyHistory(&blocks, &rate, &peak, &counter) )
+        return;
+
+    QDir directory(itsSettings->itsClipDirectory);
+    if (!directory.mkpath(".")) {
+        qWarning() << "Cannot create clip directory" << itsSettings->itsClipDirectory;
+        return;
+    }
+
+    // device names may contain characters not allowed in file names
+    QString room = monitor->name();
+    room.replace(QRegExp("[^A-Za-z0-9_-]"), "_");
+    QString fileName = directory.filePath(QString("babyphone-%1-%2.wav")
+            .arg(room, QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+
+    itsEventRecorder->record(fileName, rate, blocks, peak, counter,
+                             (qint64)itsSettings->itsClipQuota * 1024 * 1024);
+}
+
+
 /*!
   callReceived handles incoming phone calls.
 */
@@ -257,8 +521,9 @@ void Babyphone::phoneAppTimeout()
     // notifcation finished
     itsNotificationPending = false;
 
-    // reset audio monitor warning
-    itsAudioMonitor->itsCounter = 0;
+    // reset audio monitor warnings
+    foreach (AudioMonitor *monitor, itsAudioMonitors)
+        monitor->resetCounter();
 
     // restart audio monitoring
     startAudio();
@@ -19,7 +19,15 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
 #define BABYPHONE_H
 
 #include <QObject>
+#include <QList>
+#include <QVector>
 #include "audiomonitor.h"
+#include "audiotrigger.h"
+#include "analysisthread.h"
+#include "taskpool.h"
+#include "fingerprintindex.h"
+#include "eventrecorder.h"
+#include "levelstore.h"
 #include "callmonitor.h"
 #include "usernotifier.h"
 #include "profileswitcher.h"
@@ -42,15 +50,23 @@ public:
     explicit Babyphone(const Settings *settings, QObject *parent = 0);
     void setState(State state);
     QString getStatistics() const;
+    QString getTriggerRoom() const;
+    int getVolumeThreshold(int floor) const;
+    const LevelStore *getLevelStore() const;
+    bool ignoreLastNotification();
 
 signals:
-    void newAudioData(int counter, int value);
+    void newAudioData(int counter, int value, int floor, int probability);
     void phoneApplicationFinished();
     void notificationError();
     void newCallStatus(bool finish, bool selfInitiated);
 
+private:
+    void setupAudio();
+    void recordEvent(const AudioMonitor *monitor);
+
 private slots:
-    void refreshAudioData(int counter, int value);
+    void refreshAudioData(int counter, int value, int floor, int probability);
     void startAudio();
     void stopAudio();
 
@@ -68,8 +84,42 @@ private:
     //! reference to global application settings
     const Settings * const itsSettings;
 
-    //! the audio monitor functionality
-    AudioMonitor *itsAudioMonitor;
+    //! the audio monitors, one per monitored room
+    QList<AudioMonitor*> itsAudioMonitors;
+
+    //! the threads performing the audio analysis, shared by all rooms
+    QList<AnalysisThread*> itsAnalysisThreads;
+
+    //! worker threads running the detectors of the audio monitors in parallel
+    TaskPool *itsTaskPool;
+
+    //! the sounds the user marked to be ignored, shared by the audio monitors
+    FingerprintIndex *itsFingerprintIndex;
+
+    //! latest audio counter of each room
+    QVector<int> itsRoomCounter;
+    //! latest audio volume of each room
+    QVector<int> itsRoomValue;
+    //! latest noise floor of each room
+    QVector<int> itsRoomFloor;
+    //! latest cry probability of each room, -1 without classifier
+    QVector<int> itsRoomProbability;
+    //! time the room values were last published, in ms since the epoch
+    qint64 itsPublishTime;
+
+    //! the room which caused the last notification
+    QString itsTriggerRoom;
+    //! the landmarks of the audio which caused the last notification
+    QVector<Landmark> itsTriggerFingerprint;
+
+    //! the recorder of the notification events
+    EventRecorder *itsEventRecorder;
+
+    //! the persistent series of the audio levels shown by the GUI
+    LevelStore itsLevelStore;
+
+    //! the threshold check of the audio counter
+    AudioTrigger itsAudioTrigger;
 
     //! the monitor checking incoming call and call status
     CallMonitor *itsCallMonitor;
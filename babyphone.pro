@@ -33,14 +33,15 @@ else {
 }
 
 
+# the audio analysis core, shared with the replay tool
+include(babyphone-core.pri)
+
+
 SOURCES += \
     main.cpp\
     usernotifier.cpp \
-    audiomonitor.cpp \
-    settings.cpp \
     callmonitor.cpp \
     profileswitcher.cpp \
-    contact.cpp \
     babyphone.cpp
 
 maemo5 {
@@ -53,17 +54,16 @@ maemo5 {
 else {
   SOURCES += \
       harmattan/mainwindow.cpp \
-      harmattan/audiolevelgraph.cpp
+      harmattan/audiolevelgraph.cpp \
+      harmattan/levelpyramid.cpp \
+      harmattan/enginemodel.cpp
 }
 
 
 HEADERS  += \
     usernotifier.h \
-    audiomonitor.h \
-    settings.h \
     callmonitor.h \
     profileswitcher.h \
-    contact.h \
     babyphone.h
 
 maemo5 {
@@ -76,7 +76,9 @@ maemo5 {
 else {
   HEADERS += \
       harmattan/mainwindow.h \
-      harmattan/audiolevelgraph.h
+      harmattan/audiolevelgraph.h \
+      harmattan/levelpyramid.h \
+      harmattan/enginemodel.h
 }
 
 
@@ -112,6 +114,19 @@ OTHER_FILES += \
     harmattan/AboutPage.qml
 
 
+# offline replay tool, build it by "make babyphone-replay"
+replay.target = babyphone-replay
+replay.commands = $(MKDIR) replay && cd replay && \
+                  $(QMAKE) $$PWD/replay/replay.pro && $(MAKE)
+QMAKE_EXTRA_TARGETS += replay
+
+# benchmark of the audio level graph, build it by "make babyphone-bench"
+bench.target = babyphone-bench
+bench.commands = $(MKDIR) bench && cd bench && \
+                 $(QMAKE) $$PWD/harmattan/bench/bench.pro && $(MAKE)
+QMAKE_EXTRA_TARGETS += bench
+
+
 # address book selector
 maemo5 {
   CONFIG += link_pkgconfig
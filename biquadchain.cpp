@@ -0,0 +1,402 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "biquadchain.h"
+
+#include <QDebug>
+#include <cmath>
+#include <complex>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// determine the SIMD instruction set we can build
+#if defined(__SSE2__) || defined(__x86_64__)
+  #define BIQUADCHAIN_SSE2
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define BIQUADCHAIN_NEON
+  #include <arm_neon.h>
+#endif
+
+
+// pole frequencies of the A-weighting curve in Hz, IEC 61672
+static const double A_WEIGHTING_POLE1 = 20.598997;
+static const double A_WEIGHTING_POLE2 = 107.65265;
+static const double A_WEIGHTING_POLE3 = 737.86223;
+static const double A_WEIGHTING_POLE4 = 12194.217;
+
+
+#if defined(BIQUADCHAIN_SSE2)
+/*!
+  toFloat converts S16 samples to float, a multiple of four.
+*/
+static void toFloat(const qint16 *data, int count, float *result)
+{
+    for (int i = 0; i < count; i += 4) {
+        __m128i x = _mm_loadl_epi64((const __m128i*)(data + i));
+        x = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        _mm_storeu_ps(result + i, _mm_cvtepi32_ps(x));
+    }
+}
+
+
+/*!
+  fromFloat rounds float samples to S16, clipped to its range, a multiple of
+  four.
+*/
+static void fromFloat(const float *data, int count, qint16 *result)
+{
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+    for (int i = 0; i < count; i += 4) {
+        __m128 y = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(data + i), low), high);
+        __m128i x = _mm_cvtps_epi32(y);
+        _mm_storel_epi64((__m128i*)(result + i), _mm_packs_epi32(x, x));
+    }
+}
+
+
+/*!
+  runSection filters the given blocks of samples in place by one section, given
+  its block coefficients and state.
+*/
+static void runSection(float *samples, int blocks, const float *c,
+                       float *state1, float *state2)
+{
+    const __m128 h0 = _mm_loadu_ps(c);
+    const __m128 h1 = _mm_loadu_ps(c + 4);
+    const __m128 h2 = _mm_loadu_ps(c + 8);
+    const __m128 h3 = _mm_loadu_ps(c + 12);
+    const __m128 p1 = _mm_loadu_ps(c + 16);
+    const __m128 p2 = _mm_loadu_ps(c + 20);
+    const __m128 g0 = _mm_loadu_ps(c + 24);
+    const __m128 g1 = _mm_loadu_ps(c + 28);
+    const __m128 g2 = _mm_loadu_ps(c + 32);
+    const __m128 g3 = _mm_loadu_ps(c + 36);
+    const __m128 q1 = _mm_loadu_ps(c + 40);
+    const __m128 q2 = _mm_loadu_ps(c + 44);
+
+    // the state variables in the lower two lanes
+    __m128 s = _mm_setr_ps(*state1, *state2, 0, 0);
+    for (int b = 0; b < blocks; ++b, samples += 4) {
+        __m128 x = _mm_loadu_ps(samples);
+        __m128 x0 = _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 x1 = _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 x2 = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 2, 2));
+        __m128 x3 = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128 s1 = _mm_shuffle_ps(s, s, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 s2 = _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1));
+
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(h0, x0), _mm_mul_ps(h1, x1)),
+                              _mm_add_ps(_mm_mul_ps(h2, x2), _mm_mul_ps(h3, x3)));
+        __m128 u = _mm_add_ps(_mm_add_ps(_mm_mul_ps(g0, x0), _mm_mul_ps(g1, x1)),
+                              _mm_add_ps(_mm_mul_ps(g2, x2), _mm_mul_ps(g3, x3)));
+        y = _mm_add_ps(y, _mm_add_ps(_mm_mul_ps(p1, s1), _mm_mul_ps(p2, s2)));
+        _mm_storeu_ps(samples, y);
+        s = _mm_add_ps(_mm_add_ps(u, _mm_mul_ps(q1, s1)), _mm_mul_ps(q2, s2));
+    }
+
+    *state1 = _mm_cvtss_f32(s);
+    *state2 = _mm_cvtss_f32(_mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+}
+#elif defined(BIQUADCHAIN_NEON)
+/*!
+  toFloat converts S16 samples to float, a multiple of four.
+*/
+static void toFloat(const qint16 *data, int count, float *result)
+{
+    for (int i = 0; i < count; i += 4)
+        vst1q_f32(result + i, vcvtq_f32_s32(vmovl_s16(vld1_s16(data + i))));
+}
+
+
+/*!
+  fromFloat rounds float samples to S16, clipped to its range, a multiple of
+  four. The conversion truncates, so half is added with the sign of the sample
+  first.
+*/
+static void fromFloat(const float *data, int count, qint16 *result)
+{
+    const uint32x4_t sign = vdupq_n_u32(0x80000000);
+    const uint32x4_t half = vreinterpretq_u32_f32(vdupq_n_f32(0.5f));
+    for (int i = 0; i < count; i += 4) {
+        float32x4_t y = vld1q_f32(data + i);
+        uint32x4_t round = vorrq_u32(vandq_u32(vreinterpretq_u32_f32(y), sign), half);
+        int32x4_t x = vcvtq_s32_f32(vaddq_f32(y, vreinterpretq_f32_u32(round)));
+        vst1_s16(result + i, vqmovn_s32(x));
+    }
+}
+
+
+/*!
+  runSection filters the given blocks of samples in place by one section, given
+  its block coefficients and state.
+*/
+static void runSection(float *samples, int blocks, const float *c,
+                       float *state1, float *state2)
+{
+    const float32x4_t h0 = vld1q_f32(c);
+    const float32x4_t h1 = vld1q_f32(c + 4);
+    const float32x4_t h2 = vld1q_f32(c + 8);
+    const float32x4_t h3 = vld1q_f32(c + 12);
+    const float32x4_t p1 = vld1q_f32(c + 16);
+    const float32x4_t p2 = vld1q_f32(c + 20);
+    // the next state only uses the lower two lanes
+    const float32x2_t g0 = vld1_f32(c + 24);
+    const float32x2_t g1 = vld1_f32(c + 28);
+    const float32x2_t g2 = vld1_f32(c + 32);
+    const float32x2_t g3 = vld1_f32(c + 36);
+    const float32x2_t q1 = vld1_f32(c + 40);
+    const float32x2_t q2 = vld1_f32(c + 44);
+
+    float32x2_t s = vset_lane_f32(*state2, vdup_n_f32(*state1), 1);
+    for (int b = 0; b < blocks; ++b, samples += 4) {
+        float32x4_t x = vld1q_f32(samples);
+        float32x2_t x01 = vget_low_f32(x);
+        float32x2_t x23 = vget_high_f32(x);
+
+        float32x4_t y = vmulq_lane_f32(h0, x01, 0);
+        y = vmlaq_lane_f32(y, h1, x01, 1);
+        y = vmlaq_lane_f32(y, h2, x23, 0);
+        y = vmlaq_lane_f32(y, h3, x23, 1);
+        y = vmlaq_lane_f32(y, p1, s, 0);
+        y = vmlaq_lane_f32(y, p2, s, 1);
+        vst1q_f32(samples, y);
+
+        float32x2_t u = vmul_lane_f32(g0, x01, 0);
+        u = vmla_lane_f32(u, g1, x01, 1);
+        u = vmla_lane_f32(u, g2, x23, 0);
+        u = vmla_lane_f32(u, g3, x23, 1);
+        u = vmla_lane_f32(u, q1, s, 0);
+        s = vmla_lane_f32(u, q2, s, 1);
+    }
+
+    *state1 = vget_lane_f32(s, 0);
+    *state2 = vget_lane_f32(s, 1);
+}
+#endif
+
+
+/*!
+  The constructor sets up a disabled filter chain.
+*/
+BiquadChain::BiquadChain()
+    : itsRate(0), itsSections(0)
+{
+    reset();
+}
+
+
+/*!
+  setup computes the filter coefficients for the given sample rate: the DC
+  blocker, a high pass of the given cutoff frequency in Hz, if not 0, and the
+  A-weighting. The high pass removes DC as well, so it replaces the DC
+  blocker. The high frequency poles of the A-weighting are omitted unless they
+  are below a quarter of the sample rate, otherwise the bilinear transform
+  distorts them more than omitting them. Without any of these, the filter chain
+  is disabled.
+*/
+void BiquadChain::setup(int rate, bool dcBlock, int highPass, bool aWeighting)
+{
+    itsRate = rate;
+    itsSections = 0;
+
+    if (rate > 0) {
+        if ( (highPass > 0) && (2*highPass >= rate) ) {
+            qWarning() << "Ignoring high pass frequency" << highPass << "Hz";
+            highPass = 0;
+        }
+
+        if (highPass > 0) {
+            // Butterworth, prewarped for the exact cutoff frequency
+            double w = 2 * rate * tan(M_PI * highPass / rate);
+            addAnalog(1, 0, 0, 1, sqrt(2.0) * w, w*w);
+        }
+        else if (dcBlock) {
+            double w = 2 * M_PI * DC_CUTOFF;
+            addAnalog(1, 0, 0, 1, 2*w, w*w);
+        }
+
+        if ( aWeighting && (rate > 2*1000) ) {
+            int first = itsSections;
+            double w1 = 2 * M_PI * A_WEIGHTING_POLE1;
+            double w2 = 2 * M_PI * A_WEIGHTING_POLE2;
+            double w3 = 2 * M_PI * A_WEIGHTING_POLE3;
+            double w4 = 2 * M_PI * A_WEIGHTING_POLE4;
+            addAnalog(1, 0, 0, 1, 2*w1, w1*w1);
+            addAnalog(1, 0, 0, 1, w2 + w3, w2*w3);
+            if (4*A_WEIGHTING_POLE4 < rate)
+                addAnalog(0, 0, 1, 1, 2*w4, w4*w4);
+
+            // unity gain at 1 kHz
+            double scale = 1 / gain(first, 1000);
+            itsB0[first] *= scale;
+            itsB1[first] *= scale;
+            itsB2[first] *= scale;
+        }
+    }
+
+    for (int s = 0; s < itsSections; ++s)
+        setupBlock(s);
+    reset();
+
+    if (itsSections > 0)
+        qDebug() << "Audio filter of" << itsSections << "sections at" << rate << "Hz";
+}
+
+
+/*!
+  isEnabled returns true if the filter chain has any sections.
+*/
+bool BiquadChain::isEnabled() const
+{
+    return itsSections > 0;
+}
+
+
+/*!
+  sections returns the number of filter sections.
+*/
+int BiquadChain::sections() const
+{
+    return itsSections;
+}
+
+
+/*!
+  reset clears the filter state, as for a new audio stream.
+*/
+void BiquadChain::reset()
+{
+    for (int s = 0; s < MAX_SECTIONS; ++s) {
+        itsState1[s] = 0;
+        itsState2[s] = 0;
+    }
+}
+
+
+/*!
+  process filters the given S16 mono samples in place, in floating point, and
+  clips them to the S16 range. With SIMD support, the complete blocks are
+  filtered section by section in chunks of CHUNK samples, the remaining samples
+  and all samples of scalar builds by the plain recursion.
+*/
+void BiquadChain::process(qint16 *data, int frames)
+{
+    if (itsSections == 0)
+        return;
+
+#if defined(BIQUADCHAIN_SSE2) || defined(BIQUADCHAIN_NEON)
+    float buffer[CHUNK];
+    int blocks = frames / BLOCK;
+    while (blocks > 0) {
+        int n = qMin(blocks, (int)(CHUNK / BLOCK));
+        toFloat(data, n * BLOCK, buffer);
+        for (int s = 0; s < itsSections; ++s)
+            runSection(buffer, n, itsBlock[s], itsState1 + s, itsState2 + s);
+        fromFloat(buffer, n * BLOCK, data);
+
+        data += n * BLOCK;
+        blocks -= n;
+    }
+    frames %= BLOCK;
+#endif
+
+    for (int i = 0; i < frames; ++i) {
+        float x = data[i];
+        for (int s = 0; s < itsSections; ++s) {
+            float y = itsB0[s] * x + itsState1[s];
+            itsState1[s] = itsB1[s] * x + itsState2[s] - itsA1[s] * y;
+            itsState2[s] = itsB2[s] * x - itsA2[s] * y;
+            x = y;
+        }
+        data[i] = (qint16)qBound(-32768, qRound(x), 32767);
+    }
+}
+
+
+/*!
+  addAnalog appends the section of the given analog transfer function
+  (b0 s^2 + b1 s + b2) / (a0 s^2 + a1 s + a2), converted by the bilinear
+  transform.
+*/
+void BiquadChain::addAnalog(double b0, double b1, double b2, double a0, double a1, double a2)
+{
+    if (itsSections == MAX_SECTIONS)
+        return;
+
+    double k = 2.0 * itsRate;
+    double k2 = k * k;
+    double d = a0*k2 + a1*k + a2;
+
+    itsB0[itsSections] = (b0*k2 + b1*k + b2) / d;
+    itsB1[itsSections] = 2 * (b2 - b0*k2) / d;
+    itsB2[itsSections] = (b0*k2 - b1*k + b2) / d;
+    itsA1[itsSections] = 2 * (a2 - a0*k2) / d;
+    itsA2[itsSections] = (a0*k2 - a1*k + a2) / d;
+    itsSections++;
+}
+
+
+/*!
+  setupBlock computes the block coefficients of the given section, by running
+  it on a unit impulse of each input sample of a block and of each state
+  variable. The first BLOCK+2 rows hold the resulting outputs, the following
+  ones the resulting state.
+*/
+void BiquadChain::setupBlock(int section)
+{
+    float *c = itsBlock[section];
+    for (int j = 0; j < BLOCK+2; ++j) {
+        double state1 = (j == BLOCK) ? 1 : 0;
+        double state2 = (j == BLOCK+1) ? 1 : 0;
+        for (int i = 0; i < BLOCK; ++i) {
+            double x = (i == j) ? 1 : 0;
+            double y = itsB0[section] * x + state1;
+            state1 = itsB1[section] * x + state2 - itsA1[section] * y;
+            state2 = itsB2[section] * x - itsA2[section] * y;
+            c[j*BLOCK + i] = y;
+        }
+
+        float *next = c + (BLOCK+2 + j) * BLOCK;
+        next[0] = state1;
+        next[1] = state2;
+        for (int i = 2; i < BLOCK; ++i)
+            next[i] = 0;
+    }
+}
+
+
+/*!
+  gain returns the magnitude of the frequency response of the sections from
+  the given one on, at the given frequency in Hz.
+*/
+double BiquadChain::gain(int first, double frequency) const
+{
+    // z^-1 on the unit circle
+    std::complex<double> z = std::polar(1.0, -2 * M_PI * frequency / itsRate);
+    std::complex<double> h = 1;
+    for (int s = first; s < itsSections; ++s) {
+        std::complex<double> b = (double)itsB0[s] + ((double)itsB1[s] + (double)itsB2[s]*z) * z;
+        std::complex<double> a = 1.0 + ((double)itsA1[s] + (double)itsA2[s]*z) * z;
+        h *= b / a;
+    }
+
+    return std::abs(h);
+}
@@ -0,0 +1,91 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef BIQUADCHAIN_H
+#define BIQUADCHAIN_H
+
+#include <QtGlobal>
+
+
+/*!
+  BiquadChain filters the audio ahead of the level analysis by a cascade of
+  second order IIR sections: a DC blocker, a Butterworth high pass of
+  configurable cutoff against rumble and an A-weighting option. The
+  coefficients are derived from the analog prototypes by the bilinear
+  transform, once the sample rate is known. A-weighting is normalized to unity
+  gain at 1 kHz, near the Nyquist frequency of low sample rates it is an
+  approximation.
+
+  The recursion of a section depends on its previous output, so the samples
+  are not independent. Instead, each section is run on blocks of BLOCK
+  samples: the outputs and the state after the block are linear in the inputs
+  and the state before it, by coefficients precomputed from the impulse
+  response of the section. Only the state update remains a recursion, once per
+  block, the rest are independent SSE or NEON operations. The filter is exact
+  up to rounding, the scalar variant runs the plain recursion per sample.
+*/
+class BiquadChain
+{
+public:
+    //! maximum number of sections
+    const static int MAX_SECTIONS = 8;
+
+    BiquadChain();
+
+    void setup(int rate, bool dcBlock, int highPass, bool aWeighting);
+    bool isEnabled() const;
+    int sections() const;
+    void reset();
+
+    void process(qint16 *data, int frames);
+
+private:
+    //! number of samples of a block, the width of a SIMD register
+    const static int BLOCK = 4;
+    //! number of block coefficient rows per section: BLOCK rows of the input
+    //! and two of the state, for the output and for the next state each
+    const static int BLOCK_ROWS = 2*BLOCK + 4;
+    //! number of samples filtered in floating point at once
+    const static int CHUNK = 256;
+    //! cutoff frequency of the DC blocker in Hz
+    const static int DC_CUTOFF = 10;
+
+    void addAnalog(double b0, double b1, double b2, double a0, double a1, double a2);
+    void setupBlock(int section);
+    double gain(int first, double frequency) const;
+
+    //! sample rate of the coefficients
+    int itsRate;
+    //! number of sections, 0 if disabled
+    int itsSections;
+
+    //! normalized coefficients of each section, a0 is 1
+    float itsB0[MAX_SECTIONS];
+    float itsB1[MAX_SECTIONS];
+    float itsB2[MAX_SECTIONS];
+    float itsA1[MAX_SECTIONS];
+    float itsA2[MAX_SECTIONS];
+
+    //! block coefficients of each section, rows of BLOCK values
+    float itsBlock[MAX_SECTIONS][BLOCK_ROWS * BLOCK];
+
+    //! the two state variables of each section, transposed direct form II
+    float itsState1[MAX_SECTIONS];
+    float itsState2[MAX_SECTIONS];
+};
+
+#endif // BIQUADCHAIN_H
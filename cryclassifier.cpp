@@ -0,0 +1,348 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "cryclassifier.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QDataStream>
+#include <cmath>
+#include <string.h>
+
+// determine the SIMD instruction set we can build
+#if defined(__SSE2__) || defined(__x86_64__)
+  #define CRYCLASSIFIER_SSE2
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define CRYCLASSIFIER_NEON
+  #include <arm_neon.h>
+#endif
+
+
+/*!
+  dot returns the dot product of two int8 vectors. The length needs to be a
+  multiple of 16 and the values within -127 to 127, such that two products
+  fit into 16 bit.
+*/
+static qint32 dot(const qint8 *a, const qint8 *b, int length)
+{
+#if defined(CRYCLASSIFIER_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    for (int i = 0; i < length; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        // sign extension to 16 bit
+        __m128i signA = _mm_cmpgt_epi8(zero, va);
+        __m128i signB = _mm_cmpgt_epi8(zero, vb);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi8(va, signA),
+                                                _mm_unpacklo_epi8(vb, signB)));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpackhi_epi8(va, signA),
+                                                _mm_unpackhi_epi8(vb, signB)));
+    }
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+    return _mm_cvtsi128_si32(sum);
+#elif defined(CRYCLASSIFIER_NEON)
+    int32x4_t sum = vdupq_n_s32(0);
+    for (int i = 0; i < length; i += 16) {
+        int8x16_t va = vld1q_s8(a + i);
+        int8x16_t vb = vld1q_s8(b + i);
+        int16x8_t products = vmull_s8(vget_low_s8(va), vget_low_s8(vb));
+        products = vmlal_s8(products, vget_high_s8(va), vget_high_s8(vb));
+        sum = vpadalq_s16(sum, products);
+    }
+    int32x2_t half = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+    return vget_lane_s32(vpadd_s32(half, half), 0);
+#else
+    qint32 sum = 0;
+    for (int i = 0; i < length; ++i)
+        sum += (qint32)a[i] * b[i];
+    return sum;
+#endif
+}
+
+
+/*!
+  quantize converts the values to int8 by the given scale, clipped to -127 to
+  127. The remaining values up to the stride are cleared.
+*/
+static void quantize(const float *values, int count, float scale, qint8 *result,
+                     int stride)
+{
+    float factor = 1.0f / scale;
+    for (int i = 0; i < count; ++i) {
+        float q = floor(values[i] * factor + 0.5f);
+        result[i] = (qint8)qBound(-127.0f, q, 127.0f);
+    }
+    for (int i = count; i < stride; ++i)
+        result[i] = 0;
+}
+
+
+/*!
+  The constructor sets up a disabled classifier.
+*/
+CryClassifier::CryClassifier()
+    : itsContext(0)
+{
+    reset();
+}
+
+
+/*!
+  load reads the model of the given file and enables the classifier for audio
+  of the given sample rate. On errors, the classifier is disabled and false
+  is returned.
+*/
+bool CryClassifier::load(const QString &fileName, int rate)
+{
+    unload();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open classifier model" << fileName;
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    char magic[4];
+    quint32 version, context, layerCount;
+    if ( (in.readRawData(magic, 4) != 4) || (memcmp(magic, "BPCC", 4) != 0) ) {
+        qWarning() << "Not a classifier model:" << fileName;
+        return false;
+    }
+    in >> version >> context;
+    if ( (version != 1) || (context < 1) || (context > MAX_CONTEXT) ) {
+        qWarning() << "Unsupported classifier model" << fileName;
+        return false;
+    }
+
+    int inputs = context * MfccExtractor::MFCC_COUNT;
+    QVector<float> mean(inputs);
+    QVector<float> scale(inputs);
+    for (int i = 0; i < inputs; ++i)
+        in >> mean[i];
+    for (int i = 0; i < inputs; ++i)
+        in >> scale[i];
+
+    in >> layerCount;
+    if ( (layerCount < 1) || (layerCount > MAX_LAYERS) ) {
+        qWarning() << "Unsupported classifier model" << fileName;
+        return false;
+    }
+
+    QVector<Layer> layers(layerCount);
+    for (int l = 0; l < layers.size(); ++l) {
+        Layer &layer = layers[l];
+        quint32 layerInputs, layerOutputs;
+        in >> layerInputs >> layerOutputs >> layer.inputScale;
+
+        // the layers need to chain up to a single output
+        bool last = (l == layers.size()-1);
+        if ( ((int)layerInputs != inputs) || (layerOutputs < 1) ||
+             (layerOutputs > MAX_WIDTH) || (last && (layerOutputs != 1)) ||
+             !(layer.inputScale > 0) ) {
+            qWarning() << "Inconsistent layer" << l << "of classifier model" << fileName;
+            return false;
+        }
+
+        layer.inputs = layerInputs;
+        layer.outputs = layerOutputs;
+        layer.stride = (layer.inputs + LANES-1) / LANES * LANES;
+        layer.weightScale.resize(layer.outputs);
+        layer.bias.resize(layer.outputs);
+        layer.weights.fill(0, layer.outputs * layer.stride);
+
+        for (int o = 0; o < layer.outputs; ++o)
+            in >> layer.weightScale[o];
+        for (int o = 0; o < layer.outputs; ++o)
+            in >> layer.bias[o];
+        for (int o = 0; o < layer.outputs; ++o) {
+            qint8 *row = layer.weights.data() + o * layer.stride;
+            for (int i = 0; i < layer.inputs; ++i) {
+                in >> row[i];
+                // -128 would overflow the 16 bit pairs of the dot product
+                row[i] = qMax<qint8>(row[i], -127);
+            }
+        }
+
+        inputs = layer.outputs;
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "Truncated classifier model" << fileName;
+        return false;
+    }
+
+    itsLayers = layers;
+    itsContext = context;
+    itsMean = mean;
+    itsScale = scale;
+    itsExtractor.setup(rate);
+    itsFeatures.fill(0, itsContext * MfccExtractor::MFCC_COUNT);
+    reset();
+
+    qDebug() << "Loaded classifier model" << fileName << "of" << itsLayers.size()
+             << "layers on" << itsContext << "frames";
+    return true;
+}
+
+
+/*!
+  unload disables the classifier.
+*/
+void CryClassifier::unload()
+{
+    itsLayers.clear();
+    itsContext = 0;
+    reset();
+}
+
+
+/*!
+  isEnabled returns true if a model is loaded.
+*/
+bool CryClassifier::isEnabled() const
+{
+    return !itsLayers.isEmpty();
+}
+
+
+/*!
+  reset drops the current frame, the frame context and the collected
+  probabilities.
+*/
+void CryClassifier::reset()
+{
+    itsFill = 0;
+    itsFeatureFrames = 0;
+    itsProbabilitySum = 0;
+    itsProbabilityCount = 0;
+    itsProbability = 0;
+}
+
+
+/*!
+  write adds the given S16 mono samples. Each time a frame is complete, it is
+  classified and the frame moves on by HOP_SIZE samples.
+*/
+void CryClassifier::write(const qint16 *data, int frames)
+{
+    if (!isEnabled())
+        return;
+
+    const int frameSize = SpectralDetector::FFT_SIZE;
+
+    while (frames > 0) {
+        int n = qMin(frames, frameSize - itsFill);
+        memcpy(itsFrame + itsFill, data, n * sizeof(qint16));
+        itsFill += n;
+        data += n;
+        frames -= n;
+
+        if (itsFill == frameSize) {
+            analyzeFrame();
+
+            // the frames overlap by half
+            memcpy(itsFrame, itsFrame + HOP_SIZE, (frameSize - HOP_SIZE) * sizeof(qint16));
+            itsFill = frameSize - HOP_SIZE;
+        }
+    }
+}
+
+
+/*!
+  probability returns the mean cry probability of the frames since the last
+  call, in percent. If no frame got classified since, the previous value is
+  returned.
+*/
+int CryClassifier::probability()
+{
+    if (itsProbabilityCount > 0) {
+        itsProbability = (int)(100 * itsProbabilitySum / itsProbabilityCount + 0.5f);
+        itsProbabilitySum = 0;
+        itsProbabilityCount = 0;
+    }
+
+    return itsProbability;
+}
+
+
+/*!
+  analyzeFrame appends the MFCCs of the current frame to the context. Once the
+  context is filled, the network gets evaluated.
+*/
+void CryClassifier::analyzeFrame()
+{
+    const int count = MfccExtractor::MFCC_COUNT;
+
+    float power[SpectralDetector::FFT_SIZE/2 + 1];
+    SpectralDetector::spectrum(itsFrame, power);
+
+    // the context is shifted by one frame, the newest frame comes last
+    float *features = itsFeatures.data();
+    memmove(features, features + count, (itsContext-1) * count * sizeof(float));
+    itsExtractor.compute(power, features + (itsContext-1) * count);
+
+    if (itsFeatureFrames < itsContext) {
+        itsFeatureFrames++;
+        if (itsFeatureFrames < itsContext)
+            return;
+    }
+
+    itsProbabilitySum += infer();
+    itsProbabilityCount++;
+}
+
+
+/*!
+  infer evaluates the network on the normalized frame context and returns the
+  cry probability.
+*/
+float CryClassifier::infer()
+{
+    float values[MAX_WIDTH];
+    qint8 quantized[MAX_WIDTH];
+
+    const int inputs = itsFeatures.size();
+    for (int i = 0; i < inputs; ++i)
+        values[i] = (itsFeatures.at(i) - itsMean.at(i)) * itsScale.at(i);
+
+    float output = 0;
+    for (int l = 0; l < itsLayers.size(); ++l) {
+        const Layer &layer = itsLayers.at(l);
+        bool last = (l == itsLayers.size()-1);
+
+        quantize(values, layer.inputs, layer.inputScale, quantized, layer.stride);
+
+        const qint8 *row = layer.weights.constData();
+        for (int o = 0; o < layer.outputs; ++o) {
+            qint32 sum = layer.bias.at(o) + dot(quantized, row, layer.stride);
+            float value = sum * layer.inputScale * layer.weightScale.at(o);
+            // ReLU for the hidden layers
+            values[o] = last ? value : qMax(0.0f, value);
+            row += layer.stride;
+        }
+        output = values[0];
+    }
+
+    return 1.0f / (1.0f + exp(-output));
+}
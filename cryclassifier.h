@@ -0,0 +1,120 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CRYCLASSIFIER_H
+#define CRYCLASSIFIER_H
+
+#include <QString>
+#include <QVector>
+
+#include "mfccextractor.h"
+#include "spectraldetector.h"
+
+
+/*!
+  CryClassifier estimates the probability that the audio is an infant crying,
+  by a small neural network on the MFCCs of the audio frames.
+
+  The S16 mono audio is split into frames of SpectralDetector::FFT_SIZE
+  samples, which overlap by half. The MFCCs of the latest frames form the
+  network input, after normalization by the per input mean and scale of the
+  model. The network is a multi layer perceptron with int8 weights, ReLU
+  hidden layers and a single logistic output. Each layer quantizes its input
+  to int8 by a fixed scale, the dot products are computed in 32 bit integers,
+  16 values at a time with SSE2 or NEON where available.
+
+  The model file is little endian:
+  - "BPCC", version (quint32, 1), context frames (quint32)
+  - mean and scale (float) of each of the MFCC_COUNT * context frames inputs
+  - layer count (quint32), then for each layer: inputs and outputs (quint32),
+    input scale (float), weight scale (float) and bias (qint32) of each
+    output, and the weights (qint8, -127 to 127) by output
+  A layer output is (bias + sum of quantized input * weight) * input scale *
+  weight scale.
+
+  The probability reported to the caller is the mean of the frames since the
+  last query, in percent.
+*/
+class CryClassifier
+{
+public:
+    CryClassifier();
+
+    bool load(const QString &fileName, int rate);
+    void unload();
+    bool isEnabled() const;
+    void reset();
+
+    void write(const qint16 *data, int frames);
+    int probability();
+
+private:
+    //! number of new samples per frame, half the frame size
+    const static int HOP_SIZE = SpectralDetector::FFT_SIZE / 2;
+    //! maximum number of frames of the network input
+    const static int MAX_CONTEXT = 32;
+    //! maximum number of layers and of inputs or outputs of a layer
+    const static int MAX_LAYERS = 8;
+    const static int MAX_WIDTH = 512;
+    //! the quantized values are processed in groups of this size
+    const static int LANES = 16;
+
+    //! a fully connected network layer
+    struct Layer {
+        int inputs;
+        int outputs;
+        //! number of inputs rounded up to full lanes, the row stride
+        int stride;
+        float inputScale;
+        QVector<float> weightScale;
+        QVector<qint32> bias;
+        //! the weights by output, padded with zeros to the stride
+        QVector<qint8> weights;
+    };
+
+    void analyzeFrame();
+    float infer();
+
+    //! the network layers, empty if disabled
+    QVector<Layer> itsLayers;
+    //! number of frames of the network input
+    int itsContext;
+    //! input normalization
+    QVector<float> itsMean;
+    QVector<float> itsScale;
+
+    //! the MFCC computation of the sample rate
+    MfccExtractor itsExtractor;
+
+    //! samples of the current frame
+    qint16 itsFrame[SpectralDetector::FFT_SIZE];
+    //! number of samples of the current frame
+    int itsFill;
+    //! MFCCs of the latest frames, oldest first once filled
+    QVector<float> itsFeatures;
+    //! number of frames in itsFeatures
+    int itsFeatureFrames;
+
+    //! sum of the frame probabilities since the last query
+    float itsProbabilitySum;
+    //! number of frames since the last query
+    int itsProbabilityCount;
+    //! latest probability, repeated if no frame completed in between
+    int itsProbability;
+};
+
+#endif // CRYCLASSIFIER_H
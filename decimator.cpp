@@ -0,0 +1,177 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "decimator.h"
+
+#include <cmath>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+// a little below the output Nyquist frequency to leave room for the transition
+const float Decimator::CUTOFF = 0.9f;
+
+
+/*!
+  gcd returns the greatest common divisor of the given numbers.
+*/
+static int gcd(int a, int b)
+{
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+
+/*!
+  The constructor sets up an inactive decimator, which passes nothing.
+*/
+Decimator::Decimator()
+    : itsUp(1), itsDown(1), itsTaps(0), itsMaxInput(0), itsPosition(0)
+{
+}
+
+
+/*!
+  setup designs the anti-alias filter for the given rates and allocates the
+  buffers for up to maxInput input samples per call. It returns false if the
+  input rate is not above the output rate, then no decimation is needed.
+*/
+bool Decimator::setup(int inputRate, int outputRate, int maxInput)
+{
+    itsTaps = 0;
+    itsCoefficients.clear();
+    itsBuffer.clear();
+
+    if ((outputRate <= 0) || (inputRate <= outputRate))
+        return false;
+
+    int divisor = gcd(inputRate, outputRate);
+    itsUp = outputRate / divisor;
+    itsDown = inputRate / divisor;
+    itsMaxInput = maxInput;
+
+    // prototype lowpass at the upsampled rate, the sinc zero crossings are
+    // itsDown/CUTOFF upsampled samples apart
+    double cutoff = CUTOFF / (2.0 * itsDown);
+    itsTaps = (int)ceil(2 * ZERO_CROSSINGS * itsDown / CUTOFF / itsUp);
+    int length = itsTaps * itsUp;
+    double center = (length - 1) / 2.0;
+
+    QVector<double> prototype(length);
+    for (int i = 0; i < length; ++i) {
+        double x = i - center;
+        double sinc = (x == 0) ? 1.0 : sin(2*M_PI*cutoff*x) / (2*M_PI*cutoff*x);
+        // Blackman window
+        double window = 0.42 - 0.5*cos(2*M_PI*i/(length-1)) + 0.08*cos(4*M_PI*i/(length-1));
+        prototype[i] = sinc * window;
+    }
+
+    // split into phases, each one normalized to unity DC gain
+    itsCoefficients.resize(length);
+    for (int phase = 0; phase < itsUp; ++phase) {
+        double sum = 0;
+        for (int k = 0; k < itsTaps; ++k)
+            sum += prototype[phase + k*itsUp];
+
+        // reversed order, such that the filter runs forward over the buffer
+        for (int k = 0; k < itsTaps; ++k) {
+            double value = prototype[phase + k*itsUp] / sum;
+            itsCoefficients[phase*itsTaps + itsTaps-1 - k] =
+                    (qint16)floor(value * (1 << COEFFICIENT_BITS) + 0.5);
+        }
+    }
+
+    itsBuffer.resize(itsTaps-1 + maxInput);
+    reset();
+
+    return true;
+}
+
+
+/*!
+  reset clears the filter history.
+*/
+void Decimator::reset()
+{
+    itsBuffer.fill(0);
+    itsPosition = 0;
+}
+
+
+/*!
+  isActive returns true if setup succeeded and the input gets decimated.
+*/
+bool Decimator::isActive() const
+{
+    return itsTaps > 0;
+}
+
+
+/*!
+  maxOutput returns the maximum number of output samples of a single process
+  call.
+*/
+int Decimator::maxOutput() const
+{
+    return (qint64)itsMaxInput * itsUp / itsDown + 1;
+}
+
+
+/*!
+  process decimates the given input samples and writes the resulting samples
+  to output, which needs to hold maxOutput samples. It returns the number of
+  output samples.
+*/
+int Decimator::process(const qint16 *input, int frames, qint16 *output)
+{
+    Q_ASSERT(frames <= itsMaxInput);
+
+    qint16 *buffer = itsBuffer.data();
+    memcpy(buffer + itsTaps-1, input, frames * sizeof(qint16));
+
+    const int end = frames * itsUp;
+    int count = 0;
+    while (itsPosition < end) {
+        // the filter phase and the newest input sample it covers
+        const qint16 *coefficients = itsCoefficients.constData() +
+                                     (itsPosition % itsUp) * itsTaps;
+        const qint16 *data = buffer + itsPosition / itsUp;
+
+        qint32 sum = 0;
+        for (int k = 0; k < itsTaps; ++k)
+            sum += coefficients[k] * data[k];
+
+        // round and saturate
+        sum = (sum + (1 << (COEFFICIENT_BITS-1))) >> COEFFICIENT_BITS;
+        output[count++] = (qint16)qBound(-32768, sum, 32767);
+
+        itsPosition += itsDown;
+    }
+    itsPosition -= end;
+
+    // keep the history for the next call
+    memmove(buffer, buffer + frames, (itsTaps-1) * sizeof(qint16));
+
+    return count;
+}
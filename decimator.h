@@ -0,0 +1,76 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <QtGlobal>
+#include <QVector>
+
+
+/*!
+  Decimator converts a stream of S16 mono samples from a higher input rate to a
+  lower output rate, such that the audio analysis runs at a fixed rate for all
+  audio devices.
+
+  The rate conversion is rational: the input is upsampled by itsUp, filtered by
+  a windowed sinc anti-alias lowpass and downsampled by itsDown. The polyphase
+  implementation only computes the filter phases of the actual output samples.
+  The coefficients are stored in Q14 fixed point, one contiguous row per phase.
+
+  All memory is allocated by setup. process does not allocate, it handles at
+  most the number of input samples given to setup per call.
+*/
+class Decimator
+{
+public:
+    Decimator();
+
+    bool setup(int inputRate, int outputRate, int maxInput);
+    void reset();
+    bool isActive() const;
+    int maxOutput() const;
+
+    int process(const qint16 *input, int frames, qint16 *output);
+
+private:
+    //! number of fractional bits of the filter coefficients
+    const static int COEFFICIENT_BITS = 14;
+    //! number of sinc zero crossings on each side of the filter center
+    const static int ZERO_CROSSINGS = 6;
+    //! cutoff frequency in relation to the output Nyquist frequency
+    static const float CUTOFF;
+
+    //! upsampling factor
+    int itsUp;
+    //! downsampling factor
+    int itsDown;
+    //! number of filter taps per phase
+    int itsTaps;
+    //! maximum number of input samples per call
+    int itsMaxInput;
+
+    //! filter coefficients, itsTaps per phase, in reversed order
+    QVector<qint16> itsCoefficients;
+    //! the last itsTaps-1 input samples, followed by the current input
+    QVector<qint16> itsBuffer;
+    //! position of the next output sample in upsampled units, relative to
+    //! the first sample of the current input
+    int itsPosition;
+};
+
+#endif // DECIMATOR_H
@@ -0,0 +1,993 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dspgraph.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSettings>
+#include <QRunnable>
+#include <cmath>
+#include <sys/time.h>
+
+#include "taskpool.h"
+#include "spectraldetector.h"
+#include "goertzelbank.h"
+#include "pitchdetector.h"
+#include "cryclassifier.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+// name of the audio input of the graph
+static const char * const AUDIO_INPUT = "audio";
+// group of the pipeline file naming the gate and probability nodes
+static const char * const PIPELINE_GROUP = "pipeline";
+
+
+/*!
+  microseconds returns the current time in us.
+*/
+static qint64 microseconds()
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return (qint64)now.tv_sec * 1000000 + now.tv_usec;
+}
+
+
+/*!
+  DspTask processes a block of audio by a node. It sums up its processing
+  time, which is taken by the thread evaluating the graph.
+*/
+class DspTask : public QRunnable
+{
+public:
+    explicit DspTask(DspNode *node)
+        : itsNode(node), itsInput(0), itsFrames(0), itsOutput(0), itsTime(0) {}
+
+    void setBlock(const qint16 *input, int frames, qint16 *output)
+    {
+        itsInput = input;
+        itsFrames = frames;
+        itsOutput = output;
+    }
+
+    void run()
+    {
+        qint64 start = microseconds();
+        itsNode->write(itsInput, itsFrames, itsOutput);
+        // the clock may be set meanwhile
+        itsTime += qMax<qint64>(0, microseconds() - start);
+    }
+
+    qint64 takeTime()
+    {
+        qint64 time = itsTime;
+        itsTime = 0;
+        return time;
+    }
+
+private:
+    DspNode *itsNode;
+    const qint16 *itsInput;
+    int itsFrames;
+    qint16 *itsOutput;
+    qint64 itsTime;
+};
+
+
+/*!
+  DcBlockNode is a first order high pass filter. It removes the DC offset of
+  the microphone and the rumble below the cutoff frequency.
+*/
+class DcBlockNode : public DspNode
+{
+public:
+    DcBlockNode() : DspNode(KIND_FILTER), itsPole(0) { reset(); }
+
+    bool setup(int rate, const QVariantMap &parameters)
+    {
+        int cutoff = parameters.value("cutoff", 20).toInt();
+        if ( (cutoff <= 0) || (2*cutoff >= rate) )
+            return false;
+
+        itsPole = exp(-2 * M_PI * cutoff / rate);
+        return true;
+    }
+
+    void reset()
+    {
+        itsInput = 0;
+        itsOutput = 0;
+    }
+
+    void write(const qint16 *input, int frames, qint16 *output)
+    {
+        // the input sample is read first, such that the filter works in place
+        for (int i = 0; i < frames; ++i) {
+            float x = input[i];
+            itsOutput = x - itsInput + itsPole * itsOutput;
+            itsInput = x;
+            output[i] = (qint16)qRound(qBound(-32768.0f, itsOutput, 32767.0f));
+        }
+    }
+
+    int value(const int *, const QVector<int> &) { return 0; }
+
+private:
+    float itsPole;
+    float itsInput;
+    float itsOutput;
+};
+
+
+/*!
+  SpectralNode reports the harmonic cry score of the SpectralDetector.
+*/
+class SpectralNode : public DspNode
+{
+public:
+    SpectralNode() : DspNode(KIND_DETECTOR) {}
+
+    bool setup(int rate, const QVariantMap &)
+    {
+        itsDetector.setup(rate);
+        return itsDetector.isEnabled();
+    }
+
+    void reset() { itsDetector.reset(); }
+    void write(const qint16 *input, int frames, qint16 *) { itsDetector.write(input, frames); }
+    int value(const int *, const QVector<int> &) { return itsDetector.score(); }
+
+private:
+    SpectralDetector itsDetector;
+};
+
+
+/*!
+  GoertzelNode reports the cry score of the GoertzelBank at the frequencies of
+  the parameters.
+*/
+class GoertzelNode : public DspNode
+{
+public:
+    GoertzelNode() : DspNode(KIND_DETECTOR) {}
+
+    bool setup(int rate, const QVariantMap &parameters)
+    {
+        QList<int> frequencies;
+        foreach (const QString &frequency, parameters.value("frequencies").toStringList())
+            frequencies.append(frequency.toInt());
+        itsBank.setup(rate, frequencies);
+        return itsBank.isEnabled();
+    }
+
+    void reset() { itsBank.reset(); }
+    void write(const qint16 *input, int frames, qint16 *) { itsBank.write(input, frames); }
+    int value(const int *, const QVector<int> &) { return itsBank.score(); }
+
+private:
+    GoertzelBank itsBank;
+};
+
+
+/*!
+  PitchNode reports the share of periodic frames of the PitchDetector.
+*/
+class PitchNode : public DspNode
+{
+public:
+    PitchNode() : DspNode(KIND_DETECTOR) {}
+
+    bool setup(int rate, const QVariantMap &)
+    {
+        itsDetector.setup(rate);
+        return itsDetector.isEnabled();
+    }
+
+    void reset() { itsDetector.reset(); }
+    void write(const qint16 *input, int frames, qint16 *) { itsDetector.write(input, frames); }
+    int value(const int *, const QVector<int> &) { return itsDetector.score(); }
+
+private:
+    PitchDetector itsDetector;
+};
+
+
+/*!
+  ClassifierNode reports the cry probability of the CryClassifier with the
+  model file of the parameters.
+*/
+class ClassifierNode : public DspNode
+{
+public:
+    ClassifierNode() : DspNode(KIND_DETECTOR) {}
+
+    bool setup(int rate, const QVariantMap &parameters)
+    {
+        return itsClassifier.load(parameters.value("model").toString(), rate);
+    }
+
+    void reset() { itsClassifier.reset(); }
+    void write(const qint16 *input, int frames, qint16 *) { itsClassifier.write(input, frames); }
+    int value(const int *, const QVector<int> &) { return itsClassifier.probability(); }
+
+private:
+    CryClassifier itsClassifier;
+};
+
+
+/*!
+  LevelNode reports the peak level given to the decision. Its value is set by
+  the graph, the node just marks its position.
+*/
+class LevelNode : public DspNode
+{
+public:
+    LevelNode() : DspNode(KIND_LEVEL) {}
+
+    bool setup(int, const QVariantMap &) { return true; }
+    int value(const int *, const QVector<int> &) { return 0; }
+};
+
+
+/*!
+  ThresholdNode reports 100 if the value of its input reaches the threshold,
+  otherwise 0.
+*/
+class ThresholdNode : public DspNode
+{
+public:
+    ThresholdNode() : DspNode(KIND_AGGREGATOR), itsThreshold(0) {}
+
+    bool setup(int, const QVariantMap &parameters)
+    {
+        itsThreshold = parameters.value("threshold", DspGraph::GATE_LEVEL).toInt();
+        return true;
+    }
+
+    int value(const int *values, const QVector<int> &inputs)
+    {
+        return (values[inputs.at(0)] >= itsThreshold) ? 100 : 0;
+    }
+
+private:
+    int itsThreshold;
+};
+
+
+/*!
+  AggregateNode reports the minimum, maximum or mean value of its inputs. On
+  thresholds, these are the logical and, or and the share of votes. Voting
+  reports 100 if a quorum of inputs reaches GATE_LEVEL, by default the
+  majority. The weighted mean weights each input by the list "weights".
+*/
+class AggregateNode : public DspNode
+{
+public:
+    enum Mode {
+        MODE_ALL,
+        MODE_ANY,
+        MODE_MEAN,
+        MODE_VOTE,
+        MODE_WEIGHTED
+    };
+
+    explicit AggregateNode(Mode mode)
+        : DspNode(KIND_AGGREGATOR), itsMode(mode), itsQuorum(0) {}
+
+    bool setup(int, const QVariantMap &parameters)
+    {
+        itsQuorum = parameters.value("quorum", 0).toInt();
+        itsWeights.clear();
+        foreach (const QString &weight, parameters.value("weights").toStringList()) {
+            bool valid;
+            itsWeights.append(weight.toFloat(&valid));
+            if (!valid || (itsWeights.last() < 0))
+                return false;
+        }
+
+        return itsQuorum >= 0;
+    }
+
+    int value(const int *values, const QVector<int> &inputs)
+    {
+        int result = values[inputs.at(0)];
+        int sum = 0;
+        int votes = 0;
+        float weightedSum = 0;
+        float weights = 0;
+        for (int i = 0; i < inputs.size(); ++i) {
+            int input = values[inputs.at(i)];
+            float weight = (i < itsWeights.size()) ? itsWeights.at(i) : 1;
+            sum += input;
+            weightedSum += weight * input;
+            weights += weight;
+            if (input >= DspGraph::GATE_LEVEL)
+                votes++;
+            if (itsMode == MODE_ALL)
+                result = qMin(result, input);
+            else if (itsMode == MODE_ANY)
+                result = qMax(result, input);
+        }
+
+        if (itsMode == MODE_MEAN)
+            return sum / inputs.size();
+        if (itsMode == MODE_VOTE) {
+            int quorum = (itsQuorum > 0) ? itsQuorum : inputs.size() / 2 + 1;
+            return (votes >= quorum) ? 100 : 0;
+        }
+        if (itsMode == MODE_WEIGHTED)
+            return (weights > 0) ? qRound(weightedSum / weights) : 0;
+        return result;
+    }
+
+private:
+    Mode itsMode;
+    //! number of votes to pass, 0 for the majority
+    int itsQuorum;
+    //! weight of each input, 1 for the inputs beyond
+    QList<float> itsWeights;
+};
+
+
+/*!
+  The constructor sets up a node of the given kind.
+*/
+DspNode::DspNode(Kind kind)
+    : itsKind(kind)
+{
+}
+
+
+/*!
+  The destructor is virtual to release the derived nodes.
+*/
+DspNode::~DspNode()
+{
+}
+
+
+/*!
+  kind returns whether the node is a filter, a detector or an aggregator.
+*/
+DspNode::Kind DspNode::kind() const
+{
+    return itsKind;
+}
+
+
+/*!
+  reset restarts the analysis of the node. Nodes without state do nothing.
+*/
+void DspNode::reset()
+{
+}
+
+
+/*!
+  write processes the given audio frames. Aggregators do not process audio.
+*/
+void DspNode::write(const qint16 *, int, qint16 *)
+{
+}
+
+
+/*!
+  The constructor sets up an empty graph without task pool.
+*/
+DspGraph::DspGraph()
+    : itsRate(0), itsPool(0), itsUsesLevel(false), itsGate(-1), itsProbability(-1),
+      itsWallTime(0), itsBlocks(0), itsTotalWallTime(0), itsTotalBlocks(0),
+      itsDecisions(0)
+{
+}
+
+
+/*!
+  The destructor releases the nodes.
+*/
+DspGraph::~DspGraph()
+{
+    clear();
+}
+
+
+/*!
+  setup clears the graph to add nodes for audio of the given sample rate.
+*/
+void DspGraph::setup(int rate)
+{
+    clear();
+    itsRate = rate;
+}
+
+
+/*!
+  setPool runs the nodes of each level on the given task pool, which needs to
+  exist as long as the graph processes audio. The pool is kept by setup and
+  clear. Without pool, the nodes run one after the other.
+*/
+void DspGraph::setPool(TaskPool *pool)
+{
+    itsPool = pool;
+}
+
+
+/*!
+  addNode creates a node of the given name and type and sets it up by the
+  given parameters. Filters and detectors process the audio of the node named
+  by the parameter "input", by default the audio input. Aggregators combine
+  the values of the nodes named by "inputs" or "input". Level nodes have no
+  input. The connections are resolved by schedule. It returns false if the
+  node cannot be created.
+*/
+bool DspGraph::addNode(const QString &name, const QString &type, const QVariantMap &parameters)
+{
+    if ( name.isEmpty() || (name == AUDIO_INPUT) || (indexOf(name) >= 0) ) {
+        qWarning() << "Invalid pipeline node name" << name;
+        return false;
+    }
+
+    DspNode *node = createNode(type);
+    if (node == 0) {
+        qWarning() << "Unknown type" << type << "of pipeline node" << name;
+        return false;
+    }
+    if (!node->setup(itsRate, parameters)) {
+        qWarning() << "Invalid parameters of pipeline node" << name;
+        delete node;
+        return false;
+    }
+
+    Entry entry;
+    entry.name = name;
+    entry.node = node;
+    if (node->kind() == DspNode::KIND_AGGREGATOR)
+        entry.inputNames = parameters.value("inputs", parameters.value("input")).toStringList();
+    else if (processesAudio(node))
+        entry.inputNames.append(parameters.value("input", AUDIO_INPUT).toString());
+    entry.inputNames.removeAll(QString());
+    entry.source = -1;
+    entry.target = -1;
+    itsEntries.append(entry);
+
+    return true;
+}
+
+
+/*!
+  schedule resolves the connections of the nodes, determines their order of
+  execution and levels and assigns the buffers of the filter outputs. Each
+  buffer is released after the level of the last node processing its audio and
+  reused by the filters of the next levels. A filter reusing the buffer of its
+  input within its level needs to be the only reader. The audio passes the
+  graph if the value of the given gate node reaches GATE_LEVEL, the value of
+  the probability node is reported. Both are optional. It returns false on
+  unknown nodes or cycles.
+*/
+bool DspGraph::schedule(const QString &gate, const QString &probability)
+{
+    const int count = itsEntries.size();
+
+    // resolve the inputs, audio is only provided by filters
+    QVector<int> pending(count, 0);
+    QVector< QVector<int> > consumers(count);
+    for (int i = 0; i < count; ++i) {
+        Entry &entry = itsEntries[i];
+        bool audio = processesAudio(entry.node);
+        if ( entry.inputNames.isEmpty() && (entry.node->kind() != DspNode::KIND_LEVEL) ) {
+            qWarning() << "Pipeline node" << entry.name << "has no input";
+            return false;
+        }
+
+        entry.inputs.clear();
+        foreach (const QString &inputName, entry.inputNames) {
+            int input = indexOf(inputName);
+            if ( audio && (inputName == AUDIO_INPUT) ) {
+                entry.inputs.append(-1);
+                continue;
+            }
+            if ( (input < 0) ||
+                 (audio && (itsEntries.at(input).node->kind() != DspNode::KIND_FILTER)) ) {
+                qWarning() << "Invalid input" << inputName << "of pipeline node" << entry.name;
+                return false;
+            }
+
+            entry.inputs.append(input);
+            pending[i]++;
+            consumers[input].append(i);
+        }
+    }
+
+    // topological order, starting with the nodes of the audio input
+    itsOrder.clear();
+    for (int i = 0; i < count; ++i)
+        if (pending.at(i) == 0)
+            itsOrder.append(i);
+    for (int pos = 0; pos < itsOrder.size(); ++pos) {
+        foreach (int consumer, consumers.at(itsOrder.at(pos)))
+            if (--pending[consumer] == 0)
+                itsOrder.append(consumer);
+    }
+    if (itsOrder.size() < count) {
+        qWarning() << "Pipeline contains a cycle";
+        return false;
+    }
+
+    // level of the nodes processing audio, one after the level of their input
+    QVector<int> level(count, 0);
+    int levels = 0;
+    itsUsesLevel = false;
+    foreach (int i, itsOrder) {
+        const Entry &entry = itsEntries.at(i);
+        itsUsesLevel = itsUsesLevel || (entry.node->kind() == DspNode::KIND_LEVEL);
+        if (processesAudio(entry.node)) {
+            int input = entry.inputs.at(0);
+            level[i] = (input < 0) ? 1 : level.at(input) + 1;
+            levels = qMax(levels, level.at(i));
+        }
+    }
+    itsAudioOrder.clear();
+    itsLevels.clear();
+    for (int l = 1; l <= levels; ++l) {
+        itsLevels.append(itsAudioOrder.size());
+        foreach (int i, itsOrder)
+            if ( processesAudio(itsEntries.at(i).node) && (level.at(i) == l) )
+                itsAudioOrder.append(i);
+    }
+    itsLevels.append(itsAudioOrder.size());
+
+    // last level and number of the nodes processing the audio of each filter
+    QVector<int> lastUse(count, -1);
+    QVector<int> readers(count, 0);
+    for (int i = 0; i < count; ++i) {
+        foreach (int consumer, consumers.at(i)) {
+            if (processesAudio(itsEntries.at(consumer).node)) {
+                lastUse[i] = qMax(lastUse.at(i), level.at(consumer));
+                readers[i]++;
+            }
+        }
+    }
+
+    // assign the buffers level by level, the nodes of a level run at once
+    QList<int> freeBuffers;
+    int buffers = 0;
+    for (int l = 0; l < levels; ++l) {
+        QList<int> released;
+        for (int k = itsLevels.at(l); k < itsLevels.at(l + 1); ++k) {
+            Entry &entry = itsEntries[itsAudioOrder.at(k)];
+            int input = entry.inputs.at(0);
+            entry.source = (input < 0) ? -1 : itsEntries.at(input).target;
+            entry.target = -1;
+            if ( (input < 0) || (lastUse.at(input) != l + 1) )
+                continue;
+
+            // the last readers of a buffer release it once
+            if ( (entry.node->kind() == DspNode::KIND_FILTER) && (readers.at(input) == 1) )
+                entry.target = entry.source;
+            else if (!released.contains(entry.source))
+                released.append(entry.source);
+        }
+
+        for (int k = itsLevels.at(l); k < itsLevels.at(l + 1); ++k) {
+            int i = itsAudioOrder.at(k);
+            Entry &entry = itsEntries[i];
+            if ( (entry.node->kind() == DspNode::KIND_FILTER) && (entry.target < 0) )
+                entry.target = freeBuffers.isEmpty() ? buffers++ : freeBuffers.takeLast();
+            // unused output, the buffer is free again after the level
+            if ( (entry.node->kind() == DspNode::KIND_FILTER) && (lastUse.at(i) < 0) )
+                released.append(entry.target);
+        }
+        freeBuffers += released;
+    }
+
+    // a task per node processing audio
+    foreach (QRunnable *task, itsTasks)
+        delete task;
+    itsTasks.clear();
+    foreach (int i, itsAudioOrder)
+        itsTasks.append(new DspTask(itsEntries.at(i).node));
+
+    // each buffer gets its own memory, the processing must not detach
+    itsBuffers.resize(buffers);
+    for (int b = 0; b < buffers; ++b)
+        itsBuffers[b].fill(0, BLOCK_SIZE);
+    itsValues.fill(0, count);
+
+    itsGate = gate.isEmpty() ? -1 : indexOf(gate);
+    itsProbability = probability.isEmpty() ? -1 : indexOf(probability);
+    if ( (!gate.isEmpty() && (itsGate < 0)) ||
+         (!probability.isEmpty() && (itsProbability < 0)) ) {
+        qWarning() << "Unknown pipeline gate" << gate << "or probability" << probability;
+        return false;
+    }
+
+    // statistics of the nodes processing audio and of the gate inputs
+    {
+        QMutexLocker locker(&itsStatisticsLock);
+        itsAudioNames.clear();
+        foreach (int i, itsAudioOrder)
+            itsAudioNames.append(itsEntries.at(i).name);
+        itsGateNames.clear();
+        if (itsGate >= 0)
+            foreach (int input, itsEntries.at(itsGate).inputs)
+                itsGateNames.append(itsEntries.at(input).name);
+        itsTotalTimes.fill(0, itsAudioOrder.size());
+        itsAgreements.fill(0, itsGateNames.size());
+        itsTotalWallTime = 0;
+        itsTotalBlocks = 0;
+        itsDecisions = 0;
+    }
+    itsWallTime = 0;
+    itsBlocks = 0;
+
+    qDebug() << "Pipeline of" << count << "nodes," << levels << "levels,"
+             << buffers << "buffers";
+    return true;
+}
+
+
+/*!
+  load sets up the graph of the given pipeline file for audio of the given
+  sample rate. On errors, the graph is cleared and false is returned.
+*/
+bool DspGraph::load(const QString &fileName, int rate)
+{
+    setup(rate);
+    if (!QFile::exists(fileName)) {
+        qWarning() << "Cannot open pipeline" << fileName;
+        return false;
+    }
+
+    QSettings file(fileName, QSettings::IniFormat);
+    if (file.status() != QSettings::NoError) {
+        qWarning() << "Not a pipeline:" << fileName;
+        return false;
+    }
+
+    foreach (const QString &name, file.childGroups()) {
+        if (name == PIPELINE_GROUP)
+            continue;
+
+        QVariantMap parameters;
+        file.beginGroup(name);
+        foreach (const QString &key, file.childKeys())
+            parameters.insert(key, file.value(key));
+        file.endGroup();
+
+        if (!addNode(name, parameters.value("type").toString(), parameters)) {
+            clear();
+            return false;
+        }
+    }
+
+    file.beginGroup(PIPELINE_GROUP);
+    bool scheduled = schedule(file.value("gate").toString(), file.value("probability").toString());
+    file.endGroup();
+    if (!scheduled)
+        clear();
+
+    return scheduled;
+}
+
+
+/*!
+  clear releases all nodes.
+*/
+void DspGraph::clear()
+{
+    foreach (QRunnable *task, itsTasks)
+        delete task;
+    foreach (const Entry &entry, itsEntries)
+        delete entry.node;
+
+    itsEntries.clear();
+    itsOrder.clear();
+    itsAudioOrder.clear();
+    itsLevels.clear();
+    itsTasks.clear();
+    itsUsesLevel = false;
+    itsBuffers.clear();
+    itsValues.clear();
+    itsGate = -1;
+    itsProbability = -1;
+
+    QMutexLocker locker(&itsStatisticsLock);
+    itsAudioNames.clear();
+    itsGateNames.clear();
+    itsTotalTimes.clear();
+    itsAgreements.clear();
+}
+
+
+/*!
+  isEmpty returns true if the graph has no nodes.
+*/
+bool DspGraph::isEmpty() const
+{
+    return itsEntries.isEmpty();
+}
+
+
+/*!
+  buffers returns the number of block buffers shared by the filters.
+*/
+int DspGraph::buffers() const
+{
+    return itsBuffers.size();
+}
+
+
+/*!
+  levels returns the number of levels of the nodes processing audio.
+*/
+int DspGraph::levels() const
+{
+    return qMax(0, itsLevels.size() - 1);
+}
+
+
+/*!
+  checkBuffers returns true if no buffer is shared by filter outputs in use at
+  the same time. An output is in use from the level of its filter up to the
+  level of its last reader. Only a filter working in place on the output of
+  its input, as its sole reader, takes over the buffer at that level.
+*/
+bool DspGraph::checkBuffers() const
+{
+    // level of each node processing audio and the last level reading it
+    const int count = itsEntries.size();
+    QVector<int> level(count, 0);
+    QVector<int> lastUse(count, 0);
+    for (int l = 0; l + 1 < itsLevels.size(); ++l)
+        for (int k = itsLevels.at(l); k < itsLevels.at(l + 1); ++k)
+            level[itsAudioOrder.at(k)] = l;
+    foreach (int i, itsAudioOrder) {
+        lastUse[i] = qMax(lastUse.at(i), level.at(i));
+        int input = itsEntries.at(i).inputs.at(0);
+        if (input >= 0)
+            lastUse[input] = qMax(lastUse.at(input), level.at(i));
+    }
+
+    foreach (int a, itsAudioOrder) {
+        foreach (int b, itsAudioOrder) {
+            const Entry &first = itsEntries.at(a);
+            const Entry &second = itsEntries.at(b);
+            if ( (a == b) || (first.target < 0) || (first.target != second.target) ||
+                 (level.at(a) > level.at(b)) )
+                continue;
+            bool inPlace = (second.inputs.at(0) == a) && (second.source == second.target);
+            if ( (lastUse.at(a) > level.at(b)) ||
+                 ((lastUse.at(a) == level.at(b)) && !inPlace) )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+  usesLevel returns true if the graph has a level node, so the peak level is
+  rated by the graph rather than required in addition.
+*/
+bool DspGraph::usesLevel() const
+{
+    return itsUsesLevel;
+}
+
+
+/*!
+  reset restarts the analysis of all nodes.
+*/
+void DspGraph::reset()
+{
+    foreach (const Entry &entry, itsEntries)
+        entry.node->reset();
+}
+
+
+/*!
+  write passes the given S16 mono frames through the filters and detectors, in
+  blocks of up to BLOCK_SIZE frames. The levels run one after the other, the
+  nodes of a level on the task pool, if any and if there are several.
+*/
+void DspGraph::write(const qint16 *data, int frames)
+{
+    qint64 start = microseconds();
+    while (frames > 0) {
+        int n = qMin(frames, (int)BLOCK_SIZE);
+        for (int k = 0; k < itsAudioOrder.size(); ++k) {
+            const Entry &entry = itsEntries.at(itsAudioOrder.at(k));
+            const qint16 *input = (entry.source < 0) ? data : itsBuffers.at(entry.source).constData();
+            qint16 *output = (entry.target < 0) ? 0 : itsBuffers[entry.target].data();
+            static_cast<DspTask*>(itsTasks.at(k))->setBlock(input, n, output);
+        }
+
+        for (int l = 0; l + 1 < itsLevels.size(); ++l) {
+            int first = itsLevels.at(l);
+            int count = itsLevels.at(l + 1) - first;
+            if ( (itsPool != 0) && (count > 1) )
+                itsPool->run(itsTasks.constData() + first, count);
+            else
+                for (int k = first; k < first + count; ++k)
+                    itsTasks.at(k)->run();
+        }
+
+        itsBlocks++;
+        data += n;
+        frames -= n;
+    }
+    itsWallTime += qMax<qint64>(0, microseconds() - start);
+}
+
+
+/*!
+  evaluate determines the values of all nodes for the audio since the last
+  decision. Level nodes report the given peak level. The statistics are updated.
+*/
+void DspGraph::evaluate(int level)
+{
+    for (int k = 0; k < itsOrder.size(); ++k) {
+        int i = itsOrder.at(k);
+        const Entry &entry = itsEntries.at(i);
+        if (entry.node->kind() == DspNode::KIND_LEVEL)
+            itsValues[i] = level;
+        else
+            itsValues[i] = entry.node->value(itsValues.constData(), entry.inputs);
+    }
+
+    updateStatistics();
+}
+
+
+/*!
+  passes returns true if the gate node of the last decision reached
+  GATE_LEVEL, or if there is no gate.
+*/
+bool DspGraph::passes() const
+{
+    return (itsGate < 0) || (itsValues.at(itsGate) >= GATE_LEVEL);
+}
+
+
+/*!
+  probability returns the value of the probability node of the last decision,
+  -1 if there is none.
+*/
+int DspGraph::probability() const
+{
+    return (itsProbability < 0) ? -1 : itsValues.at(itsProbability);
+}
+
+
+/*!
+  statistics returns a summary of the mean processing time of the nodes per
+  block, compared with the time the whole graph took, and of the share of
+  decisions each gate input agreed with the gate. It may be called by any
+  thread.
+*/
+QString DspGraph::statistics() const
+{
+    QMutexLocker locker(&itsStatisticsLock);
+    if (itsTotalBlocks == 0)
+        return QString();
+
+    QString text = "Detector latency per block:";
+    qint64 sum = 0;
+    for (int k = 0; k < itsAudioNames.size(); ++k) {
+        text += QString(" %1 %2 us,").arg(itsAudioNames.at(k))
+                .arg(itsTotalTimes.at(k) / itsTotalBlocks);
+        sum += itsTotalTimes.at(k);
+    }
+    text += QString(" together %1 us of %2 us").arg(itsTotalWallTime / itsTotalBlocks)
+            .arg(sum / itsTotalBlocks);
+
+    if (itsDecisions > 0) {
+        text += "\nDetector agreement:";
+        for (int j = 0; j < itsGateNames.size(); ++j)
+            text += QString(" %1 %2%").arg(itsGateNames.at(j))
+                    .arg(itsAgreements.at(j) * 100 / itsDecisions);
+    }
+
+    return text;
+}
+
+
+/*!
+  updateStatistics adds the processing times since the last decision and the
+  agreement of the gate inputs with the current decision to the statistics.
+*/
+void DspGraph::updateStatistics()
+{
+    QMutexLocker locker(&itsStatisticsLock);
+    for (int k = 0; k < itsTasks.size(); ++k)
+        itsTotalTimes[k] += static_cast<DspTask*>(itsTasks.at(k))->takeTime();
+    itsTotalWallTime += itsWallTime;
+    itsTotalBlocks += itsBlocks;
+    itsWallTime = 0;
+    itsBlocks = 0;
+
+    if (itsGate >= 0) {
+        bool passed = passes();
+        const QVector<int> &inputs = itsEntries.at(itsGate).inputs;
+        for (int j = 0; j < inputs.size(); ++j)
+            if ((itsValues.at(inputs.at(j)) >= GATE_LEVEL) == passed)
+                itsAgreements[j]++;
+        itsDecisions++;
+    }
+}
+
+
+/*!
+  createNode returns a new node of the given type, 0 for unknown types.
+*/
+DspNode *DspGraph::createNode(const QString &type)
+{
+    if (type == "dcblock")
+        return new DcBlockNode();
+    if (type == "spectral")
+        return new SpectralNode();
+    if (type == "goertzel")
+        return new GoertzelNode();
+    if (type == "pitch")
+        return new PitchNode();
+    if (type == "classifier")
+        return new ClassifierNode();
+    if (type == "threshold")
+        return new ThresholdNode();
+    if (type == "all")
+        return new AggregateNode(AggregateNode::MODE_ALL);
+    if (type == "any")
+        return new AggregateNode(AggregateNode::MODE_ANY);
+    if (type == "mean")
+        return new AggregateNode(AggregateNode::MODE_MEAN);
+    if (type == "vote")
+        return new AggregateNode(AggregateNode::MODE_VOTE);
+    if (type == "weighted")
+        return new AggregateNode(AggregateNode::MODE_WEIGHTED);
+    if (type == "level")
+        return new LevelNode();
+
+    return 0;
+}
+
+
+/*!
+  processesAudio returns true for filters and detectors, which process audio.
+*/
+bool DspGraph::processesAudio(const DspNode *node)
+{
+    return (node->kind() == DspNode::KIND_FILTER) || (node->kind() == DspNode::KIND_DETECTOR);
+}
+
+
+/*!
+  indexOf returns the index of the node of the given name, -1 if unknown.
+*/
+int DspGraph::indexOf(const QString &name) const
+{
+    for (int i = 0; i < itsEntries.size(); ++i)
+        if (itsEntries.at(i).name == name)
+            return i;
+
+    return -1;
+}
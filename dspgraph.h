@@ -0,0 +1,222 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef DSPGRAPH_H
+#define DSPGRAPH_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+#include <QMutex>
+
+
+// forward class declarations
+class QRunnable;
+class TaskPool;
+
+
+/*!
+  DspNode is a stage of a DspGraph. Filters transform the audio of their input
+  into a buffer of the graph, detectors rate the audio of their input and
+  aggregators combine the values of other nodes. Level nodes report the value
+  given to the decision, which is the peak level of the audio. Each node
+  provides a value in percent at every decision, filters just report 0.
+*/
+class DspNode
+{
+public:
+    enum Kind {
+        KIND_FILTER,
+        KIND_DETECTOR,
+        KIND_AGGREGATOR,
+        KIND_LEVEL
+    };
+
+    explicit DspNode(Kind kind);
+    virtual ~DspNode();
+
+    Kind kind() const;
+
+    //! prepares the node for audio of the given rate, false on invalid parameters
+    virtual bool setup(int rate, const QVariantMap &parameters) = 0;
+    virtual void reset();
+
+    //! processes the input audio, filters write the same number of frames to
+    //! output, which may be the input itself
+    virtual void write(const qint16 *input, int frames, qint16 *output);
+    //! returns the value of the current decision, given the values of all nodes
+    //! and the indices of the input nodes
+    virtual int value(const int *values, const QVector<int> &inputs) = 0;
+
+private:
+    Kind itsKind;
+};
+
+
+/*!
+  DspGraph runs the stages rating the S16 mono audio of the analysis rate. The
+  nodes are connected by name and executed in topological order. Audio is
+  processed in blocks of at most BLOCK_SIZE frames, the filter outputs share a
+  pool of block buffers: a buffer is reused as soon as the last consumer of the
+  filter output has run. All buffers are allocated by schedule, processing the
+  audio does not allocate memory.
+
+  The nodes processing audio are grouped into levels: the nodes of the audio
+  input form the first level, the nodes of a filter output the level after the
+  filter. The nodes of a level are independent of each other. With a task pool,
+  they run in parallel, so a level takes about as long as its slowest node.
+  A filter only processes its input buffer in place if it is its only reader.
+
+  At each decision, evaluate computes the values of all nodes. The audio passes
+  the graph if the value of its gate node reaches GATE_LEVEL, the value of the
+  probability node is reported as cry probability. The graph keeps statistics
+  of the processing time of each node and of how often each input of the gate
+  agreed with its decision.
+
+  A graph can be loaded from an INI file. Each group defines a node of the
+  group name with its type and parameters, the group "pipeline" names the gate
+  and probability nodes. The audio input is called "audio".
+  - dcblock: filter removing DC and rumble, below cutoff Hz (default 20)
+  - spectral: SpectralDetector score of input (default "audio")
+  - goertzel: GoertzelBank score of the given frequencies in Hz
+  - pitch: PitchDetector score
+  - classifier: CryClassifier probability of the given model file
+  - level: peak level of the audio, 100 if above the volume threshold
+  - threshold: 100 if the value of input reaches threshold, otherwise 0
+  - all, any, mean: minimum, maximum or mean value of inputs
+  - vote: 100 if at least quorum inputs (default the majority) reach GATE_LEVEL
+  - weighted: mean value of inputs, weighted by the list weights (default 1)
+  For example:
+
+    [pipeline]
+    gate=gate
+    probability=cry
+    [clean]
+    type=dcblock
+    [pitch]
+    type=pitch
+    input=clean
+    [pitchGate]
+    type=threshold
+    input=pitch
+    threshold=40
+    [cry]
+    type=classifier
+    model=/home/user/cry.model
+    [cryGate]
+    type=threshold
+    input=cry
+    threshold=60
+    [gate]
+    type=all
+    inputs=pitchGate, cryGate
+*/
+class DspGraph
+{
+public:
+    //! maximum number of frames processed at once
+    const static int BLOCK_SIZE = 1024;
+    //! minimum value of the gate node for the audio to pass, in percent
+    const static int GATE_LEVEL = 50;
+
+    DspGraph();
+    ~DspGraph();
+
+    void setup(int rate);
+    void setPool(TaskPool *pool);
+    bool addNode(const QString &name, const QString &type, const QVariantMap &parameters);
+    bool schedule(const QString &gate, const QString &probability);
+    bool load(const QString &fileName, int rate);
+    void clear();
+
+    bool isEmpty() const;
+    int buffers() const;
+    int levels() const;
+    bool checkBuffers() const;
+    bool usesLevel() const;
+    void reset();
+
+    void write(const qint16 *data, int frames);
+    void evaluate(int level = 0);
+    bool passes() const;
+    int probability() const;
+    QString statistics() const;
+
+private:
+    //! a node of the graph with its connections
+    struct Entry {
+        QString name;
+        DspNode *node;
+        //! input node names and indices, -1 for the audio input
+        QStringList inputNames;
+        QVector<int> inputs;
+        //! buffers of the input audio and of the filter output, -1 for none
+        int source;
+        int target;
+    };
+
+    static DspNode *createNode(const QString &type);
+    static bool processesAudio(const DspNode *node);
+    int indexOf(const QString &name) const;
+    void updateStatistics();
+
+    //! audio sample rate of the nodes
+    int itsRate;
+    //! pool running the nodes of a level in parallel, 0 for none
+    TaskPool *itsPool;
+
+    //! all nodes, in order of creation
+    QVector<Entry> itsEntries;
+    //! node indices in topological order, all and those processing audio
+    QVector<int> itsOrder;
+    QVector<int> itsAudioOrder;
+    //! first position in itsAudioOrder of each level, and the end position
+    QVector<int> itsLevels;
+    //! the task processing a block by each node of itsAudioOrder
+    QVector<QRunnable*> itsTasks;
+    //! determines whether the graph has a level node
+    bool itsUsesLevel;
+
+    //! the block buffers of the filter outputs
+    QVector< QVector<qint16> > itsBuffers;
+
+    //! node values of the current decision
+    QVector<int> itsValues;
+    //! gate and probability node, -1 for none
+    int itsGate;
+    int itsProbability;
+
+    //! processing time in us and number of blocks since the last decision
+    qint64 itsWallTime;
+    int itsBlocks;
+
+    //! protects the statistics below, read by other threads
+    mutable QMutex itsStatisticsLock;
+    //! names of the nodes of itsAudioOrder and of the gate inputs
+    QStringList itsAudioNames;
+    QStringList itsGateNames;
+    //! summed processing time in us of each node of itsAudioOrder and of all
+    qint64 itsTotalWallTime;
+    QVector<qint64> itsTotalTimes;
+    int itsTotalBlocks;
+    //! number of decisions each gate input agreed with the gate, and of all
+    QVector<int> itsAgreements;
+    int itsDecisions;
+};
+
+#endif // DSPGRAPH_H
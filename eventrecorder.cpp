@@ -0,0 +1,220 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "eventrecorder.h"
+#include "audiohistory.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+#include <QDebug>
+
+
+const char * const EventRecorder::INDEX_FILE = "babyphone-clips.txt";
+
+
+/*!
+  The constructor sets up an idle recorder. The thread needs to be started by
+  the caller.
+*/
+EventRecorder::EventRecorder(QObject *parent)
+    : QThread(parent), itsStopRequest(false)
+{
+}
+
+
+/*!
+  The destructor writes the pending clips and terminates the thread.
+*/
+EventRecorder::~EventRecorder()
+{
+    stop();
+}
+
+
+/*!
+  record queues a clip of the given audio history blocks and sample rate, to be
+  written to the given file. The history ends now, its start time, the given
+  peak volume and the maximum audio counter are listed in the clip index.
+  Afterwards, the oldest clips are deleted until all of them fit into the given
+  quota in bytes.
+*/
+void EventRecorder::record(const QString &fileName, int rate, const QByteArray &blocks,
+                           int peak, int counter, qint64 quota)
+{
+    Clip clip;
+    clip.fileName = fileName;
+    clip.rate = rate;
+    clip.blocks = blocks;
+    clip.start = QDateTime::currentDateTime().addMSecs(-duration(clip));
+    clip.peak = peak;
+    clip.counter = counter;
+    clip.quota = quota;
+
+    QMutexLocker locker(&itsLock);
+    itsQueue.append(clip);
+    itsWakeUp.wakeOne();
+}
+
+
+/*!
+  stop writes the pending clips, terminates the thread and waits for its end.
+*/
+void EventRecorder::stop()
+{
+    itsLock.lock();
+    itsStopRequest = true;
+    itsWakeUp.wakeOne();
+    itsLock.unlock();
+
+    wait();
+}
+
+
+/*!
+  run writes the queued clips. On termination, the pending clips are written
+  first.
+*/
+void EventRecorder::run()
+{
+    QMutexLocker locker(&itsLock);
+    forever {
+        while ( (itsQueue.isEmpty()) && (!itsStopRequest) )
+            itsWakeUp.wait(&itsLock);
+        if (itsQueue.isEmpty())
+            break;
+
+        Clip clip = itsQueue.takeFirst();
+        locker.unlock();
+        writeClip(clip);
+        locker.relock();
+    }
+}
+
+
+/*!
+  writeClip writes the clip file and appends its entry to the clip index. An
+  entry is a line of tab separated fields: the file name, the start time, the
+  duration in milliseconds, the peak volume and the maximum audio counter.
+*/
+void EventRecorder::writeClip(const Clip &clip)
+{
+    WavWriter writer;
+    if (!writer.openAdpcm(clip.fileName, clip.rate, AudioHistory::BLOCK_BYTES,
+                          AudioHistory::BLOCK_SAMPLES)) {
+        qWarning() << "Cannot create event clip" << clip.fileName << ":" << writer.errorString();
+        return;
+    }
+
+    int blocks = clip.blocks.size() / AudioHistory::BLOCK_BYTES;
+    if ( !writer.writeBlocks(clip.blocks.constData(), blocks) || !writer.close() ) {
+        qWarning() << "Cannot write event clip" << clip.fileName << ":" << writer.errorString();
+        return;
+    }
+
+    QFileInfo info(clip.fileName);
+    QFile index(info.dir().filePath(INDEX_FILE));
+    if (index.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        QTextStream out(&index);
+        out << info.fileName() << '\t' << clip.start.toString(Qt::ISODate)
+            << '\t' << duration(clip) << '\t' << clip.peak
+            << '\t' << clip.counter << '\n';
+        out.flush();
+        index.close();
+    }
+    else {
+        qWarning() << "Cannot write clip index" << index.fileName() << ":" << index.errorString();
+    }
+
+    qDebug() << "Recorded event clip" << info.filePath() << "of" << duration(clip) << "ms";
+
+    enforceQuota(info.absolutePath(), clip.quota);
+}
+
+
+/*!
+  duration returns the duration of the clip audio in milliseconds.
+*/
+qint64 EventRecorder::duration(const Clip &clip)
+{
+    if (clip.rate <= 0)
+        return 0;
+
+    int blocks = clip.blocks.size() / AudioHistory::BLOCK_BYTES;
+    return (qint64)blocks * AudioHistory::BLOCK_SAMPLES * 1000 / clip.rate;
+}
+
+
+/*!
+  enforceQuota deletes the oldest indexed clips of the directory until the
+  remaining ones fit into the quota. The latest clip is always kept. Entries of
+  clips deleted by the user are dropped from the index.
+*/
+void EventRecorder::enforceQuota(const QString &directory, qint64 quota)
+{
+    QDir dir(directory);
+    QFile index(dir.filePath(INDEX_FILE));
+    if (!index.open(QIODevice::ReadOnly | QIODevice::Text))
+        return;
+
+    QStringList entries;
+    QList<qint64> sizes;
+    qint64 total = 0;
+    bool changed = false;
+    while (!index.atEnd()) {
+        QString entry = QString::fromUtf8(index.readLine()).trimmed();
+        if (entry.isEmpty())
+            continue;
+
+        QFileInfo clip(dir.filePath(entry.section('\t', 0, 0)));
+        if (!clip.exists()) {
+            changed = true;
+            continue;
+        }
+
+        entries.append(entry);
+        sizes.append(clip.size());
+        total += clip.size();
+    }
+    index.close();
+
+    // the index lists the clips in recording order
+    while ( (total > quota) && (entries.size() > 1) ) {
+        QString fileName = dir.filePath(entries.first().section('\t', 0, 0));
+        if (!QFile::remove(fileName))
+            qWarning() << "Cannot delete event clip" << fileName;
+        else
+            qDebug() << "Deleted event clip" << fileName << "to keep the disk quota";
+
+        total -= sizes.takeFirst();
+        entries.removeFirst();
+        changed = true;
+    }
+
+    if (!changed)
+        return;
+
+    if (!index.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning() << "Cannot write clip index" << index.fileName() << ":" << index.errorString();
+        return;
+    }
+    QTextStream out(&index);
+    foreach (const QString &entry, entries)
+        out << entry << '\n';
+}
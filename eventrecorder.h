@@ -0,0 +1,98 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef EVENTRECORDER_H
+#define EVENTRECORDER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+#include "wavwriter.h"
+
+
+/*!
+  EventRecorder stores the audio history of a notification event as clip file.
+
+  The audio arrives as the IMA ADPCM blocks of the AudioHistory, which are
+  stored unchanged as IMA ADPCM WAV file. record only queues the blocks, the
+  writer thread performs all file accesses, such that the disk latency never
+  holds up the audio capturing.
+
+  Each clip is listed in an index file of the clip directory with its start
+  time, duration, peak volume and maximum audio counter. The oldest clips get
+  deleted as the clips exceed the disk quota.
+*/
+class EventRecorder : public QThread
+{
+    Q_OBJECT
+public:
+    explicit EventRecorder(QObject *parent = 0);
+    ~EventRecorder();
+
+    void record(const QString &fileName, int rate, const QByteArray &blocks,
+                int peak, int counter, qint64 quota);
+
+    void stop();
+
+protected:
+    void run();
+
+private:
+    //! name of the clip index file in the clip directory
+    static const char * const INDEX_FILE;
+
+    /*!
+      Clip is a job of the writer thread.
+    */
+    struct Clip
+    {
+        //! file name of the clip
+        QString fileName;
+        //! sample rate
+        int rate;
+        //! the audio history blocks
+        QByteArray blocks;
+        //! start time of the clip
+        QDateTime start;
+        //! peak volume of the clip
+        int peak;
+        //! maximum audio counter of the clip
+        int counter;
+        //! disk quota of all clips in bytes
+        qint64 quota;
+    };
+
+    static qint64 duration(const Clip &clip);
+    void writeClip(const Clip &clip);
+    void enforceQuota(const QString &directory, qint64 quota);
+
+    //! protects the clip queue
+    QMutex itsLock;
+    //! signals new clips to the writer thread
+    QWaitCondition itsWakeUp;
+    //! the pending clips of the writer thread
+    QList<Clip> itsQueue;
+    //! set as the thread shall terminate
+    bool itsStopRequest;
+};
+
+#endif // EVENTRECORDER_H
@@ -0,0 +1,296 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "fingerprinter.h"
+
+#include <cmath>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+// rise of the background power per frame, about 0.5 dB per second at 8 kHz
+static const float FLOOR_RISE = 1.002f;
+
+
+/*!
+  The constructor sets up a disabled fingerprinter.
+*/
+Fingerprinter::Fingerprinter()
+    : itsRate(0), itsIndex(0), itsRecentHead(0), itsRecentCount(0),
+      itsPeriodFrames(1)
+{
+    for (int n = 0; n < FRAME_SIZE; ++n)
+        itsWindow[n] = 0.5f - 0.5f * cos(2 * M_PI * n / FRAME_SIZE);
+
+    reset();
+}
+
+
+/*!
+  setup enables the fingerprinting of audio of the given sample rate against
+  the given index. Without index, or for an index of another sample rate, it
+  is disabled.
+*/
+void Fingerprinter::setup(int rate, const FingerprintIndex *index)
+{
+    itsIndex = index;
+    itsRate = ( (index != 0) && (index->rate() == rate) ) ? rate : 0;
+    itsPeriodFrames = qMax(1, itsRate / HOP_SIZE);
+
+    // the recent landmarks are allocated once
+    QMutexLocker locker(&itsLock);
+    itsRecent.fill(Landmark(), isEnabled() ? RECENT_DURATION * itsPeriodFrames * PEAKS * FAN_OUT : 0);
+    itsRecentHead = 0;
+    itsRecentCount = 0;
+    locker.unlock();
+
+    reset();
+}
+
+
+/*!
+  isEnabled returns true if the fingerprinter is set up for an index.
+*/
+bool Fingerprinter::isEnabled() const
+{
+    return itsRate > 0;
+}
+
+
+/*!
+  reset drops the buffered audio, the peaks and the votes, as for a new audio
+  stream. The recent landmarks are kept.
+*/
+void Fingerprinter::reset()
+{
+    for (int n = 0; n < FRAME_SIZE; ++n)
+        itsFrame[n] = 0;
+    itsFill = 0;
+    itsTime = 0;
+    itsFloor = 0;
+
+    for (int t = 0; t < MAX_DELTA; ++t)
+        itsPeakCount[t] = 0;
+
+    memset(itsVotes, 0, sizeof(itsVotes));
+    itsLandmarks[0] = 0;
+    itsLandmarks[1] = 0;
+    itsPeriod = 0;
+    itsPeriodStart = 0;
+    itsSinceMatch = itsPeriodFrames + 1;
+}
+
+
+/*!
+  write fingerprints the given S16 mono samples. Each time a frame is
+  complete, it is processed and the frame moves on by HOP_SIZE samples.
+*/
+void Fingerprinter::write(const qint16 *samples, int count)
+{
+    if (!isEnabled())
+        return;
+
+    while (count > 0) {
+        int n = qMin(count, HOP_SIZE - itsFill);
+        float *frame = itsFrame + HOP_SIZE + itsFill;
+        for (int i = 0; i < n; ++i)
+            frame[i] = samples[i];
+
+        itsFill += n;
+        samples += n;
+        count -= n;
+
+        if (itsFill == HOP_SIZE) {
+            processFrame();
+            itsFill = 0;
+        }
+    }
+}
+
+
+/*!
+  isMatching returns true if a sound of the index was recognized within the
+  last second.
+*/
+bool Fingerprinter::isMatching() const
+{
+    return isEnabled() && (itsSinceMatch <= itsPeriodFrames);
+}
+
+
+/*!
+  recent returns the landmarks of the last RECENT_DURATION seconds, oldest
+  first. It may be called by any thread.
+*/
+QVector<Landmark> Fingerprinter::recent() const
+{
+    QMutexLocker locker(&itsLock);
+    QVector<Landmark> landmarks(itsRecentCount);
+    for (int i = 0; i < itsRecentCount; ++i)
+        landmarks[i] = itsRecent.at((itsRecentHead + i) % itsRecent.size());
+
+    return landmarks;
+}
+
+
+/*!
+  processFrame determines the peaks of the current frame, if it belongs to an
+  event, and pairs them with the peaks of the preceding frames to landmarks.
+  The landmarks are kept and looked up in the index.
+*/
+void Fingerprinter::processFrame()
+{
+    float samples[FRAME_SIZE];
+    for (int n = 0; n < FRAME_SIZE; ++n)
+        samples[n] = itsWindow[n] * itsFrame[n];
+    // the second half of the frame becomes the first half of the next one
+    memcpy(itsFrame, itsFrame + HOP_SIZE, HOP_SIZE * sizeof(float));
+
+    float re[BINS + 1];
+    float im[BINS + 1];
+    SpectralDetector::transform(samples, re, im);
+
+    float power[BINS];
+    float total = 0;
+    for (int k = MIN_BIN; k < BINS; ++k) {
+        power[k] = re[k]*re[k] + im[k]*im[k];
+        total += power[k];
+    }
+
+    // track the background, events rise well above it
+    itsFloor = ( (total < itsFloor) || (itsFloor <= 0) ) ? total : itsFloor * FLOOR_RISE;
+    const int slot = itsTime % MAX_DELTA;
+    itsPeakCount[slot] = 0;
+    if ( (total > 0) && (total >= EVENT_LEVEL * itsFloor) ) {
+        // the strongest local maxima above the mean power
+        const float mean = total / (BINS - MIN_BIN);
+        int *peaks = itsPeaks[slot];
+        int &count = itsPeakCount[slot];
+        for (int k = MIN_BIN + 1; k < BINS - 1; ++k) {
+            if ( (power[k] <= mean) || (power[k] <= power[k-1]) || (power[k] < power[k+1]) )
+                continue;
+
+            int i = qMin(count, PEAKS - 1);
+            if ( (count == PEAKS) && (power[k] <= power[peaks[i]]) )
+                continue;
+            while ( (i > 0) && (power[peaks[i-1]] < power[k]) ) {
+                peaks[i] = peaks[i-1];
+                --i;
+            }
+            peaks[i] = k;
+            count = qMin(count + 1, (int)PEAKS);
+        }
+
+        // pair each peak with the peaks of the closest preceding frames
+        Landmark landmarks[PEAKS * FAN_OUT];
+        int found = 0;
+        for (int p = 0; p < count; ++p) {
+            int pairs = 0;
+            for (int delta = 1; (delta < MAX_DELTA) && (pairs < FAN_OUT); ++delta) {
+                int anchor = (itsTime - delta + MAX_DELTA) % MAX_DELTA;
+                for (int a = 0; (a < itsPeakCount[anchor]) && (pairs < FAN_OUT); ++a) {
+                    Landmark &landmark = landmarks[found++];
+                    landmark.hash = (itsPeaks[anchor][a] << 13) | (peaks[p] << 6) | delta;
+                    landmark.time = itsTime - delta;
+                    pairs++;
+                }
+            }
+        }
+
+        if (found > 0) {
+            QMutexLocker locker(&itsLock);
+            for (int i = 0; i < found; ++i) {
+                int end = (itsRecentHead + itsRecentCount) % itsRecent.size();
+                itsRecent[end] = landmarks[i];
+                if (itsRecentCount < itsRecent.size())
+                    itsRecentCount++;
+                else
+                    itsRecentHead = (itsRecentHead + 1) % itsRecent.size();
+            }
+        }
+
+        itsLandmarks[itsPeriod] += found;
+        for (int i = 0; i < found; ++i)
+            vote(landmarks[i]);
+    }
+
+    itsTime++;
+    itsSinceMatch = qMin(itsSinceMatch + 1, itsPeriodFrames + 1);
+
+    // the oldest period gets dropped
+    if (itsTime - itsPeriodStart >= itsPeriodFrames) {
+        itsPeriod ^= 1;
+        memset(itsVotes[itsPeriod], 0, sizeof(itsVotes[itsPeriod]));
+        itsLandmarks[itsPeriod] = 0;
+        itsPeriodStart = itsTime;
+    }
+}
+
+
+/*!
+  vote counts the matches of the given landmark per sound and time offset. A
+  sound with enough votes at an offset over the current and the previous
+  period is recognized.
+*/
+void Fingerprinter::vote(const Landmark &landmark)
+{
+    FingerprintIndex::Posting postings[MAX_POSTINGS];
+    int count = itsIndex->lookup(landmark.hash, postings, MAX_POSTINGS);
+
+    const int landmarks = itsLandmarks[0] + itsLandmarks[1];
+    for (int i = 0; i < count; ++i) {
+        int sound = postings[i].sound;
+        int offset = (landmark.time - postings[i].time) / OFFSET_QUANTUM;
+        Vote *current = findVote(itsPeriod, sound, offset, true);
+        if (current == 0)
+            continue;
+
+        current->count++;
+        const Vote *previous = findVote(itsPeriod ^ 1, sound, offset, false);
+        int votes = current->count + (previous ? previous->count : 0);
+        if ( (votes >= MIN_VOTES) && (votes * 100 >= MATCH_SHARE * landmarks) )
+            itsSinceMatch = 0;
+    }
+}
+
+
+/*!
+  findVote returns the vote of the given sound and offset of the given table.
+  An unknown vote is inserted, if demanded and if one of the probed slots is
+  free, otherwise 0 is returned.
+*/
+Fingerprinter::Vote *Fingerprinter::findVote(int table, int sound, int offset, bool insert)
+{
+    quint32 slot = ((quint32)offset * 2654435761u) ^ ((quint32)sound * 40503u);
+    for (int probe = 0; probe < VOTE_PROBES; ++probe) {
+        Vote &vote = itsVotes[table][(slot + probe) % VOTE_SLOTS];
+        if ( (vote.count > 0) && (vote.sound == sound) && (vote.offset == offset) )
+            return &vote;
+        if (vote.count == 0) {
+            if (!insert)
+                return 0;
+            vote.sound = sound;
+            vote.offset = offset;
+            return &vote;
+        }
+    }
+
+    return 0;
+}
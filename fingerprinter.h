@@ -0,0 +1,144 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef FINGERPRINTER_H
+#define FINGERPRINTER_H
+
+#include <QtGlobal>
+#include <QVector>
+#include <QMutex>
+#include "spectraldetector.h"
+#include "fingerprintindex.h"
+
+
+/*!
+  Fingerprinter recognizes recurring sounds of the FingerprintIndex in the S16
+  mono audio by landmarks of its spectrogram.
+
+  The audio is split into frames of FRAME_SIZE samples, overlapping by half,
+  which get a Hann window and the FFT of the SpectralDetector. Only frames of
+  events, EVENT_LEVEL above the background, get landmarks: their strongest
+  PEAKS spectral peaks are paired with the peaks of up to FAN_OUT preceding
+  frames of at most MAX_DELTA frames distance. A landmark hashes the two peak
+  frequencies and their distance, so it does not depend on the loudness.
+
+  Each landmark is looked up in the index. The landmarks of a known sound match
+  at the same time offset against the sound, so the matches are counted per
+  sound and offset over the last second or two. A sound is recognized if its
+  count reaches MIN_VOTES and MATCH_SHARE of the landmarks of that time. The
+  votes are kept in tables of fixed size, so each frame takes constant time.
+
+  The landmarks of the last RECENT_DURATION seconds are kept, such that a sound
+  can be added to the index right after it occurred. write is called by the
+  analysis thread, recent by any other thread.
+*/
+class Fingerprinter
+{
+public:
+    //! number of samples of a frame, the FFT size
+    const static int FRAME_SIZE = SpectralDetector::FFT_SIZE;
+    //! seconds of landmarks kept for learning a sound
+    const static int RECENT_DURATION = 10;
+
+    Fingerprinter();
+
+    void setup(int rate, const FingerprintIndex *index);
+    bool isEnabled() const;
+    void reset();
+
+    void write(const qint16 *samples, int count);
+    bool isMatching() const;
+    QVector<Landmark> recent() const;
+
+private:
+    //! number of new samples per frame, half the frame size
+    const static int HOP_SIZE = FRAME_SIZE / 2;
+    //! number of bins below the Nyquist frequency, 7 bits of the hash
+    const static int BINS = FRAME_SIZE / 2;
+    //! lowest bin of a peak, above DC and rumble
+    const static int MIN_BIN = 3;
+    //! maximum number of peaks per frame
+    const static int PEAKS = 3;
+    //! maximum distance in frames of the peaks of a landmark, 6 bits of the hash
+    const static int MAX_DELTA = 32;
+    //! maximum number of landmarks per peak
+    const static int FAN_OUT = 3;
+    //! minimum power of an event frame, relative to the background
+    const static int EVENT_LEVEL = 10;
+    //! maximum number of matches taken per landmark
+    const static int MAX_POSTINGS = 16;
+    //! size of a vote table, a power of two, and the slots probed per vote
+    const static int VOTE_SLOTS = 256;
+    const static int VOTE_PROBES = 8;
+    //! frames of one time offset vote, tolerating the frame jitter
+    const static int OFFSET_QUANTUM = 2;
+    //! minimum votes of a sound, absolute and in percent of the landmarks
+    const static int MIN_VOTES = 8;
+    const static int MATCH_SHARE = 20;
+
+    //! votes of a sound at a time offset
+    struct Vote {
+        qint32 offset;
+        qint32 sound;
+        int count;
+    };
+
+    void processFrame();
+    void vote(const Landmark &landmark);
+    Vote *findVote(int table, int sound, int offset, bool insert);
+
+    //! sample rate, 0 if disabled
+    int itsRate;
+    //! the sounds to recognize
+    const FingerprintIndex *itsIndex;
+
+    //! Hann window of the frames
+    float itsWindow[FRAME_SIZE];
+    //! samples of the current frame, its second half still filling
+    float itsFrame[FRAME_SIZE];
+    //! number of new samples of the current frame
+    int itsFill;
+    //! number of the current frame
+    int itsTime;
+    //! background power of a frame, rising slowly and falling at once
+    float itsFloor;
+
+    //! peak bins of the last MAX_DELTA frames, indexed by frame modulo MAX_DELTA
+    int itsPeaks[MAX_DELTA][PEAKS];
+    int itsPeakCount[MAX_DELTA];
+
+    //! protects the recent landmarks
+    mutable QMutex itsLock;
+    //! ring of the recent landmarks, allocated by setup
+    QVector<Landmark> itsRecent;
+    //! position of the oldest recent landmark and their number
+    int itsRecentHead;
+    int itsRecentCount;
+
+    //! vote tables of the current and the previous period
+    Vote itsVotes[2][VOTE_SLOTS];
+    //! number of landmarks of each period
+    int itsLandmarks[2];
+    //! the table of the current period, the frame it started and its length
+    int itsPeriod;
+    int itsPeriodStart;
+    int itsPeriodFrames;
+    //! frames since the last match
+    int itsSinceMatch;
+};
+
+#endif // FINGERPRINTER_H
@@ -0,0 +1,287 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "fingerprintindex.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QtAlgorithms>
+#include <string.h>
+
+
+const char FingerprintIndex::MAGIC[8] = { 'B', 'P', 'I', 'G', 'N', 'O', 'R', 'E' };
+
+
+/*!
+  The constructor sets up an empty index for landmarks of the given sample
+  rate.
+*/
+FingerprintIndex::FingerprintIndex(int rate, QObject *parent)
+    : QObject(parent), itsRate(rate), itsSounds(0),
+      itsDirectory(buildDirectory(itsEntries))
+{
+}
+
+
+/*!
+  rate returns the sample rate of the landmarks.
+*/
+int FingerprintIndex::rate() const
+{
+    return itsRate;
+}
+
+
+/*!
+  sounds returns the number of sounds of the index.
+*/
+int FingerprintIndex::sounds() const
+{
+    QMutexLocker locker(&itsLock);
+    return itsSounds;
+}
+
+
+/*!
+  size returns the number of landmarks of all sounds.
+*/
+int FingerprintIndex::size() const
+{
+    QMutexLocker locker(&itsLock);
+    return itsEntries.size();
+}
+
+
+/*!
+  load replaces the index by the given index file. A missing file just leaves
+  the index empty. On errors, or if the file is of a different layout or sample
+  rate, the index is cleared and false is returned.
+*/
+bool FingerprintIndex::load(const QString &fileName)
+{
+    QMutexLocker writeLocker(&itsWriteLock);
+    replace(QVector<Entry>(), 0);
+
+    QFile file(fileName);
+    if (!file.exists())
+        return true;
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open ignored sounds" << fileName << ":" << file.errorString();
+        return false;
+    }
+
+    Header header;
+    if ( (file.read((char*)&header, sizeof(header)) != sizeof(header)) ||
+         (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) ||
+         (header.version != VERSION) || (header.entrySize != sizeof(Entry)) ||
+         ((int)header.rate != itsRate) || (header.sounds > (quint32)MAX_SOUNDS) ||
+         (file.size() != (qint64)(sizeof(header) + header.count * sizeof(Entry))) ) {
+        qWarning() << "Not an index of ignored sounds at" << itsRate << "Hz:" << fileName;
+        return false;
+    }
+
+    // the entries are stored sorted, they are only checked
+    QVector<Entry> entries(header.count);
+    qint64 bytes = header.count * sizeof(Entry);
+    if (file.read((char*)entries.data(), bytes) != bytes) {
+        qWarning() << "Cannot read ignored sounds" << fileName << ":" << file.errorString();
+        return false;
+    }
+    for (int i = 0; i < entries.size(); ++i) {
+        if ( (entries.at(i).posting.sound >= header.sounds) ||
+             ((i > 0) && lessThan(entries.at(i), entries.at(i-1))) ) {
+            qWarning() << "Corrupt index of ignored sounds:" << fileName;
+            return false;
+        }
+    }
+
+    replace(entries, header.sounds);
+
+    qDebug() << "Loaded" << header.sounds << "ignored sounds of" << entries.size() << "landmarks";
+    return true;
+}
+
+
+/*!
+  save writes the index to the given file. The file is replaced only once the
+  new one is complete. The entries are shared with the index while they are
+  written, so lookups do not wait for the file. It returns false on errors.
+*/
+bool FingerprintIndex::save(const QString &fileName) const
+{
+    QMutexLocker locker(&itsLock);
+    const QVector<Entry> entries = itsEntries;
+    const int sounds = itsSounds;
+    locker.unlock();
+
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.entrySize = sizeof(Entry);
+    header.rate = itsRate;
+    header.sounds = sounds;
+    header.count = entries.size();
+
+    QFile file(fileName + ".new");
+    qint64 bytes = entries.size() * sizeof(Entry);
+    if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+         (file.write((const char*)&header, sizeof(header)) != sizeof(header)) ||
+         (file.write((const char*)entries.constData(), bytes) != bytes) ) {
+        qWarning() << "Cannot write ignored sounds" << file.fileName() << ":" << file.errorString();
+        file.remove();
+        return false;
+    }
+    file.close();
+
+    QFile::remove(fileName);
+    if (!file.rename(fileName)) {
+        qWarning() << "Cannot replace ignored sounds" << fileName << ":" << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+
+/*!
+  clear removes all sounds.
+*/
+void FingerprintIndex::clear()
+{
+    QMutexLocker writeLocker(&itsWriteLock);
+    replace(QVector<Entry>(), 0);
+}
+
+
+/*!
+  addSound adds a sound of the given landmarks, as determined by Fingerprinter.
+  The landmark times are taken relative to the first one. The entries are
+  sorted aside, the lookups continue meanwhile. It returns the number of the
+  new sound, or -1 if there are no landmarks or too many sounds.
+*/
+int FingerprintIndex::addSound(const QVector<Landmark> &landmarks)
+{
+    if (landmarks.isEmpty())
+        return -1;
+
+    QMutexLocker writeLocker(&itsWriteLock);
+    QMutexLocker locker(&itsLock);
+    QVector<Entry> entries = itsEntries;
+    const int sound = itsSounds;
+    locker.unlock();
+
+    if (sound >= MAX_SOUNDS) {
+        qWarning() << "Cannot ignore more than" << MAX_SOUNDS << "sounds";
+        return -1;
+    }
+
+    qint32 start = landmarks.first().time;
+    foreach (const Landmark &landmark, landmarks)
+        start = qMin(start, landmark.time);
+
+    entries.reserve(entries.size() + landmarks.size());
+    foreach (const Landmark &landmark, landmarks) {
+        Entry entry;
+        entry.hash = landmark.hash & ((1 << HASH_BITS) - 1);
+        entry.posting.sound = sound;
+        entry.posting.time = qMin(landmark.time - start, 0xffff);
+        entries.append(entry);
+    }
+    qSort(entries.begin(), entries.end(), lessThan);
+    replace(entries, sound + 1);
+
+    qDebug() << "Ignoring sound" << sound << "of" << landmarks.size() << "landmarks";
+    return sound;
+}
+
+
+/*!
+  lookup copies up to the given number of landmarks of the given hash to result
+  and returns their number.
+*/
+int FingerprintIndex::lookup(quint32 hash, Posting *result, int maxCount) const
+{
+    hash &= (1 << HASH_BITS) - 1;
+
+    QMutexLocker locker(&itsLock);
+    int bucket = hash >> (HASH_BITS - BUCKET_BITS);
+    int end = itsDirectory.at(bucket + 1);
+    int count = 0;
+    for (int i = itsDirectory.at(bucket); (i < end) && (count < maxCount); ++i) {
+        const Entry &entry = itsEntries.at(i);
+        if (entry.hash == hash)
+            result[count++] = entry.posting;
+        else if (entry.hash > hash)
+            break;
+    }
+
+    return count;
+}
+
+
+/*!
+  lessThan orders the entries by hash, then by sound and time.
+*/
+bool FingerprintIndex::lessThan(const Entry &a, const Entry &b)
+{
+    if (a.hash != b.hash)
+        return a.hash < b.hash;
+    if (a.posting.sound != b.posting.sound)
+        return a.posting.sound < b.posting.sound;
+    return a.posting.time < b.posting.time;
+}
+
+
+/*!
+  buildDirectory returns the position of the first entry of each bucket of the
+  given sorted entries, followed by the end position.
+*/
+QVector<int> FingerprintIndex::buildDirectory(const QVector<Entry> &entries)
+{
+    const int buckets = 1 << BUCKET_BITS;
+    QVector<int> directory(buckets + 1);
+
+    int i = 0;
+    for (int bucket = 0; bucket < buckets; ++bucket) {
+        directory[bucket] = i;
+        while ( (i < entries.size()) &&
+                ((int)(entries.at(i).hash >> (HASH_BITS - BUCKET_BITS)) == bucket) )
+            ++i;
+    }
+    directory[buckets] = entries.size();
+
+    return directory;
+}
+
+
+/*!
+  replace makes the given sorted entries of the given number of sounds the
+  index. The directory is built before, the lookups are only blocked while the
+  vectors are exchanged. The old entries are released after that.
+*/
+void FingerprintIndex::replace(const QVector<Entry> &entries, int sounds)
+{
+    QVector<int> directory = buildDirectory(entries);
+
+    QMutexLocker locker(&itsLock);
+    QVector<Entry> oldEntries = itsEntries;
+    QVector<int> oldDirectory = itsDirectory;
+    itsEntries = entries;
+    itsDirectory = directory;
+    itsSounds = sounds;
+    locker.unlock();
+}
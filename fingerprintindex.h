@@ -0,0 +1,123 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef FINGERPRINTINDEX_H
+#define FINGERPRINTINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+
+
+/*!
+  Landmark is a pair of spectrogram peaks: the hash of their frequencies and
+  distance, and the frame of the first peak.
+*/
+struct Landmark
+{
+    quint32 hash;
+    qint32 time;
+};
+
+
+/*!
+  FingerprintIndex keeps the landmarks of the sounds the user marked to be
+  ignored, like the heating pump or a door. It is shared by the audio monitors,
+  which look up the landmarks of their audio by Fingerprinter.
+
+  The landmarks of all sounds are kept in one array, sorted by hash, together
+  with the sound and the frame of the sound they belong to. A directory of the
+  first entry of each bucket of BUCKET_BITS hash bits leads to the entries of a
+  hash in constant time. Adding a sound re-sorts a copy of the array, which is
+  swapped in with its directory, so lookups only wait for the swap. Lookups do
+  not allocate memory.
+
+  The index file is the sorted array behind a small header, so loading it is a
+  single read and a pass to build the directory. The file uses the native byte
+  order, it is not meant to be moved between devices.
+*/
+class FingerprintIndex : public QObject
+{
+    Q_OBJECT
+public:
+    //! number of significant bits of a landmark hash
+    const static int HASH_BITS = 20;
+    //! maximum number of sounds
+    const static int MAX_SOUNDS = 64;
+
+    //! a landmark of a sound, the frame counted from its start
+    struct Posting {
+        quint16 sound;
+        quint16 time;
+    };
+
+    explicit FingerprintIndex(int rate, QObject *parent = 0);
+
+    int rate() const;
+    int sounds() const;
+    int size() const;
+
+    bool load(const QString &fileName);
+    bool save(const QString &fileName) const;
+    void clear();
+
+    int addSound(const QVector<Landmark> &landmarks);
+    int lookup(quint32 hash, Posting *result, int maxCount) const;
+
+private:
+    //! file format identification
+    static const char MAGIC[8];
+    const static quint32 VERSION = 1;
+    //! number of hash bits selecting a bucket of the directory
+    const static int BUCKET_BITS = 14;
+
+    //! an entry of the index
+    struct Entry {
+        quint32 hash;
+        Posting posting;
+    };
+
+    //! the header of the index file, followed by the entries
+    struct Header {
+        char magic[8];
+        quint32 version;
+        quint32 entrySize;
+        quint32 rate;
+        quint32 sounds;
+        quint32 count;
+    };
+
+    static bool lessThan(const Entry &a, const Entry &b);
+    static QVector<int> buildDirectory(const QVector<Entry> &entries);
+    void replace(const QVector<Entry> &entries, int sounds);
+
+    //! protects the index, looked up by the analysis threads
+    mutable QMutex itsLock;
+    //! serializes the changes, which are prepared outside itsLock
+    QMutex itsWriteLock;
+    //! sample rate of the landmarks
+    int itsRate;
+    //! number of sounds
+    int itsSounds;
+    //! the landmarks of all sounds, sorted by hash
+    QVector<Entry> itsEntries;
+    //! position of the first entry of each bucket, and the end position
+    QVector<int> itsDirectory;
+};
+
+#endif // FINGERPRINTINDEX_H
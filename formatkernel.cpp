@@ -0,0 +1,244 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "formatkernel.h"
+
+#include <string.h>
+
+#include <QtEndian>
+
+
+/*
+  Sample readers return a single sample scaled to the S16 range.
+*/
+struct ReadU8
+{
+    enum { SIZE = 1 };
+    static inline int read(const char *p)
+    {
+        return ((int)(uchar)*p - 128) << 8;
+    }
+};
+
+template <bool Swap>
+struct ReadS16
+{
+    enum { SIZE = 2 };
+    static inline int read(const char *p)
+    {
+        quint16 value;
+        memcpy(&value, p, SIZE);
+        if (Swap)
+            value = qbswap(value);
+        return (qint16)value;
+    }
+};
+
+template <bool Swap>
+struct ReadS32
+{
+    enum { SIZE = 4 };
+    static inline int read(const char *p)
+    {
+        quint32 value;
+        memcpy(&value, p, SIZE);
+        if (Swap)
+            value = qbswap(value);
+        return (qint32)value >> 16;
+    }
+};
+
+template <bool Swap>
+struct ReadF32
+{
+    enum { SIZE = 4 };
+    static inline int read(const char *p)
+    {
+        quint32 bits;
+        memcpy(&bits, p, SIZE);
+        if (Swap)
+            bits = qbswap(bits);
+        float value;
+        memcpy(&value, &bits, SIZE);
+
+        // NaN fails all comparisons below, it is taken as silence
+        if (value != value)
+            return 0;
+
+        // scale and clip to S16 range
+        value *= 32768.0f;
+        if (value >= 32767.0f)
+            return 32767;
+        if (value <= -32768.0f)
+            return -32768;
+        return (int)value;
+    }
+};
+
+
+/*
+  analyzeFrames is the level analysis of the given sample format. A channel
+  count of 0 denotes a runtime channel count.
+*/
+template <class Reader, int Channels>
+static void analyzeFrames(const char *data, int blocks, int blockSize, int channels,
+                   LevelBlock *result)
+{
+    if (Channels > 0)
+        channels = Channels;
+    const int frameSize = channels * Reader::SIZE;
+
+    for (int b = 0; b < blocks; ++b) {
+        int max = 0;
+        quint64 energy = 0;
+
+        for (int i = 0; i < blockSize; ++i) {
+            quint64 frameEnergy = 0;
+            for (int c = 0; c < channels; ++c) {
+                int value = Reader::read(data + c*Reader::SIZE);
+                if (value > max)
+                    max = value;
+                frameEnergy += value * value;
+            }
+            energy += (Channels == 1) ? frameEnergy : frameEnergy / channels;
+
+            data += frameSize;
+        }
+
+        result[b].peak = max;
+        result[b].count = blockSize;
+        result[b].energy = energy;
+    }
+}
+
+
+/*
+  convertFrames converts the given sample format to native S16 mono. The
+  channels of a frame are averaged. A channel count of 0 denotes a runtime
+  channel count.
+*/
+template <class Reader, int Channels>
+static void convertFrames(const char *data, int frames, int channels, qint16 *result)
+{
+    if (Channels > 0)
+        channels = Channels;
+    const int frameSize = channels * Reader::SIZE;
+
+    for (int i = 0; i < frames; ++i) {
+        int sum = 0;
+        for (int c = 0; c < channels; ++c)
+            sum += Reader::read(data + c*Reader::SIZE);
+        result[i] = (Channels == 1) ? sum : sum / channels;
+
+        data += frameSize;
+    }
+}
+
+
+// dispatch tables, indexed by sample type, byte swap and channel variant
+enum { SAMPLE_U8, SAMPLE_S16, SAMPLE_S32, SAMPLE_F32, SAMPLE_TYPES };
+enum { CHANNELS_MONO, CHANNELS_STEREO, CHANNELS_ANY, CHANNEL_VARIANTS };
+
+#define FORMAT_ENTRY(Function, Reader) \
+    { Function<Reader, 1>, Function<Reader, 2>, Function<Reader, 0> }
+#define FORMAT_TABLE(Function) { \
+    { FORMAT_ENTRY(Function, ReadU8), FORMAT_ENTRY(Function, ReadU8) }, \
+    { FORMAT_ENTRY(Function, ReadS16<false>), FORMAT_ENTRY(Function, ReadS16<true>) }, \
+    { FORMAT_ENTRY(Function, ReadS32<false>), FORMAT_ENTRY(Function, ReadS32<true>) }, \
+    { FORMAT_ENTRY(Function, ReadF32<false>), FORMAT_ENTRY(Function, ReadF32<true>) } }
+
+static const FormatKernel::Function functions[SAMPLE_TYPES][2][CHANNEL_VARIANTS] =
+    FORMAT_TABLE(analyzeFrames);
+static const FormatKernel::Converter converters[SAMPLE_TYPES][2][CHANNEL_VARIANTS] =
+    FORMAT_TABLE(convertFrames);
+
+
+/*!
+  The constructor sets up an invalid kernel. setup needs to be called before
+  use.
+*/
+FormatKernel::FormatKernel()
+    : itsFunction(0), itsLevelFunction(0), itsConverter(0), itsChannels(0),
+      itsFrameSize(0)
+{
+}
+
+
+/*!
+  setup selects the analysis function for the given audio format. The given
+  LevelKernel type is used for native S16 mono audio. It returns false if the
+  format is not supported.
+*/
+bool FormatKernel::setup(const QAudioFormat &format, LevelKernel::Type level)
+{
+    itsFunction = 0;
+    itsLevelFunction = 0;
+    itsConverter = 0;
+    itsChannels = format.channels();
+    itsFrameSize = itsChannels * format.sampleSize() / 8;
+
+    int type;
+    if ((format.sampleType() == QAudioFormat::UnSignedInt) && (format.sampleSize() == 8))
+        type = SAMPLE_U8;
+    else if ((format.sampleType() == QAudioFormat::SignedInt) && (format.sampleSize() == 16))
+        type = SAMPLE_S16;
+    else if ((format.sampleType() == QAudioFormat::SignedInt) && (format.sampleSize() == 32))
+        type = SAMPLE_S32;
+    else if ((format.sampleType() == QAudioFormat::Float) && (format.sampleSize() == 32))
+        type = SAMPLE_F32;
+    else
+        return false;
+
+    if ( (itsChannels < 1) || (format.codec() != "audio/pcm") )
+        return false;
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    bool swap = (format.byteOrder() != QAudioFormat::LittleEndian);
+#else
+    bool swap = (format.byteOrder() != QAudioFormat::BigEndian);
+#endif
+
+    int channels = (itsChannels == 1) ? CHANNELS_MONO :
+                   (itsChannels == 2) ? CHANNELS_STEREO : CHANNELS_ANY;
+
+    itsFunction = functions[type][swap ? 1 : 0][channels];
+    itsConverter = converters[type][swap ? 1 : 0][channels];
+
+    // native S16 mono is handled by the SIMD kernels
+    if ((type == SAMPLE_S16) && !swap && (itsChannels == 1))
+        itsLevelFunction = LevelKernel::get(level);
+
+    return true;
+}
+
+
+/*!
+  isValid returns true if a supported audio format is set up.
+*/
+bool FormatKernel::isValid() const
+{
+    return itsFunction != 0;
+}
+
+
+/*!
+  frameSize returns the size of one audio frame in bytes.
+*/
+int FormatKernel::frameSize() const
+{
+    return itsFrameSize;
+}
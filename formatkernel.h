@@ -0,0 +1,118 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef FORMATKERNEL_H
+#define FORMATKERNEL_H
+
+#include <QAudioFormat>
+#include "levelkernel.h"
+
+
+/*!
+  FormatKernel performs the level analysis directly on the captured audio data
+  of the negotiated QAudioFormat, without converting it first.
+
+  The analysis functions are templates, specialized at compile time on the
+  sample type (U8, S16, S32, F32), the byte order and the channel count (mono,
+  stereo or any other count). All sample types are scaled to the S16 range.
+  Multichannel frames are combined in the same pass: the peak is the maximum
+  of all channels and the energy is the mean of all channels.
+
+  setup selects the matching function from a dispatch table. For native S16
+  mono audio, the SIMD LevelKernel is used instead.
+
+  For audio that needs resampling, the same specializations convert the frames
+  to native S16 mono samples, averaging the channels.
+*/
+class FormatKernel
+{
+public:
+    //! signature of the analysis functions
+    typedef void (*Function)(const char *data, int blocks, int blockSize,
+                             int channels, LevelBlock *result);
+    //! signature of the conversion functions
+    typedef void (*Converter)(const char *data, int frames, int channels,
+                              qint16 *result);
+
+    FormatKernel();
+
+    bool setup(const QAudioFormat &format, LevelKernel::Type level);
+    bool isValid() const;
+    bool isNative() const;
+    int frameSize() const;
+
+    void analyze(const char *data, int blocks, int blockSize, LevelBlock *result) const;
+    void analyzePartial(const char *data, int frames, LevelBlock *result) const;
+    void convert(const char *data, int frames, qint16 *result) const;
+
+private:
+    //! the format specific analysis function
+    Function itsFunction;
+    //! the SIMD kernel for native S16 mono audio, if applicable
+    LevelKernel::Function itsLevelFunction;
+    //! the format specific conversion function to native S16 mono
+    Converter itsConverter;
+    //! number of audio channels
+    int itsChannels;
+    //! size of one audio frame in bytes
+    int itsFrameSize;
+};
+
+
+/*!
+  isNative returns true for native S16 mono audio, which needs no conversion.
+*/
+inline bool FormatKernel::isNative() const
+{
+    return itsLevelFunction != 0;
+}
+
+
+/*!
+  analyze determines the level of the given number of consecutive blocks.
+*/
+inline void FormatKernel::analyze(const char *data, int blocks, int blockSize,
+                                  LevelBlock *result) const
+{
+    if (itsLevelFunction)
+        itsLevelFunction((const qint16*)data, blocks, blockSize, result);
+    else
+        itsFunction(data, blocks, blockSize, itsChannels, result);
+}
+
+
+/*!
+  analyzePartial determines the level of a single block of the given number of
+  frames. It is used for block fragments, which the SIMD kernels cannot handle.
+*/
+inline void FormatKernel::analyzePartial(const char *data, int frames,
+                                         LevelBlock *result) const
+{
+    itsFunction(data, 1, frames, itsChannels, result);
+}
+
+
+/*!
+  convert converts the given number of frames to native S16 mono samples, as
+  needed for resampling.
+*/
+inline void FormatKernel::convert(const char *data, int frames, qint16 *result) const
+{
+    itsConverter(data, frames, itsChannels, result);
+}
+
+#endif // FORMATKERNEL_H
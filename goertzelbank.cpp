@@ -0,0 +1,224 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "goertzelbank.h"
+
+#include <QDebug>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// determine the SIMD instruction set we can build
+#if defined(__SSE__) || defined(__x86_64__)
+  #define GOERTZELBANK_SSE
+  #include <xmmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define GOERTZELBANK_NEON
+  #include <arm_neon.h>
+#endif
+
+
+/*!
+  runFilters advances the given number of filters by the samples. The filter
+  count is a multiple of four, each filter handles one lane.
+*/
+static void runFilters(const float *samples, int count, int filters,
+                       const float *coefficient, float *state1, float *state2)
+{
+    for (int f = 0; f < filters; f += 4) {
+#if defined(GOERTZELBANK_SSE)
+        __m128 c = _mm_loadu_ps(coefficient + f);
+        __m128 s1 = _mm_loadu_ps(state1 + f);
+        __m128 s2 = _mm_loadu_ps(state2 + f);
+        for (int i = 0; i < count; ++i) {
+            __m128 s0 = _mm_sub_ps(_mm_add_ps(_mm_set1_ps(samples[i]), _mm_mul_ps(c, s1)), s2);
+            s2 = s1;
+            s1 = s0;
+        }
+        _mm_storeu_ps(state1 + f, s1);
+        _mm_storeu_ps(state2 + f, s2);
+#elif defined(GOERTZELBANK_NEON)
+        float32x4_t c = vld1q_f32(coefficient + f);
+        float32x4_t s1 = vld1q_f32(state1 + f);
+        float32x4_t s2 = vld1q_f32(state2 + f);
+        for (int i = 0; i < count; ++i) {
+            float32x4_t s0 = vsubq_f32(vmlaq_f32(vdupq_n_f32(samples[i]), c, s1), s2);
+            s2 = s1;
+            s1 = s0;
+        }
+        vst1q_f32(state1 + f, s1);
+        vst1q_f32(state2 + f, s2);
+#else
+        for (int i = 0; i < count; ++i) {
+            for (int l = f; l < f+4; ++l) {
+                float s0 = samples[i] + coefficient[l] * state1[l] - state2[l];
+                state2[l] = state1[l];
+                state1[l] = s0;
+            }
+        }
+#endif
+    }
+}
+
+
+/*!
+  The constructor sets up a disabled filter bank.
+*/
+GoertzelBank::GoertzelBank()
+    : itsBins(0), itsFilters(0)
+{
+    reset();
+}
+
+
+/*!
+  setup enables the filter bank for the given frequencies in Hz, at the given
+  sample rate. Frequencies beyond the Nyquist frequency or MAX_BINS are
+  ignored. Without frequencies, the filter bank is disabled.
+*/
+void GoertzelBank::setup(int rate, const QList<int> &frequencies)
+{
+    itsBins = 0;
+    foreach (int frequency, frequencies) {
+        int bin = (rate > 0) ? (frequency * BLOCK_SIZE + rate/2) / rate : 0;
+        if ( (bin <= 0) || (bin >= BLOCK_SIZE/2) || (itsBins == MAX_BINS) ) {
+            qWarning() << "Ignoring tone frequency" << frequency << "Hz";
+            continue;
+        }
+
+        itsCoefficient[itsBins++] = 2 * cos(2 * M_PI * bin / BLOCK_SIZE);
+    }
+
+    // the unused lanes run idle
+    itsFilters = (itsBins + LANES-1) / LANES * LANES;
+    for (int i = itsBins; i < itsFilters; ++i)
+        itsCoefficient[i] = 0;
+
+    reset();
+}
+
+
+/*!
+  isEnabled returns true if at least one frequency is selected.
+*/
+bool GoertzelBank::isEnabled() const
+{
+    return itsBins > 0;
+}
+
+
+/*!
+  bins returns the number of selected frequencies.
+*/
+int GoertzelBank::bins() const
+{
+    return itsBins;
+}
+
+
+/*!
+  reset drops the current block and the collected block scores.
+*/
+void GoertzelBank::reset()
+{
+    for (int i = 0; i < MAX_BINS; ++i) {
+        itsState1[i] = 0;
+        itsState2[i] = 0;
+    }
+    itsPos = 0;
+    itsEnergy = 0;
+    itsScoreSum = 0;
+    itsScoreCount = 0;
+    itsScore = 0;
+}
+
+
+/*!
+  write adds the given S16 mono samples. They are converted to float in chunks
+  and run through all filters.
+*/
+void GoertzelBank::write(const qint16 *data, int frames)
+{
+    if (!isEnabled())
+        return;
+
+    float samples[BLOCK_SIZE];
+
+    while (frames > 0) {
+        int n = qMin(frames, BLOCK_SIZE - itsPos);
+        for (int i = 0; i < n; ++i) {
+            samples[i] = data[i];
+            itsEnergy += samples[i] * samples[i];
+        }
+        runFilters(samples, n, itsFilters, itsCoefficient, itsState1, itsState2);
+
+        data += n;
+        frames -= n;
+        itsPos += n;
+
+        if (itsPos == BLOCK_SIZE) {
+            itsScoreSum += finishBlock();
+            itsScoreCount++;
+        }
+    }
+}
+
+
+/*!
+  score returns the mean block score since the last call, in percent. If no
+  block got completed since, the previous score is returned.
+*/
+int GoertzelBank::score()
+{
+    if (itsScoreCount > 0) {
+        itsScore = (int)(100 * itsScoreSum / itsScoreCount + 0.5f);
+        itsScoreSum = 0;
+        itsScoreCount = 0;
+    }
+
+    return itsScore;
+}
+
+
+/*!
+  finishBlock returns the score of the completed block, between 0 and 1, and
+  restarts the filters. A pure tone of the block energy has a bin power of
+  energy * BLOCK_SIZE/2.
+*/
+float GoertzelBank::finishBlock()
+{
+    float power = 0;
+    for (int i = 0; i < itsBins; ++i)
+        power += itsState1[i] * itsState1[i] + itsState2[i] * itsState2[i]
+                 - itsCoefficient[i] * itsState1[i] * itsState2[i];
+
+    float energy = itsEnergy;
+    for (int i = 0; i < MAX_BINS; ++i) {
+        itsState1[i] = 0;
+        itsState2[i] = 0;
+    }
+    itsPos = 0;
+    itsEnergy = 0;
+
+    // silence has no tone
+    if (energy < 1.0f)
+        return 0;
+
+    return qMin(1.0f, power / (energy * BLOCK_SIZE / 2));
+}
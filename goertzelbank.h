@@ -0,0 +1,87 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GOERTZELBANK_H
+#define GOERTZELBANK_H
+
+#include <QtGlobal>
+#include <QList>
+
+
+/*!
+  GoertzelBank rates the audio by the energy of a few selected frequencies,
+  much cheaper than a full FFT.
+
+  Each frequency is tracked by a Goertzel filter over blocks of BLOCK_SIZE
+  samples. The filters of all frequencies run in lockstep, four at a time with
+  SSE or NEON where available. The frequencies are rounded to the nearest bin
+  of the block, their coefficients are computed once the sample rate is known.
+
+  The block score is the energy of the selected bins relative to the total
+  energy of the block, scaled such that a pure tone on a selected bin scores 1.
+  The score reported to the caller is the mean block score since the last
+  query, in percent.
+*/
+class GoertzelBank
+{
+public:
+    //! maximum number of frequencies
+    const static int MAX_BINS = 16;
+    //! number of samples of a block
+    const static int BLOCK_SIZE = 256;
+
+    GoertzelBank();
+
+    void setup(int rate, const QList<int> &frequencies);
+    bool isEnabled() const;
+    int bins() const;
+    void reset();
+
+    void write(const qint16 *data, int frames);
+    int score();
+
+private:
+    //! number of filters processed together
+    const static int LANES = 4;
+
+    float finishBlock();
+
+    //! number of selected frequencies, 0 if disabled
+    int itsBins;
+    //! number of filters, rounded up to full lanes
+    int itsFilters;
+
+    //! filter coefficients 2*cos(2*pi*k/BLOCK_SIZE), 0 for unused filters
+    float itsCoefficient[MAX_BINS];
+    //! the two previous filter outputs
+    float itsState1[MAX_BINS];
+    float itsState2[MAX_BINS];
+
+    //! number of samples of the current block
+    int itsPos;
+    //! sum of the squared samples of the current block
+    float itsEnergy;
+
+    //! sum of the block scores since the last query
+    float itsScoreSum;
+    //! number of blocks since the last query
+    int itsScoreCount;
+    //! latest score, repeated if no block completed in between
+    int itsScore;
+};
+
+#endif // GOERTZELBANK_H
@@ -16,8 +16,22 @@ Page {
     signal dataChanged()
     signal changeState()
 
+    // both graphs are zoomed and scrolled together
+    function zoomGraphs(factor, x) {
+        volume_graph.zoomBy(factor, x)
+        duration_graph.zoomBy(factor, x)
+    }
+    function scrollGraphs(dx) {
+        volume_graph.scrollBy(dx)
+        duration_graph.scrollBy(dx)
+    }
+    function resetGraphs() {
+        volume_graph.resetView()
+        duration_graph.resetView()
+    }
+
 
-    state: "OFF"
+    state: engine.state
     states: [
         State {
             name: "OFF"
@@ -88,6 +102,36 @@ Page {
         anchors.topMargin: 10
         anchors.right: volume_settings.left
         height: parent.inPortrait ? 150 : 100
+        zoomable: true
+        threshold: engine.threshold
+        noiseFloor: engine.noiseFloor
+
+        // the cry probability, if a classifier is configured
+        Label {
+            text: qsTr("Cry: %1%").arg(engine.probability)
+            visible: engine.probability >= 0
+            anchors.top: parent.top
+            anchors.right: parent.right
+            anchors.margins: 5
+        }
+
+        // pinch to zoom, drag to scroll, double tap to follow the live data
+        PinchArea {
+            anchors.fill: parent
+            onPinchUpdated: mainPage.zoomGraphs(pinch.previousScale / pinch.scale, pinch.center.x)
+
+            MouseArea {
+                property real lastX
+
+                anchors.fill: parent
+                onPressed: lastX = mouse.x
+                onPositionChanged: {
+                    mainPage.scrollGraphs(mouse.x - lastX)
+                    lastX = mouse.x
+                }
+                onDoubleClicked: mainPage.resetGraphs()
+            }
+        }
     }
     Slider {
         id: volume_settings
@@ -127,6 +171,25 @@ Page {
         anchors.topMargin: 10
         anchors.right: duration_settings.left
         height: parent.inPortrait ? 150 : 100
+        zoomable: true
+
+        // pinch to zoom, drag to scroll, double tap to follow the live data
+        PinchArea {
+            anchors.fill: parent
+            onPinchUpdated: mainPage.zoomGraphs(pinch.previousScale / pinch.scale, pinch.center.x)
+
+            MouseArea {
+                property real lastX
+
+                anchors.fill: parent
+                onPressed: lastX = mouse.x
+                onPositionChanged: {
+                    mainPage.scrollGraphs(mouse.x - lastX)
+                    lastX = mouse.x
+                }
+                onDoubleClicked: mainPage.resetGraphs()
+            }
+        }
     }
     Slider {
         id: duration_settings
@@ -20,6 +20,7 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
 #include <QPainter>
 #include <QPen>
 #include <QBrush>
+#include <QVector>
 #include <QDebug>
 
 
@@ -29,7 +30,9 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
   reference to the application settings.
 */
 AudioLevelGraph::AudioLevelGraph(QDeclarativeItem *parent)
-    : QDeclarativeItem(parent)
+    : QDeclarativeItem(parent), itsCount(0), itsThreshold(THRESHOLD_VALUE),
+      itsNoiseFloor(-1), itsZoomable(false), itsZoom(1), itsScroll(0),
+      itsCacheValid(false), itsCacheFirst(0), itsCacheZoom(1), itsCacheEnd(0)
 {
     // need to disable this flag to draw inside a QDeclarativeItem
     setFlag(QGraphicsItem::ItemHasNoContents, false);
@@ -38,60 +41,341 @@ AudioLevelGraph::AudioLevelGraph(QDeclarativeItem *parent)
 
 /*!
   AddValue takes the given audio data point and adds it to the graph.
-  If the graph reaches the end of the screen on its x-axes, the graph is cleared
-  to start over at the left again.
+  If the graph reaches the end of the screen on its x-axes, the oldest value is
+  dropped and the graph scrolls. In zoomable mode all values are kept.
 */
 void AudioLevelGraph::addValue(float value)
 {
-    // check data buffer size
-    if (itsData.size() >= boundingRect().width()) {
-        // reached end of screen, clear display
-        itsData.clear();
-    }
-
-    // add current item
     // limit this to maximal viewable range
-    if (value < GRAPH_MAX_VALUE)
+    value = qMin<float>(value, GRAPH_MAX_VALUE);
+
+    if (itsZoomable) {
+        itsPyramid.append((qint16)value);
+
+        // a view scrolled back stays in place
+        if (itsScroll > 0)
+            itsScroll += 1;
+    }
+    else {
+        // only keep the values of the visible columns
         itsData.append(value);
-    else
-        itsData.append(GRAPH_MAX_VALUE);
+        while (itsData.size() > boundingRect().width())
+            itsData.removeFirst();
+    }
+    itsCount++;
 
     // update screen only depending on update rate
-    if ((itsData.size() % UPDATE_RATE) == 0)
+    if ((itsCount % UPDATE_RATE) == 0)
         update();
 }
 
 
+/*!
+  threshold returns the position of the threshold line.
+*/
+float AudioLevelGraph::threshold() const
+{
+    return itsThreshold;
+}
+
+
+/*!
+  setThreshold moves the threshold line. Values above are painted red.
+*/
+void AudioLevelGraph::setThreshold(float threshold)
+{
+    if (threshold == itsThreshold)
+        return;
+
+    itsThreshold = threshold;
+    itsCacheValid = false;
+    update();
+}
+
+
+/*!
+  noiseFloor returns the position of the noise floor line.
+*/
+float AudioLevelGraph::noiseFloor() const
+{
+    return itsNoiseFloor;
+}
+
+
+/*!
+  setNoiseFloor moves the noise floor line.
+*/
+void AudioLevelGraph::setNoiseFloor(float floor)
+{
+    if (floor == itsNoiseFloor)
+        return;
+
+    itsNoiseFloor = floor;
+    itsCacheValid = false;
+    update();
+}
+
+
 /*!
   Clear removes all objects from the graph and redraws the limit line.
 */
 void AudioLevelGraph::clear()
 {
     itsData.clear();
+    itsPyramid.clear();
+    itsCount = 0;
+    itsScroll = 0;
+    itsCacheValid = false;
     update();
 }
 
 
-void AudioLevelGraph::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
+/*!
+  isZoomable returns true in zoomable mode.
+*/
+bool AudioLevelGraph::isZoomable() const
+{
+    return itsZoomable;
+}
+
+
+/*!
+  setZoomable switches between the zoomable mode and the plain one. The graph
+  starts over empty.
+*/
+void AudioLevelGraph::setZoomable(bool zoomable)
+{
+    itsZoomable = zoomable;
+    itsZoom = 1;
+    clear();
+}
+
+
+/*!
+  zoomBy changes the number of values per pixel by the given factor. The value
+  at the given pixel position stays in place.
+*/
+void AudioLevelGraph::zoomBy(qreal factor, qreal x)
 {
-    // white, boxed background
-    painter->fillRect(boundingRect(), QBrush(Qt::white));
-    painter->drawRect(boundingRect());
+    qreal width = boundingRect().width();
+    qreal anchor = firstValue() + x * itsZoom;
 
-    // common factor
-    float scale = (float)boundingRect().height() / GRAPH_MAX_VALUE;
+    itsZoom = qBound<qreal>(1.0 / MAX_MAGNIFICATION, itsZoom * factor, maxZoom());
+
+    qreal last = anchor + (width - x) * itsZoom;
+    itsScroll = qBound<qreal>(0, itsPyramid.size() - last,
+                              qMax<qreal>(0, itsPyramid.size() - width * itsZoom));
+    update();
+}
+
+
+/*!
+  scrollBy moves the view by the given number of pixels, positive values
+  towards the older values.
+*/
+void AudioLevelGraph::scrollBy(qreal dx)
+{
+    qreal width = boundingRect().width();
+    itsScroll = qBound<qreal>(0, itsScroll + dx * itsZoom,
+                              qMax<qreal>(0, itsPyramid.size() - width * itsZoom));
+    update();
+}
+
+
+/*!
+  resetView returns to one value per pixel, following the newest values.
+*/
+void AudioLevelGraph::resetView()
+{
+    itsZoom = 1;
+    itsScroll = 0;
+    update();
+}
+
+
+/*!
+  maxZoom returns the number of values per pixel which shows the whole session.
+*/
+qreal AudioLevelGraph::maxZoom() const
+{
+    return qMax<qreal>(1, itsPyramid.size() / boundingRect().width());
+}
+
+
+/*!
+  valueCount returns the number of values the view refers to. In plain mode
+  only the latest ones are still available.
+*/
+int AudioLevelGraph::valueCount() const
+{
+    return itsZoomable ? itsPyramid.size() : itsCount;
+}
+
+
+/*!
+  firstValue returns the index of the value at the left border. The newest
+  value is at the right border, unless there are less values than columns.
+*/
+qreal AudioLevelGraph::firstValue() const
+{
+    qreal width = boundingRect().width();
+    if (!itsZoomable)
+        return qMax<qreal>(0, itsCount - width);
+
+    return qMax<qreal>(0, itsPyramid.size() - itsScroll - width * itsZoom);
+}
+
+
+/*!
+  column determines the minimum and maximum of the values covered by the given
+  pixel column. It returns false if there are no values.
+*/
+bool AudioLevelGraph::column(int x, float *minimum, float *maximum) const
+{
+    qreal first = firstValue();
+    int from = first + x * itsZoom;
+
+    if (!itsZoomable) {
+        int index = from - (itsCount - itsData.size());
+        if ( (index < 0) || (index >= itsData.size()) )
+            return false;
+        *minimum = itsData.at(index);
+        *maximum = itsData.at(index);
+        return true;
+    }
+
+    int to = qMax(from + 1, (int)(first + (x+1) * itsZoom));
+    qint16 low;
+    qint16 high;
+    if (!itsPyramid.range(from, to, &low, &high))
+        return false;
+
+    // the minimum is only of interest if the column covers several values
+    *minimum = (to - from > 1) ? low : high;
+    *maximum = high;
+    return true;
+}
+
+
+/*!
+  drawBackground draws the white background of the given pixel columns
+  together with the threshold and the noise floor line.
+*/
+void AudioLevelGraph::drawBackground(QPainter *painter, int from, int to) const
+{
+    qreal height = boundingRect().height();
+    qreal scale = height / GRAPH_MAX_VALUE;
+
+    painter->fillRect(QRectF(from, 0, to - from, height), QBrush(Qt::white));
 
     // draw threshold line
     painter->setPen(QPen(Qt::gray));
-    painter->drawLine(0, boundingRect().height()-THRESHOLD_VALUE*scale,
-                      boundingRect().width(), boundingRect().height()-THRESHOLD_VALUE*scale);
+    painter->drawLine(QLineF(from, height - itsThreshold*scale,
+                             to, height - itsThreshold*scale));
+
+    // draw noise floor line
+    if (itsNoiseFloor >= 0) {
+        painter->setPen(QPen(Qt::gray, 0, Qt::DashLine));
+        painter->drawLine(QLineF(from, height - itsNoiseFloor*scale,
+                                 to, height - itsNoiseFloor*scale));
+    }
+}
+
+
+/*!
+  drawColumns draws the bars of the given pixel columns. Values below the
+  threshold are painted black, values above in red. If a column covers several
+  values, the part below their minimum is painted gray. The bars are collected
+  per color and drawn by a single call each.
+*/
+void AudioLevelGraph::drawColumns(QPainter *painter, int from, int to) const
+{
+    qreal height = boundingRect().height();
+    qreal scale = height / GRAPH_MAX_VALUE;
+
+    QVector<QLineF> normal;
+    QVector<QLineF> loud;
+    QVector<QLineF> floor;
+    normal.reserve(to - from);
+
+    for (int x = from; x < to; ++x) {
+        float minimum;
+        float maximum;
+        if (!column(x, &minimum, &maximum))
+            break;
+
+        QLineF bar(x, height - maximum*scale, x, height);
+        if (maximum >= itsThreshold)
+            loud.append(bar);
+        else
+            normal.append(bar);
+
+        if (minimum < maximum)
+            floor.append(QLineF(x, height - minimum*scale, x, height));
+    }
+
+    painter->setPen(QPen(Qt::black));
+    painter->drawLines(normal);
+    painter->setPen(QPen(Qt::red));
+    painter->drawLines(loud);
+    painter->setPen(QPen(Qt::gray));
+    painter->drawLines(floor);
+}
+
+
+/*!
+  paint updates the cached graph and draws it. If the view moved on by whole
+  values at one value per pixel, the cache gets scrolled and only the new
+  columns are drawn. Otherwise, the graph is drawn completely.
+*/
+void AudioLevelGraph::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
+{
+    QRectF rect = boundingRect();
+    int width = rect.width();
+    int height = rect.height();
+    if ( (width <= 0) || (height <= 0) )
+        return;
+
+    if (itsCache.size() != QSize(width, height)) {
+        itsCache = QPixmap(width, height);
+        itsCacheValid = false;
+    }
 
-    // draw graph
-    for(int i = 0; i < itsData.size(); i++) {
-        // values below the threshold are painted black, values above in red
-        painter->setPen(itsData.at(i) >= THRESHOLD_VALUE ? QPen(Qt::red) : QPen(Qt::black));
+    // the view covers the values [first, end)
+    qreal first = firstValue();
+    qreal end = qMin<qreal>(valueCount(), first + width * itsZoom);
+    int shift = first - itsCacheFirst;
+    // number of columns filled in the cache, after scrolling it
+    int filled = itsCacheEnd - itsCacheFirst - shift;
 
-        painter->drawLine(i, boundingRect().height()-itsData.at(i)*scale,
-                          i, boundingRect().height());
+    bool incremental = itsCacheValid && (itsZoom == 1) && (itsCacheZoom == 1) &&
+            (first == (int)first) && (itsCacheFirst == (int)itsCacheFirst) &&
+            (shift >= 0) && (shift < width) && (end >= itsCacheEnd) && (filled >= 0);
+    bool unchanged = itsCacheValid && (first == itsCacheFirst) &&
+            (itsZoom == itsCacheZoom) && (end == itsCacheEnd);
+
+    if (!unchanged) {
+        if (incremental) {
+            if (shift > 0)
+                itsCache.scroll(-shift, 0, itsCache.rect());
+        }
+        else {
+            filled = 0;
+        }
+
+        QPainter cache(&itsCache);
+        drawBackground(&cache, filled, width);
+        drawColumns(&cache, filled, width);
+
+        itsCacheValid = true;
+        itsCacheFirst = first;
+        itsCacheZoom = itsZoom;
+        itsCacheEnd = end;
     }
+
+    // boxed graph
+    painter->drawPixmap(0, 0, itsCache);
+    painter->setPen(QPen(Qt::black));
+    painter->setBrush(Qt::NoBrush);
+    painter->drawRect(rect);
 }
@@ -20,34 +20,94 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
 
 #include <QDeclarativeItem>
 #include <QList>
+#include <QPixmap>
+
+#include "levelpyramid.h"
 
 
 /*!
   AudioLevelGraph provides specialized graphic items to display the audio
   properties over time.
   It gets called with each new audio sample and creates the graph. The graph
-  already provides a line for the threshold value.
+  already provides a line for the threshold value and optionally one for the
+  noise floor. As it reaches the end of the screen, the graph scrolls.
+
+  The graph is rendered into a cached pixmap. As long as the view only moves
+  on by new values, the cache gets scrolled and just the new columns are
+  drawn. The bars are drawn by a single call per color.
+
+  In zoomable mode the graph keeps all values of the session in a
+  LevelPyramid. Each column shows the minimum and maximum of the values it
+  covers, so the zoom ranges from single values up to the whole session. The
+  view follows the newest values unless it got scrolled back.
 */
 class AudioLevelGraph : public QDeclarativeItem
 {
     Q_OBJECT
+    Q_PROPERTY(bool zoomable READ isZoomable WRITE setZoomable)
+    Q_PROPERTY(float threshold READ threshold WRITE setThreshold)
+    Q_PROPERTY(float noiseFloor READ noiseFloor WRITE setNoiseFloor)
 
 public:
     AudioLevelGraph(QDeclarativeItem *parent = 0);
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
 
     void addValue(float value);
+    float threshold() const;
+    void setThreshold(float threshold);
+    float noiseFloor() const;
+    void setNoiseFloor(float floor);
     void clear();
 
+    bool isZoomable() const;
+    void setZoomable(bool zoomable);
+
+    Q_INVOKABLE void zoomBy(qreal factor, qreal x);
+    Q_INVOKABLE void scrollBy(qreal dx);
+    Q_INVOKABLE void resetView();
+
 
 private:
     const static int GRAPH_MIN_VALUE = 0;
     const static int GRAPH_MAX_VALUE = 130;
     const static int THRESHOLD_VALUE = 100;
     const static int UPDATE_RATE = 3;   // every x-th audio sample
+    //! maximum magnification, in pixels per value
+    const static int MAX_MAGNIFICATION = 8;
+
+    int valueCount() const;
+    qreal firstValue() const;
+    bool column(int x, float *minimum, float *maximum) const;
+    void drawBackground(QPainter *painter, int from, int to) const;
+    void drawColumns(QPainter *painter, int from, int to) const;
+    qreal maxZoom() const;
 
-    //! graph data
+    //! the latest graph data, at most one value per pixel column
     QList<float> itsData;
+    //! number of values added since the graph got cleared
+    int itsCount;
+    //! current threshold line
+    float itsThreshold;
+    //! current noise floor line, negative if not shown
+    float itsNoiseFloor;
+
+    //! set in zoomable mode
+    bool itsZoomable;
+    //! all values of the session, zoomable mode only
+    LevelPyramid itsPyramid;
+    //! values per pixel
+    qreal itsZoom;
+    //! number of values between the right border and the newest value
+    qreal itsScroll;
+
+    //! the rendered graph
+    QPixmap itsCache;
+    //! set if the cache shows the current threshold and noise floor
+    bool itsCacheValid;
+    //! the view of the cache: first value, values per pixel and end value
+    qreal itsCacheFirst;
+    qreal itsCacheZoom;
+    qreal itsCacheEnd;
 };
 
 
@@ -0,0 +1,223 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+#include <QPainter>
+#include <QPixmap>
+
+#include "audiolevelgraph.h"
+#include "levelpyramid.h"
+
+
+/*!
+  ReferenceGraph repeats the paint of AudioLevelGraph before the cache, as the
+  baseline of the benchmark. Each paint draws the whole graph, the plain bars by
+  one drawLine with a new QPen each.
+*/
+class ReferenceGraph
+{
+public:
+    ReferenceGraph(bool zoomable, int width, int height);
+
+    void addValue(float value);
+    void paint(QPainter *painter);
+
+private:
+    const static int GRAPH_MAX_VALUE = 130;
+    const static int THRESHOLD_VALUE = 100;
+
+    //! the latest values, at most one per pixel column, plain mode only
+    QList<float> itsData;
+    //! all values, zoomable mode only
+    LevelPyramid itsPyramid;
+    bool itsZoomable;
+    QRectF itsRect;
+};
+
+
+/*!
+  The constructor sets up an empty graph of the given size.
+*/
+ReferenceGraph::ReferenceGraph(bool zoomable, int width, int height)
+    : itsZoomable(zoomable), itsRect(0, 0, width, height)
+{
+}
+
+
+/*!
+  addValue adds the value like AudioLevelGraph, the plain graph scrolls.
+*/
+void ReferenceGraph::addValue(float value)
+{
+    value = qMin<float>(value, GRAPH_MAX_VALUE);
+    if (itsZoomable) {
+        itsPyramid.append((qint16)value);
+        return;
+    }
+
+    itsData.append(value);
+    while (itsData.size() > itsRect.width())
+        itsData.removeFirst();
+}
+
+
+/*!
+  paint draws the background, the threshold line and the bars of the latest
+  values, at one value per pixel.
+*/
+void ReferenceGraph::paint(QPainter *painter)
+{
+    painter->fillRect(itsRect, QBrush(Qt::white));
+    painter->drawRect(itsRect);
+
+    float scale = (float)itsRect.height() / GRAPH_MAX_VALUE;
+    qreal height = itsRect.height();
+
+    painter->setPen(QPen(Qt::gray));
+    painter->drawLine(0, height-THRESHOLD_VALUE*scale,
+                      itsRect.width(), height-THRESHOLD_VALUE*scale);
+
+    if (!itsZoomable) {
+        for (int i = 0; i < itsData.size(); i++) {
+            painter->setPen(itsData.at(i) >= THRESHOLD_VALUE ? QPen(Qt::red) : QPen(Qt::black));
+            painter->drawLine(i, height-itsData.at(i)*scale, i, height);
+        }
+        return;
+    }
+
+    // the zoomable bars were already drawn by a single call per color
+    int width = itsRect.width();
+    int first = qMax(0, itsPyramid.size() - width);
+    QVector<QLineF> normal;
+    QVector<QLineF> loud;
+    normal.reserve(width);
+    for (int x = 0; x < width; ++x) {
+        qint16 minimum;
+        qint16 maximum;
+        if (!itsPyramid.range(first + x, first + x + 1, &minimum, &maximum))
+            break;
+
+        QLineF bar(x, height - maximum*scale, x, height);
+        if (maximum >= THRESHOLD_VALUE)
+            loud.append(bar);
+        else
+            normal.append(bar);
+    }
+    painter->setPen(QPen(Qt::black));
+    painter->drawLines(normal);
+    painter->setPen(QPen(Qt::red));
+    painter->drawLines(loud);
+}
+
+
+/*!
+  AudioLevelGraphBench measures the time of AudioLevelGraph::paint per added
+  value, at the size of the graph on the N9 screen. The cached graph only draws
+  the new column, while a changed threshold makes it redraw the whole graph.
+  The ReferenceGraph gives the time of the paint before the cache.
+*/
+class AudioLevelGraphBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void paint_data();
+    void paint();
+
+private:
+    //! size of the graph in pixels
+    const static int WIDTH = 854;
+    const static int HEIGHT = 200;
+};
+
+
+/*!
+  paint_data lists the plain and the zoomable mode, each drawn by the reference
+  paint, incrementally and completely.
+*/
+void AudioLevelGraphBench::paint_data()
+{
+    QTest::addColumn<bool>("zoomable");
+    QTest::addColumn<bool>("reference");
+    QTest::addColumn<bool>("fullRedraw");
+
+    QTest::newRow("plain, before") << false << true << true;
+    QTest::newRow("plain, incremental") << false << false << false;
+    QTest::newRow("plain, full redraw") << false << false << true;
+    QTest::newRow("zoomable, before") << true << true << true;
+    QTest::newRow("zoomable, incremental") << true << false << false;
+    QTest::newRow("zoomable, full redraw") << true << false << true;
+}
+
+
+/*!
+  paint fills the graph with pseudo random values, such that each further
+  value scrolls it, and measures adding a value and painting the graph.
+*/
+void AudioLevelGraphBench::paint()
+{
+    QFETCH(bool, zoomable);
+    QFETCH(bool, reference);
+    QFETCH(bool, fullRedraw);
+
+    QPixmap screen(WIDTH, HEIGHT);
+    QPainter painter(&screen);
+    quint32 random = 1;
+
+    if (reference) {
+        ReferenceGraph graph(zoomable, WIDTH, HEIGHT);
+        for (int i = 0; i < 2 * WIDTH; ++i) {
+            random = random * 1103515245 + 12345;
+            graph.addValue(random >> 25);
+        }
+
+        QBENCHMARK {
+            random = random * 1103515245 + 12345;
+            graph.addValue(random >> 25);
+            graph.paint(&painter);
+        }
+        return;
+    }
+
+    AudioLevelGraph graph;
+    graph.setZoomable(zoomable);
+    graph.setWidth(WIDTH);
+    graph.setHeight(HEIGHT);
+
+    for (int i = 0; i < 2 * WIDTH; ++i) {
+        random = random * 1103515245 + 12345;
+        graph.addValue(random >> 25);
+    }
+    graph.paint(&painter, 0);
+
+    float threshold = graph.threshold();
+    QBENCHMARK {
+        random = random * 1103515245 + 12345;
+        graph.addValue(random >> 25);
+
+        // a new threshold invalidates the cache
+        if (fullRedraw) {
+            threshold = (threshold == 100) ? 101 : 100;
+            graph.setThreshold(threshold);
+        }
+        graph.paint(&painter, 0);
+    }
+}
+
+
+QTEST_MAIN(AudioLevelGraphBench)
+#include "audiolevelgraphbench.moc"
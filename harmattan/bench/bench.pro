@@ -0,0 +1,39 @@
+# babyphone - A baby monitor application for Maemo/MeeGo (Nokia N900, N950, N9).
+#     Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+#
+#     This program is free software: you can redistribute it and/or modify
+#     it under the terms of the GNU General Public License as published by
+#     the Free Software Foundation, either version 3 of the License, or
+#     (at your option) any later version.
+#
+#     This program is distributed in the hope that it will be useful,
+#     but WITHOUT ANY WARRANTY; without even the implied warranty of
+#     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#     GNU General Public License for more details.
+#
+#     You should have received a copy of the GNU General Public License
+#     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Benchmark of the audio level graph. It measures the paint time per added
+# value and is built by "make babyphone-bench" of the main project. Run it
+# with the QTest benchmark options, e.g. "-tickcounter" or "-iterations N".
+
+TARGET = babyphone-bench
+TEMPLATE = app
+
+QT       += core gui declarative testlib
+CONFIG   += console
+CONFIG   -= app_bundle
+
+INCLUDEPATH += ..
+DEPENDPATH += ..
+
+
+SOURCES += \
+    audiolevelgraphbench.cpp \
+    ../audiolevelgraph.cpp \
+    ../levelpyramid.cpp
+
+HEADERS += \
+    ../audiolevelgraph.h \
+    ../levelpyramid.h
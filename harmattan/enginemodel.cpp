@@ -0,0 +1,162 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "enginemodel.h"
+
+
+/*!
+  The constructor sets up an active model in the off state.
+*/
+EngineModel::EngineModel(QObject *parent)
+    : QObject(parent), itsVolume(0), itsCounter(0), itsThreshold(0),
+      itsNoiseFloor(0), itsProbability(-1), itsState("OFF"), itsPendingVolume(0),
+      itsPendingCounter(0), itsPendingThreshold(0), itsPendingNoiseFloor(0),
+      itsPendingProbability(-1), itsActive(true)
+{
+    itsTimer.setSingleShot(true);
+    itsTimer.setInterval(REFRESH_INTERVAL);
+    connect(&itsTimer, SIGNAL(timeout()), this, SLOT(publish()));
+}
+
+
+/*!
+  volume returns the current audio volume.
+*/
+int EngineModel::volume() const
+{
+    return itsVolume;
+}
+
+
+/*!
+  counter returns the current audio counter.
+*/
+int EngineModel::counter() const
+{
+    return itsCounter;
+}
+
+
+/*!
+  threshold returns the current volume threshold.
+*/
+int EngineModel::threshold() const
+{
+    return itsThreshold;
+}
+
+
+/*!
+  noiseFloor returns the current noise floor.
+*/
+int EngineModel::noiseFloor() const
+{
+    return itsNoiseFloor;
+}
+
+
+/*!
+  probability returns the cry probability in percent, -1 without classifier.
+*/
+int EngineModel::probability() const
+{
+    return itsProbability;
+}
+
+
+/*!
+  state returns the application state, "OFF", "WAITING" or "ON".
+*/
+QString EngineModel::state() const
+{
+    return itsState;
+}
+
+
+/*!
+  setAudioData stores new audio data. It gets published with the next display
+  refresh.
+*/
+void EngineModel::setAudioData(int counter, int value, int floor, int threshold,
+                               int probability)
+{
+    itsPendingVolume = value;
+    itsPendingCounter = counter;
+    itsPendingThreshold = threshold;
+    itsPendingNoiseFloor = floor;
+    itsPendingProbability = probability;
+
+    if ( (itsActive) && (!itsTimer.isActive()) )
+        itsTimer.start();
+}
+
+
+/*!
+  setState changes the application state. State changes are published
+  immediately.
+*/
+void EngineModel::setState(const QString &state)
+{
+    if (state == itsState)
+        return;
+
+    itsState = state;
+    emit stateChanged();
+}
+
+
+/*!
+  setActive enables or disables the publishing of audio data. On activation,
+  the latest data gets published.
+*/
+void EngineModel::setActive(bool active)
+{
+    itsActive = active;
+
+    if (active)
+        itsTimer.start();
+    else
+        itsTimer.stop();
+}
+
+
+/*!
+  publish signals the changed audio data.
+*/
+void EngineModel::publish()
+{
+    if (itsPendingVolume != itsVolume) {
+        itsVolume = itsPendingVolume;
+        emit volumeChanged();
+    }
+    if (itsPendingCounter != itsCounter) {
+        itsCounter = itsPendingCounter;
+        emit counterChanged();
+    }
+    if (itsPendingThreshold != itsThreshold) {
+        itsThreshold = itsPendingThreshold;
+        emit thresholdChanged();
+    }
+    if (itsPendingNoiseFloor != itsNoiseFloor) {
+        itsNoiseFloor = itsPendingNoiseFloor;
+        emit noiseFloorChanged();
+    }
+    if (itsPendingProbability != itsProbability) {
+        itsProbability = itsPendingProbability;
+        emit probabilityChanged();
+    }
+}
@@ -0,0 +1,95 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ENGINEMODEL_H
+#define ENGINEMODEL_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+
+/*!
+  EngineModel exposes the state of the babyphone engine to QML. The user
+  interface binds to its properties instead of being updated item by item.
+
+  The audio data is coalesced: new values are only kept, and published once
+  per display refresh interval. Only changed properties signal a change. While
+  the model is inactive, e.g. with the display turned off, nothing gets
+  published at all.
+*/
+class EngineModel : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int volume READ volume NOTIFY volumeChanged)
+    Q_PROPERTY(int counter READ counter NOTIFY counterChanged)
+    Q_PROPERTY(int threshold READ threshold NOTIFY thresholdChanged)
+    Q_PROPERTY(int noiseFloor READ noiseFloor NOTIFY noiseFloorChanged)
+    Q_PROPERTY(int probability READ probability NOTIFY probabilityChanged)
+    Q_PROPERTY(QString state READ state NOTIFY stateChanged)
+
+public:
+    explicit EngineModel(QObject *parent = 0);
+
+    int volume() const;
+    int counter() const;
+    int threshold() const;
+    int noiseFloor() const;
+    int probability() const;
+    QString state() const;
+
+    void setAudioData(int counter, int value, int floor, int threshold, int probability);
+    void setState(const QString &state);
+    void setActive(bool active);
+
+signals:
+    void volumeChanged();
+    void counterChanged();
+    void thresholdChanged();
+    void noiseFloorChanged();
+    void probabilityChanged();
+    void stateChanged();
+
+private slots:
+    void publish();
+
+private:
+    //! publishing interval in milliseconds, the display refresh rate
+    const static int REFRESH_INTERVAL = 16;
+
+    //! the published values
+    int itsVolume;
+    int itsCounter;
+    int itsThreshold;
+    int itsNoiseFloor;
+    int itsProbability;
+    QString itsState;
+
+    //! the latest audio data, published by the timer
+    int itsPendingVolume;
+    int itsPendingCounter;
+    int itsPendingThreshold;
+    int itsPendingNoiseFloor;
+    int itsPendingProbability;
+
+    //! timer of the next publishing, running while audio data is pending
+    QTimer itsTimer;
+    //! unset while nothing shall be published
+    bool itsActive;
+};
+
+#endif // ENGINEMODEL_H
@@ -0,0 +1,103 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "levelpyramid.h"
+
+
+/*!
+  append adds a value. Each completed pair of blocks of a level is combined
+  into a block of the next level.
+*/
+void LevelPyramid::append(qint16 value)
+{
+    Range range;
+    range.minimum = value;
+    range.maximum = value;
+
+    for (int level = 0; ; ++level) {
+        if (level == itsLevels.size())
+            itsLevels.append(QVector<Range>());
+        QVector<Range> &blocks = itsLevels[level];
+        blocks.append(range);
+
+        // only a completed pair continues to the next level
+        int n = blocks.size();
+        if ((n % 2) != 0)
+            break;
+
+        range.minimum = qMin(blocks.at(n-2).minimum, blocks.at(n-1).minimum);
+        range.maximum = qMax(blocks.at(n-2).maximum, blocks.at(n-1).maximum);
+    }
+}
+
+
+/*!
+  clear removes all values.
+*/
+void LevelPyramid::clear()
+{
+    itsLevels.clear();
+}
+
+
+/*!
+  size returns the number of values.
+*/
+int LevelPyramid::size() const
+{
+    return itsLevels.isEmpty() ? 0 : itsLevels.at(0).size();
+}
+
+
+/*!
+  range determines the minimum and maximum of the values [first, last). It
+  covers the range by the largest aligned blocks available, growing towards
+  the middle of the range and shrinking towards its end. It returns false if
+  the range is empty.
+*/
+bool LevelPyramid::range(int first, int last, qint16 *minimum, qint16 *maximum) const
+{
+    first = qMax(first, 0);
+    last = qMin(last, size());
+    if (first >= last)
+        return false;
+
+    *minimum = 32767;
+    *maximum = -32768;
+
+    int level = 0;
+    while (first < last) {
+        // the next level needs an aligned block which fits the range
+        while ( (level+1 < itsLevels.size()) &&
+                ((first & ((2 << level) - 1)) == 0) &&
+                (first + (2 << level) <= last) &&
+                ((first >> (level+1)) < itsLevels.at(level+1).size()) )
+            level++;
+
+        while ( (level > 0) &&
+                ((first + (1 << level) > last) ||
+                 ((first >> level) >= itsLevels.at(level).size())) )
+            level--;
+
+        const Range &block = itsLevels.at(level).at(first >> level);
+        *minimum = qMin(*minimum, block.minimum);
+        *maximum = qMax(*maximum, block.maximum);
+        first += 1 << level;
+    }
+
+    return true;
+}
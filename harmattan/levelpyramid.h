@@ -0,0 +1,56 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef LEVELPYRAMID_H
+#define LEVELPYRAMID_H
+
+#include <QVector>
+
+
+/*!
+  LevelPyramid keeps all values of a graph together with their minimum and
+  maximum over blocks of 2, 4, 8, ... values.
+
+  Appending a value is O(1) amortized, the pyramid takes twice the memory of
+  the plain values. The minimum and maximum of any range of values get
+  combined from O(log n) pyramid entries, so a graph column is rendered
+  independently of the number of values it covers.
+*/
+class LevelPyramid
+{
+public:
+    void append(qint16 value);
+    void clear();
+    int size() const;
+
+    bool range(int first, int last, qint16 *minimum, qint16 *maximum) const;
+
+private:
+    /*!
+      Range holds the minimum and maximum of a block of values.
+    */
+    struct Range
+    {
+        qint16 minimum;
+        qint16 maximum;
+    };
+
+    //! the levels of the pyramid, the plain values first
+    QVector<QVector<Range> > itsLevels;
+};
+
+#endif // LEVELPYRAMID_H
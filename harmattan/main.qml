@@ -7,6 +7,7 @@ PageStackWindow {
     id: appWindow
 
     signal requestExit()
+    signal ignoreSound()
 
     // load pages
     MainPage {
@@ -46,6 +47,12 @@ PageStackWindow {
             anchors.right: parent===undefined ? undefined : parent.right
             onClicked: { pageStack.push(settingsPage); }
         }
+        // ignore the sound of the last notification from now on
+        ToolIcon {
+            iconId: "toolbar-delete"
+            anchors.horizontalCenter: parent===undefined ? undefined : parent.horizontalCenter
+            onClicked: ignoreSound()
+        }
         /*
         ToolIcon {
             iconId: "toolbar-close"
@@ -19,6 +19,7 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
 
 #include <QtDBus>
 #include <QDebug>
+#include <QDateTime>
 
 #include "audiolevelgraph.h"
 
@@ -55,8 +56,8 @@ MainWindow::MainWindow()
     // start babyphone engine
     itsBabyphone = new Babyphone(itsSettings, this);
     // register for audio data to update display
-    connect(itsBabyphone, SIGNAL(newAudioData(int,int)),
-            this, SLOT(newAudioData(int,int)));
+    connect(itsBabyphone, SIGNAL(newAudioData(int,int,int,int)),
+            this, SLOT(newAudioData(int,int,int,int)));
     // register to phone call info
     connect(itsBabyphone, SIGNAL(newCallStatus(bool,bool)),
             this, SLOT(newCallStatus(bool,bool)));
@@ -83,12 +84,25 @@ MainWindow::~MainWindow()
 void MainWindow::setupGui()
 {
     itsIsScreenOff = false;
+    itsGraphTime = QDateTime::currentMSecsSinceEpoch();
 
     qmlRegisterType<AudioLevelGraph>("com.babyphone", 1, 0, "AudioGraph");
 
+    // the engine model needs to be known before the QML bindings get evaluated
+    itsEngineModel = new EngineModel(this);
+    rootContext()->setContextProperty("engine", itsEngineModel);
+
     setSource(QUrl("qrc:/main.qml"));
     connect(rootObject(), SIGNAL(requestExit()),
             this, SIGNAL(requestExit()));
+    connect(rootObject(), SIGNAL(ignoreSound()),
+            this, SLOT(ignoreSound()));
+
+    // the graphs are fed by every audio sample, hence avoid a lookup per sample
+    itsVolumeGraph = rootObject()->findChild<AudioLevelGraph*>("volume_graph");
+    itsDurationGraph = rootObject()->findChild<AudioLevelGraph*>("duration_graph");
+    if ( (!itsVolumeGraph) || (!itsDurationGraph) )
+        qCritical() << "audio graphs not found";
 
     if (QObject *mainPage = rootObject()->findChild<QObject*>("mainPage")) {
         connect(mainPage, SIGNAL(dataChanged()),
@@ -251,48 +265,44 @@ void MainWindow::dataChanged()
 */
 void MainWindow::changeState()
 {
-    if (QObject *mainPage = rootObject()->findChild<QObject*>("mainPage")) {
-        Babyphone::State oldState = itsBabyphone->itsState;
-
-        // stop the potentially running activation delay counter
-        itsActivationDelayTimer.stop();
-
-        // what state switch did we perform?
-        switch(oldState) {
-            case Babyphone::STATE_OFF:
-                // switch ON
-                // check whether we have a valid phone number
-                if (itsSettings->itsContact.HasValidNumber()) {
-                    // activate it
-                    activateMonitor();
-                    mainPage->setProperty("state", "WAITING");
+    Babyphone::State oldState = itsBabyphone->itsState;
+
+    // stop the potentially running activation delay counter
+    itsActivationDelayTimer.stop();
+
+    // what state switch did we perform?
+    switch(oldState) {
+        case Babyphone::STATE_OFF:
+            // switch ON
+            // check whether we have a valid phone number
+            if (itsSettings->itsContact.HasValidNumber()) {
+                // activate it
+                activateMonitor();
+                itsEngineModel->setState("WAITING");
+            }
+            else {
+                // incomplete settings: no valid phone number
+                // open dialog to warn user
+                if (QObject *banner = rootObject()->findChild<QObject*>("banner")) {
+                    // display banner
+                    banner->setProperty("text",
+                            tr("No valid parent's phone number set.\n"
+                               "Please adjust the application settings."));
+                    QMetaObject::invokeMethod(banner, "show");
                 }
-                else {
-                    // incomplete settings: no valid phone number
-                    // open dialog to warn user
-                    if (QObject *banner = rootObject()->findChild<QObject*>("banner")) {
-                        // display banner
-                        banner->setProperty("text",
-                                tr("No valid parent's phone number set.\n"
-                                   "Please adjust the application settings."));
-                        QMetaObject::invokeMethod(banner, "show");
-                    }
-                    else
-                        qWarning() << "cannot display activation warning message";
-                }
-                break;
-            case Babyphone::STATE_WAITING:
-            case Babyphone::STATE_ON:
-                // switch OFF
-                deactivateMonitor();
-                mainPage->setProperty("state", "OFF");
-                break;
-            default:
-                qCritical() << "unexpected babyphone state" << oldState;
-        }
+                else
+                    qWarning() << "cannot display activation warning message";
+            }
+            break;
+        case Babyphone::STATE_WAITING:
+        case Babyphone::STATE_ON:
+            // switch OFF
+            deactivateMonitor();
+            itsEngineModel->setState("OFF");
+            break;
+        default:
+            qCritical() << "unexpected babyphone state" << oldState;
     }
-    else
-        qCritical() << "cannot determine new application state";
 }
 
 
@@ -340,10 +350,7 @@ void MainWindow::newCallStatus(bool finish, bool selfInitiated)
     if (finish && selfInitiated) {
         // set new state
         itsBabyphone->setState(Babyphone::STATE_WAITING);
-        if (QObject *mainPage = rootObject()->findChild<QObject*>("mainPage"))
-            mainPage->setProperty("state", "WAITING");
-        else
-            qCritical() << "cannot set GUI waiting state";
+        itsEngineModel->setState("WAITING");
 
         // start activation timeout
         itsActivationDelayTimer.start(itsSettings->itsRecallTimer*1000);
@@ -358,10 +365,7 @@ void MainWindow::newCallStatus(bool finish, bool selfInitiated)
 void MainWindow::activationTimerExpired()
 {
     itsBabyphone->setState(Babyphone::STATE_ON);
-    if (QObject *mainPage = rootObject()->findChild<QObject*>("mainPage"))
-        mainPage->setProperty("state", "ON");
-    else
-        qCritical() << "cannot activate GUI state";
+    itsEngineModel->setState("ON");
 }
 
 
@@ -377,25 +381,39 @@ void MainWindow::bringWindowToFront()
 
 
 /*!
-  newAudioData updates the audio graphs.
+  newAudioData passes the audio data to the engine model and the audio graphs.
+  The model publishes it coalesced to the display refresh rate, the volume
+  graph binds its noise floor and threshold lines to it. The graphs keep every
+  value for their history.
+  It only gets called while the screen is on.
 */
-void MainWindow::newAudioData(int counter, int value)
+void MainWindow::newAudioData(int counter, int value, int floor, int probability)
 {
-    // update GUI if inactive or if set to always update
-    if (!itsIsScreenOff) {
-        // update GUI
-        // volume
-        if (QObject *volume = rootObject()->findChild<QObject*>("volume"))
-            volume->setProperty("text", value);
-        if (AudioLevelGraph *volume_graph = rootObject()->findChild<AudioLevelGraph*>("volume_graph"))
-            volume_graph->addValue(value);
-
-        // duration
-        if (QObject *duration = rootObject()->findChild<QObject*>("duration"))
-            duration->setProperty("text", counter);
-        if (AudioLevelGraph *duration_graph = rootObject()->findChild<AudioLevelGraph*>("duration_graph"))
-            duration_graph->addValue(counter);
-    }
+    itsGraphTime = QDateTime::currentMSecsSinceEpoch();
+
+    itsEngineModel->setAudioData(counter, value, floor,
+                                 itsBabyphone->getVolumeThreshold(floor), probability);
+
+    if (itsVolumeGraph)
+        itsVolumeGraph->addValue(value);
+    if (itsDurationGraph)
+        itsDurationGraph->addValue(counter);
+}
+
+
+/*!
+  keepAudioData stores the audio data for the graphs while the screen is off
+  and no level series is kept to complete them from. The graphs and the model
+  are left alone until the screen turns on again.
+*/
+void MainWindow::keepAudioData(int counter, int value, int floor, int probability)
+{
+    Q_UNUSED(floor);
+    Q_UNUSED(probability);
+
+    itsGraphTime = QDateTime::currentMSecsSinceEpoch();
+    itsDarkCounters.append(counter);
+    itsDarkValues.append(value);
 }
 
 
@@ -427,22 +445,85 @@ void MainWindow::showNotificationError() const
   displayDimmed updates the itsIsScreenOff flag based on DBus messages.
   Consider that itsIsScreenOff will be true even if the application is in
   background but the screen is unlocked.
+  While the screen is off, the audio data is not delivered to the user
+  interface at all. Without level series, it is kept for the graphs instead.
 */
 void MainWindow::displayDimmed(const QDBusMessage &msg)
 {
     QString value = msg.arguments()[0].toString();
-    if (value == "off") {
+    if ( (value == "off") && (!itsIsScreenOff) ) {
         itsIsScreenOff = true;
+
+        disconnect(itsBabyphone, SIGNAL(newAudioData(int,int,int,int)),
+                   this, SLOT(newAudioData(int,int,int,int)));
+        if (!itsBabyphone->getLevelStore()->isOpen())
+            connect(itsBabyphone, SIGNAL(newAudioData(int,int,int,int)),
+                    this, SLOT(keepAudioData(int,int,int,int)));
+        itsEngineModel->setActive(false);
     }
-    else if (value == "on") {
+    else if ( (value == "on") && (itsIsScreenOff) ) {
         itsIsScreenOff = false;
 
-        // clear audio graphs
-        if (AudioLevelGraph *volume_graph = rootObject()->findChild<AudioLevelGraph*>("volume_graph"))
-            volume_graph->clear();
-        if (AudioLevelGraph *duration_graph = rootObject()->findChild<AudioLevelGraph*>("duration_graph"))
-            duration_graph->clear();
+        // complete the audio graphs by the data of the dark period
+        disconnect(itsBabyphone, SIGNAL(newAudioData(int,int,int,int)),
+                   this, SLOT(keepAudioData(int,int,int,int)));
+        backfillGraphs();
+
+        connect(itsBabyphone, SIGNAL(newAudioData(int,int,int,int)),
+                this, SLOT(newAudioData(int,int,int,int)));
+        itsEngineModel->setActive(true);
+    }
+}
+
+
+/*!
+  backfillGraphs adds the audio data missed while the screen was off to the
+  graphs. Without level series, the data kept meanwhile is added to all graphs.
+  Otherwise the zoomable graphs are completed from the level series, the other
+  graphs get cleared.
+*/
+void MainWindow::backfillGraphs()
+{
+    const int chunk = 1024;
+
+    AudioLevelGraph *volume_graph = itsVolumeGraph;
+    AudioLevelGraph *duration_graph = itsDurationGraph;
+    const LevelStore *store = itsBabyphone->getLevelStore();
+
+    if (!store->isOpen()) {
+        for (int i = 0; i < itsDarkValues.size(); ++i) {
+            if (volume_graph)
+                volume_graph->addValue(itsDarkValues.at(i));
+            if (duration_graph)
+                duration_graph->addValue(itsDarkCounters.at(i));
+        }
+        itsDarkCounters.clear();
+        itsDarkValues.clear();
+        return;
+    }
+
+    QList<AudioLevelGraph*> graphs;
+    graphs << volume_graph << duration_graph;
+    foreach (AudioLevelGraph *graph, graphs) {
+        if ( (graph) && (!graph->isZoomable()) )
+            graph->clear();
     }
+
+    // the raw entries are sorted by time, query them in chunks
+    QVector<LevelEntry> entries(chunk);
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    int count;
+    do {
+        count = store->query(LevelStore::TIER_RAW, itsGraphTime, now, entries.data(), chunk);
+        for (int i = 0; i < count; ++i) {
+            const LevelEntry &entry = entries.at(i);
+            if ( (volume_graph) && (volume_graph->isZoomable()) )
+                volume_graph->addValue(entry.maxValue);
+            if ( (duration_graph) && (duration_graph->isZoomable()) )
+                duration_graph->addValue(entry.maxCounter);
+            itsGraphTime = entry.time;
+        }
+    } while (count == chunk);
 }
 
 
@@ -470,3 +551,24 @@ void MainWindow::showHelp()
 {
     QDesktopServices::openUrl(QUrl(URL_HELP));
 }
+
+
+/*!
+  ignoreSound marks the sound of the last notification to be ignored, such
+  that recurring noises like the heating do not notify the parents anymore.
+*/
+void MainWindow::ignoreSound()
+{
+    QString message;
+    if (itsBabyphone->ignoreLastNotification())
+        message = tr("The sound of the last notification will be ignored from now on.");
+    else
+        message = tr("There is no notification sound to ignore.");
+
+    if (QObject *banner = rootObject()->findChild<QObject*>("banner")) {
+        banner->setProperty("text", message);
+        QMetaObject::invokeMethod(banner, "show");
+    }
+    else
+        qWarning() << "Could not display information message.";
+}
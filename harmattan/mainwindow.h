@@ -24,6 +24,9 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
 
 #include "settings.h"
 #include "babyphone.h"
+#include "enginemodel.h"
+
+class AudioLevelGraph;
 
 
 /*!
@@ -45,12 +48,14 @@ private:
     void showFirstRunInfo();
     void activateMonitor();
     void deactivateMonitor();
+    void backfillGraphs();
 
 signals:
     void requestExit();
 
 private slots:
-    void newAudioData(int counter, int value);
+    void newAudioData(int counter, int value, int floor, int probability);
+    void keepAudioData(int counter, int value, int floor, int probability);
     void newCallStatus(bool finish, bool selfInitiated);
     void showNotificationError() const;
     void activationTimerExpired();
@@ -61,6 +66,7 @@ private slots:
     void storeGuiSettings();
     void changeState();
     void showHelp();
+    void ignoreSound();
 
 
 private:
@@ -70,6 +76,20 @@ private:
     //! application status: if true the application is actually shown on the screen
     bool itsIsScreenOff;
 
+    //! time of the latest audio data shown by the graphs, in ms since the epoch
+    qint64 itsGraphTime;
+
+    //! audio data received while the screen is off and no level series is kept
+    QVector<int> itsDarkCounters;
+    QVector<int> itsDarkValues;
+
+    //! engine state the user interface binds to
+    EngineModel *itsEngineModel;
+
+    //! the audio graphs, looked up once after loading the user interface
+    AudioLevelGraph *itsVolumeGraph;
+    AudioLevelGraph *itsDurationGraph;
+
     //! timer for delayed activation
     QTimer itsActivationDelayTimer;
 
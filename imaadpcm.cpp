@@ -0,0 +1,103 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "imaadpcm.h"
+
+
+// step size table of the IMA ADPCM standard
+static const int stepTable[89] = {
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+// step size index adaption, indexed by the magnitude bits of the code
+static const int indexTable[8] = {
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+
+/*!
+  update applies the given code to the state, as done by the decoder.
+*/
+void ImaAdpcm::update(State *state, quint8 code, int step)
+{
+    // difference approximated by the magnitude bits
+    int diff = step >> 3;
+    if (code & 4)
+        diff += step;
+    if (code & 2)
+        diff += step >> 1;
+    if (code & 1)
+        diff += step >> 2;
+
+    if (code & 8)
+        state->predictor = qMax(-32768, state->predictor - diff);
+    else
+        state->predictor = qMin(32767, state->predictor + diff);
+
+    state->index = qBound(0, state->index + indexTable[code & 7], 88);
+}
+
+
+/*!
+  encode returns the 4 bit code of the given sample and updates the state.
+*/
+quint8 ImaAdpcm::encode(State *state, int sample)
+{
+    int step = stepTable[state->index];
+    int diff = sample - state->predictor;
+
+    quint8 code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    // quantize the difference in units of the step size
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+    }
+    if (diff >= step >> 1) {
+        code |= 2;
+        diff -= step >> 1;
+    }
+    if (diff >= step >> 2)
+        code |= 1;
+
+    // track the decoder
+    update(state, code, step);
+
+    return code;
+}
+
+
+/*!
+  decode returns the sample of the given 4 bit code and updates the state.
+*/
+int ImaAdpcm::decode(State *state, quint8 code)
+{
+    update(state, code, stepTable[state->index]);
+    return state->predictor;
+}
@@ -0,0 +1,46 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef IMAADPCM_H
+#define IMAADPCM_H
+
+#include <QtGlobal>
+
+
+/*!
+  ImaAdpcm implements the IMA ADPCM codec, which compresses S16 samples to
+  4 bit. The coder state consists of the predicted sample and the step size
+  index. Encoder and decoder stay in sync as long as they start from the same
+  state.
+*/
+class ImaAdpcm
+{
+public:
+    //! the coder state
+    struct State {
+        int predictor;
+        int index;
+    };
+
+    static quint8 encode(State *state, int sample);
+    static int decode(State *state, quint8 code);
+
+private:
+    static void update(State *state, quint8 code, int step);
+};
+
+#endif // IMAADPCM_H
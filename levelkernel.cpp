@@ -0,0 +1,289 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "levelkernel.h"
+
+#include <cmath>
+
+// determine the SIMD instruction sets we can build
+#if defined(__SSE2__) || defined(__x86_64__)
+  #define LEVELKERNEL_SSE2
+  #include <emmintrin.h>
+  // AVX2 code is compiled per function, this needs the target attribute
+  #if defined(__clang__) || (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+    #define LEVELKERNEL_AVX2
+    #include <immintrin.h>
+  #endif
+#endif
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define LEVELKERNEL_NEON
+  #include <arm_neon.h>
+#endif
+
+
+/*!
+  rms returns the root mean square value of the block.
+*/
+float LevelBlock::rms() const
+{
+    if (count == 0)
+        return 0;
+
+    return sqrt((float)energy / count);
+}
+
+
+/*!
+  analyzeScalar is the reference implementation of the level analysis. It
+  processes the samples one by one.
+*/
+void LevelKernel::analyzeScalar(const qint16 *data, int blocks, int blockSize,
+                                LevelBlock *result)
+{
+    for (int b = 0; b < blocks; ++b) {
+        qint16 max = 0;
+        quint64 energy = 0;
+
+        for (int i = 0; i < blockSize; ++i) {
+            // store maximum
+            if (*data > max)
+                max = *data;
+
+            energy += (qint32)*data * *data;
+
+            // process next sample
+            data++;
+        }
+
+        result[b].peak = max;
+        result[b].count = blockSize;
+        result[b].energy = energy;
+    }
+}
+
+
+#ifdef LEVELKERNEL_SSE2
+/*!
+  analyzeSse2 processes eight samples per instruction. The block size needs to
+  be a multiple of 8.
+  The squared samples are summed up pairwise by madd. The result may reach 2^31
+  and therefore gets interpreted unsigned and widened to 64 bit.
+*/
+static void analyzeSse2(const qint16 *data, int blocks, int blockSize,
+                        LevelBlock *result)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int b = 0; b < blocks; ++b) {
+        __m128i max = zero;
+        __m128i energy = zero;
+
+        for (int i = 0; i < blockSize; i += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i*)data);
+            max = _mm_max_epi16(max, v);
+
+            __m128i sq = _mm_madd_epi16(v, v);
+            energy = _mm_add_epi64(energy, _mm_unpacklo_epi32(sq, zero));
+            energy = _mm_add_epi64(energy, _mm_unpackhi_epi32(sq, zero));
+
+            data += 8;
+        }
+
+        // horizontal reduction
+        max = _mm_max_epi16(max, _mm_srli_si128(max, 8));
+        max = _mm_max_epi16(max, _mm_srli_si128(max, 4));
+        max = _mm_max_epi16(max, _mm_srli_si128(max, 2));
+        energy = _mm_add_epi64(energy, _mm_srli_si128(energy, 8));
+
+        quint64 sum;
+        _mm_storel_epi64((__m128i*)&sum, energy);
+
+        result[b].peak = (qint16)_mm_extract_epi16(max, 0);
+        result[b].count = blockSize;
+        result[b].energy = sum;
+    }
+}
+#endif
+
+
+#ifdef LEVELKERNEL_AVX2
+/*!
+  analyzeAvx2 processes sixteen samples per instruction. The block size needs
+  to be a multiple of 16.
+*/
+__attribute__((target("avx2")))
+static void analyzeAvx2(const qint16 *data, int blocks, int blockSize,
+                        LevelBlock *result)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (int b = 0; b < blocks; ++b) {
+        __m256i max = zero;
+        __m256i energy = zero;
+
+        for (int i = 0; i < blockSize; i += 16) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)data);
+            max = _mm256_max_epi16(max, v);
+
+            __m256i sq = _mm256_madd_epi16(v, v);
+            energy = _mm256_add_epi64(energy, _mm256_unpacklo_epi32(sq, zero));
+            energy = _mm256_add_epi64(energy, _mm256_unpackhi_epi32(sq, zero));
+
+            data += 16;
+        }
+
+        // horizontal reduction, first fold the two 128 bit lanes
+        __m128i max128 = _mm_max_epi16(_mm256_castsi256_si128(max),
+                                       _mm256_extracti128_si256(max, 1));
+        max128 = _mm_max_epi16(max128, _mm_srli_si128(max128, 8));
+        max128 = _mm_max_epi16(max128, _mm_srli_si128(max128, 4));
+        max128 = _mm_max_epi16(max128, _mm_srli_si128(max128, 2));
+
+        __m128i energy128 = _mm_add_epi64(_mm256_castsi256_si128(energy),
+                                          _mm256_extracti128_si256(energy, 1));
+        energy128 = _mm_add_epi64(energy128, _mm_srli_si128(energy128, 8));
+
+        quint64 sum;
+        _mm_storel_epi64((__m128i*)&sum, energy128);
+
+        result[b].peak = (qint16)_mm_extract_epi16(max128, 0);
+        result[b].count = blockSize;
+        result[b].energy = sum;
+    }
+}
+#endif
+
+
+#ifdef LEVELKERNEL_NEON
+/*!
+  analyzeNeon processes eight samples per instruction. The block size needs to
+  be a multiple of 8.
+*/
+static void analyzeNeon(const qint16 *data, int blocks, int blockSize,
+                        LevelBlock *result)
+{
+    for (int b = 0; b < blocks; ++b) {
+        int16x8_t max = vdupq_n_s16(0);
+        uint64x2_t energy = vdupq_n_u64(0);
+
+        for (int i = 0; i < blockSize; i += 8) {
+            int16x8_t v = vld1q_s16(data);
+            max = vmaxq_s16(max, v);
+
+            // a single square fits into 31 bit, hence the unsigned widening
+            int32x4_t sqLow = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+            int32x4_t sqHigh = vmull_s16(vget_high_s16(v), vget_high_s16(v));
+            energy = vpadalq_u32(energy, vreinterpretq_u32_s32(sqLow));
+            energy = vpadalq_u32(energy, vreinterpretq_u32_s32(sqHigh));
+
+            data += 8;
+        }
+
+        // horizontal reduction
+        int16x4_t max64 = vpmax_s16(vget_low_s16(max), vget_high_s16(max));
+        max64 = vpmax_s16(max64, max64);
+        max64 = vpmax_s16(max64, max64);
+
+        result[b].peak = vget_lane_s16(max64, 0);
+        result[b].count = blockSize;
+        result[b].energy = vgetq_lane_u64(energy, 0) + vgetq_lane_u64(energy, 1);
+    }
+}
+#endif
+
+
+/*!
+  isAvailable checks whether the given kernel type is compiled in, supported by
+  the CPU and able to handle the given block size.
+*/
+bool LevelKernel::isAvailable(Type type, int blockSize)
+{
+    switch (type) {
+    case TYPE_SCALAR:
+        return true;
+#ifdef LEVELKERNEL_SSE2
+    case TYPE_SSE2:
+        return (blockSize % 8) == 0;
+#endif
+#ifdef LEVELKERNEL_AVX2
+    case TYPE_AVX2:
+        return ((blockSize % 16) == 0) && __builtin_cpu_supports("avx2");
+#endif
+#ifdef LEVELKERNEL_NEON
+    case TYPE_NEON:
+        return (blockSize % 8) == 0;
+#endif
+    default:
+        return false;
+    }
+}
+
+
+/*!
+  best returns the fastest kernel type available for the given block size.
+*/
+LevelKernel::Type LevelKernel::best(int blockSize)
+{
+    if (isAvailable(TYPE_AVX2, blockSize))
+        return TYPE_AVX2;
+    if (isAvailable(TYPE_SSE2, blockSize))
+        return TYPE_SSE2;
+    if (isAvailable(TYPE_NEON, blockSize))
+        return TYPE_NEON;
+
+    return TYPE_SCALAR;
+}
+
+
+/*!
+  get returns the analysis function of the given kernel type. If the type is
+  not compiled in, the scalar reference implementation is returned.
+*/
+LevelKernel::Function LevelKernel::get(Type type)
+{
+    switch (type) {
+#ifdef LEVELKERNEL_SSE2
+    case TYPE_SSE2:
+        return analyzeSse2;
+#endif
+#ifdef LEVELKERNEL_AVX2
+    case TYPE_AVX2:
+        return analyzeAvx2;
+#endif
+#ifdef LEVELKERNEL_NEON
+    case TYPE_NEON:
+        return analyzeNeon;
+#endif
+    default:
+        return analyzeScalar;
+    }
+}
+
+
+/*!
+  name returns a human readable name of the kernel type.
+*/
+const char *LevelKernel::name(Type type)
+{
+    switch (type) {
+    case TYPE_SCALAR:   return "scalar";
+    case TYPE_SSE2:     return "sse2";
+    case TYPE_AVX2:     return "avx2";
+    case TYPE_NEON:     return "neon";
+    default:            return "unknown";
+    }
+}
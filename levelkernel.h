@@ -0,0 +1,73 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef LEVELKERNEL_H
+#define LEVELKERNEL_H
+
+#include <QtGlobal>
+
+
+/*!
+  LevelBlock holds the analysis result of one audio subinterval.
+*/
+struct LevelBlock
+{
+    //! maximum positive sample value, zero if there is no positive sample
+    qint16 peak;
+    //! number of analysed samples
+    quint16 count;
+    //! sum of the squared sample values
+    quint64 energy;
+
+    float rms() const;
+};
+
+
+/*!
+  LevelKernel provides the block based level analysis of S16 audio samples.
+  The audio buffer is split into consecutive blocks of equal size and for each
+  of them the positive peak, the energy and the sample count are determined.
+
+  Besides the plain C implementation, which serves as reference, there are
+  SIMD variants for SSE2, AVX2 and NEON. The fastest available one is selected
+  at runtime. All variants deliver bit identical results.
+*/
+class LevelKernel
+{
+public:
+    enum Type {
+        TYPE_SCALAR,
+        TYPE_SSE2,
+        TYPE_AVX2,
+        TYPE_NEON,
+        TYPE_COUNT
+    };
+
+    //! signature of the analysis functions
+    typedef void (*Function)(const qint16 *data, int blocks, int blockSize,
+                             LevelBlock *result);
+
+    static bool isAvailable(Type type, int blockSize);
+    static Type best(int blockSize);
+    static Function get(Type type);
+    static const char *name(Type type);
+
+    static void analyzeScalar(const qint16 *data, int blocks, int blockSize,
+                              LevelBlock *result);
+};
+
+#endif // LEVELKERNEL_H
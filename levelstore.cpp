@@ -0,0 +1,335 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "levelstore.h"
+
+#include <string.h>
+
+#include <QDebug>
+
+
+const char LevelStore::MAGIC[8] = { 'B', 'P', 'L', 'E', 'V', 'E', 'L', 'S' };
+
+const quint32 LevelStore::CAPACITY[TIER_COUNT] = {
+    1 << 18,    // raw
+    1 << 17,    // second
+    1 << 16,    // minute
+    1 << 14     // hour
+};
+
+
+/*!
+  The constructor sets up a closed store.
+*/
+LevelStore::LevelStore()
+    : itsHeader(0)
+{
+    for (int t = 0; t < TIER_COUNT; ++t)
+        itsEntries[t] = 0;
+}
+
+
+/*!
+  The destructor unmaps the file.
+*/
+LevelStore::~LevelStore()
+{
+    close();
+}
+
+
+/*!
+  open maps the given store file. A missing file or one of a different layout
+  is initialized empty. It returns false on errors.
+*/
+bool LevelStore::open(const QString &fileName)
+{
+    close();
+
+    itsFile.setFileName(fileName);
+    if (!itsFile.open(QIODevice::ReadWrite)) {
+        qWarning() << "Cannot open level store" << fileName << ":" << itsFile.errorString();
+        return false;
+    }
+
+    bool valid = (itsFile.size() == fileSize());
+    if ( (!valid) && (!itsFile.resize(fileSize())) ) {
+        qWarning() << "Cannot resize level store" << fileName << ":" << itsFile.errorString();
+        itsFile.close();
+        return false;
+    }
+
+    uchar *map = itsFile.map(0, fileSize());
+    if (map == 0) {
+        qWarning() << "Cannot map level store" << fileName << ":" << itsFile.errorString();
+        itsFile.close();
+        return false;
+    }
+
+    itsHeader = (Header*)map;
+    LevelEntry *entries = (LevelEntry*)(map + sizeof(Header));
+    for (int t = 0; t < TIER_COUNT; ++t) {
+        itsEntries[t] = entries;
+        entries += CAPACITY[t];
+    }
+
+    // check the layout
+    if ( (memcmp(itsHeader->magic, MAGIC, sizeof(MAGIC)) != 0) ||
+         (itsHeader->version != VERSION) ||
+         (itsHeader->entrySize != sizeof(LevelEntry)) )
+        valid = false;
+    for (int t = 0; t < TIER_COUNT; ++t) {
+        if ( (itsHeader->tiers[t].capacity != CAPACITY[t]) ||
+             (itsHeader->tiers[t].period != period((Tier)t)) )
+            valid = false;
+    }
+    if (!valid)
+        initialize();
+
+    for (int t = 0; t < TIER_COUNT; ++t)
+        itsAppended[t] = itsHeader->tiers[t].appended;
+
+    return true;
+}
+
+
+/*!
+  close unmaps the file. The data was written by the mapping already.
+*/
+void LevelStore::close()
+{
+    if (itsHeader == 0)
+        return;
+
+    itsFile.unmap((uchar*)itsHeader);
+    itsFile.close();
+
+    itsHeader = 0;
+    for (int t = 0; t < TIER_COUNT; ++t) {
+        itsEntries[t] = 0;
+        itsAppended[t] = 0;
+    }
+}
+
+
+/*!
+  isOpen returns true if the store file is mapped.
+*/
+bool LevelStore::isOpen() const
+{
+    return itsHeader != 0;
+}
+
+
+/*!
+  append stores an audio update of the given time in milliseconds since the
+  epoch. It updates the aggregates of the tiers and stores those whose period
+  is complete. The time never goes backwards, such that the tiers stay sorted
+  on clock changes.
+*/
+void LevelStore::append(qint64 time, int counter, int value)
+{
+    if (itsHeader == 0)
+        return;
+
+    value = qBound(0, value, 32767);
+    counter = qBound(0, counter, 32767);
+
+    quint32 raw = itsHeader->tiers[TIER_RAW].appended;
+    if (raw > 0)
+        time = qMax(time, entry(TIER_RAW, raw-1).time);
+
+    LevelEntry sample;
+    sample.time = time;
+    sample.minValue = value;
+    sample.maxValue = value;
+    sample.meanValue = value;
+    sample.maxCounter = counter;
+    push(TIER_RAW, sample);
+
+    for (int t = TIER_SECOND; t < TIER_COUNT; ++t) {
+        TierHeader &tier = itsHeader->tiers[t];
+        qint64 start = time - time % tier.period;
+
+        // a new period completes the aggregate of the previous one
+        if ( (tier.count > 0) && (start != tier.start) ) {
+            LevelEntry aggregate;
+            aggregate.time = tier.start;
+            aggregate.minValue = tier.minValue;
+            aggregate.maxValue = tier.maxValue;
+            aggregate.meanValue = tier.sum / tier.count;
+            aggregate.maxCounter = tier.maxCounter;
+            push((Tier)t, aggregate);
+
+            tier.count = 0;
+        }
+
+        if (tier.count == 0) {
+            tier.start = start;
+            tier.sum = 0;
+            tier.minValue = value;
+            tier.maxValue = value;
+            tier.maxCounter = counter;
+        }
+
+        tier.sum += value;
+        tier.count++;
+        tier.minValue = qMin<int>(tier.minValue, value);
+        tier.maxValue = qMax<int>(tier.maxValue, value);
+        tier.maxCounter = qMax<int>(tier.maxCounter, counter);
+    }
+}
+
+
+/*!
+  count returns the number of entries of the given tier.
+*/
+int LevelStore::count(Tier tier) const
+{
+    quint32 appended = itsAppended[tier].fetchAndAddAcquire(0);
+    return qMin(appended, CAPACITY[tier]);
+}
+
+
+/*!
+  query copies the entries of the given tier whose periods overlap the time
+  range [from, to), at most maxCount of them, the oldest first. The period
+  being aggregated is not included yet. It returns the number of copied
+  entries.
+*/
+int LevelStore::query(Tier tier, qint64 from, qint64 to, LevelEntry *result,
+                      int maxCount) const
+{
+    if (itsHeader == 0)
+        return 0;
+
+    quint32 end = itsAppended[tier].fetchAndAddAcquire(0);
+    quint32 first = end - qMin(end, CAPACITY[tier]);
+    qint64 length = period(tier);
+
+    // find the first entry ending after the range start
+    quint32 low = first;
+    quint32 high = end;
+    while (low < high) {
+        quint32 middle = low + (high - low) / 2;
+        if (entry(tier, middle).time + length <= from)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    int n = 0;
+    for (quint32 i = low; (i < end) && (n < maxCount); ++i) {
+        const LevelEntry &e = entry(tier, i);
+        if (e.time >= to)
+            break;
+        result[n++] = e;
+    }
+
+    // the writer may have overwritten the oldest entries meanwhile, the one
+    // following the published ones may be incomplete
+    quint32 now = itsAppended[tier].fetchAndAddAcquire(0);
+    if (now - low + 1 > CAPACITY[tier]) {
+        int lost = qMin<quint32>(now - low + 1 - CAPACITY[tier], n);
+        memmove(result, result + lost, (n - lost) * sizeof(LevelEntry));
+        n -= lost;
+    }
+
+    return n;
+}
+
+
+/*!
+  period returns the length of the periods of the given tier in milliseconds.
+  The raw tier has no fixed period, 0 is returned.
+*/
+qint64 LevelStore::period(Tier tier)
+{
+    switch (tier) {
+    case TIER_SECOND:   return 1000;
+    case TIER_MINUTE:   return 60 * 1000;
+    case TIER_HOUR:     return 60 * 60 * 1000;
+    default:            return 0;
+    }
+}
+
+
+/*!
+  tierFor returns the coarsest tier which still shows the given time range
+  with the given number of points.
+*/
+LevelStore::Tier LevelStore::tierFor(qint64 from, qint64 to, int points)
+{
+    qint64 resolution = (to - from) / qMax(1, points);
+
+    for (int t = TIER_COUNT-1; t > TIER_RAW; --t) {
+        if (period((Tier)t) <= resolution)
+            return (Tier)t;
+    }
+    return TIER_RAW;
+}
+
+
+/*!
+  fileSize returns the size of the store file.
+*/
+qint64 LevelStore::fileSize()
+{
+    qint64 size = sizeof(Header);
+    for (int t = 0; t < TIER_COUNT; ++t)
+        size += (qint64)CAPACITY[t] * sizeof(LevelEntry);
+    return size;
+}
+
+
+/*!
+  initialize sets up an empty store in the mapped file.
+*/
+void LevelStore::initialize()
+{
+    memset(itsHeader, 0, sizeof(Header));
+    memcpy(itsHeader->magic, MAGIC, sizeof(MAGIC));
+    itsHeader->version = VERSION;
+    itsHeader->entrySize = sizeof(LevelEntry);
+
+    for (int t = 0; t < TIER_COUNT; ++t) {
+        itsHeader->tiers[t].capacity = CAPACITY[t];
+        itsHeader->tiers[t].period = period((Tier)t);
+    }
+}
+
+
+/*!
+  push appends an entry to the ring of the given tier and publishes it.
+*/
+void LevelStore::push(Tier tier, const LevelEntry &value)
+{
+    quint32 index = itsHeader->tiers[tier].appended;
+    itsEntries[tier][index & (CAPACITY[tier]-1)] = value;
+
+    itsHeader->tiers[tier].appended = index + 1;
+    itsAppended[tier].fetchAndStoreRelease(index + 1);
+}
+
+
+/*!
+  entry returns the entry of the given tier with the given append index.
+*/
+const LevelEntry &LevelStore::entry(Tier tier, quint32 index) const
+{
+    return itsEntries[tier][index & (CAPACITY[tier]-1)];
+}
@@ -0,0 +1,141 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef LEVELSTORE_H
+#define LEVELSTORE_H
+
+#include <QFile>
+#include <QString>
+#include <QAtomicInt>
+
+
+/*!
+  LevelEntry holds the audio levels of one period of time. Entries of the raw
+  tier hold a single audio update, there all values are the same.
+*/
+struct LevelEntry
+{
+    //! start of the period in milliseconds since the epoch
+    qint64 time;
+    //! minimum, maximum and mean volume
+    qint16 minValue;
+    qint16 maxValue;
+    qint16 meanValue;
+    //! maximum audio counter
+    qint16 maxCounter;
+};
+
+
+/*!
+  LevelStore keeps the audio level series persistently in a memory mapped
+  file. Besides the raw audio updates there are tiers of the minimum, maximum
+  and mean levels per second, minute and hour.
+
+  Each tier is a ring of fixed capacity, so the file has a fixed size of about
+  7 MB and the oldest entries get overwritten. The raw tier covers 58 hours of
+  the default 800 ms updates, the second tier 36 hours, the minute tier 45 days
+  and the hour tier almost two years.
+
+  An append writes one raw entry and, whenever a period is complete, one entry
+  of the respective tier. The running aggregates are kept in the file header,
+  such that periods continue across restarts. A query finds the start of the
+  range by binary search and copies the entries.
+
+  There is a single writer. Readers do not take a lock: the writer publishes
+  each entry by an atomic count, and a query drops the entries which got
+  overwritten while it was copying them.
+
+  The file uses the native byte order, it is not meant to be moved between
+  devices.
+*/
+class LevelStore
+{
+public:
+    enum Tier {
+        TIER_RAW,
+        TIER_SECOND,
+        TIER_MINUTE,
+        TIER_HOUR,
+        TIER_COUNT
+    };
+
+    LevelStore();
+    ~LevelStore();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+
+    void append(qint64 time, int counter, int value);
+
+    int count(Tier tier) const;
+    int query(Tier tier, qint64 from, qint64 to, LevelEntry *result, int maxCount) const;
+
+    static qint64 period(Tier tier);
+    static Tier tierFor(qint64 from, qint64 to, int points);
+
+private:
+    //! file format identification
+    static const char MAGIC[8];
+    const static quint32 VERSION = 1;
+    //! number of entries per tier, powers of two
+    static const quint32 CAPACITY[TIER_COUNT];
+
+    /*!
+      TierHeader describes the ring and the running aggregate of a tier.
+    */
+    struct TierHeader
+    {
+        quint32 capacity;
+        quint32 appended;
+        qint64 period;
+        qint64 start;
+        qint64 sum;
+        qint32 count;
+        qint16 minValue;
+        qint16 maxValue;
+        qint16 maxCounter;
+        qint16 reserved[3];
+    };
+
+    /*!
+      Header is stored at the beginning of the file, followed by the rings.
+    */
+    struct Header
+    {
+        char magic[8];
+        quint32 version;
+        quint32 entrySize;
+        TierHeader tiers[TIER_COUNT];
+    };
+
+    static qint64 fileSize();
+    void initialize();
+    void push(Tier tier, const LevelEntry &entry);
+    const LevelEntry &entry(Tier tier, quint32 index) const;
+
+    //! the store file
+    QFile itsFile;
+    //! the mapped file header
+    Header *itsHeader;
+    //! the mapped rings
+    LevelEntry *itsEntries[TIER_COUNT];
+    //! number of entries appended to each tier, published to the readers
+    mutable QAtomicInt itsAppended[TIER_COUNT];
+};
+
+#endif // LEVELSTORE_H
@@ -0,0 +1,127 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "mfccextractor.h"
+#include "spectraldetector.h"
+
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+/*!
+  mel converts a frequency in Hz to the mel scale.
+*/
+static float mel(float frequency)
+{
+    return 2595.0f * log10(1.0f + frequency / 700.0f);
+}
+
+
+/*!
+  hertz converts a mel value to the frequency in Hz.
+*/
+static float hertz(float mel)
+{
+    return 700.0f * (pow(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+
+/*!
+  The constructor sets up the extractor for the analysis rate of 8 kHz.
+*/
+MfccExtractor::MfccExtractor()
+{
+    setup(8000);
+}
+
+
+/*!
+  setup computes the mel filters between MIN_FREQUENCY and the Nyquist
+  frequency of the given sample rate, as well as the DCT table.
+*/
+void MfccExtractor::setup(int rate)
+{
+    const int bins = SpectralDetector::FFT_SIZE / 2;
+    const float binWidth = (float)qMax(1, rate) / SpectralDetector::FFT_SIZE;
+
+    // filter edges, equally spaced in mel
+    float edges[MEL_BANDS + 2];
+    float low = mel(MIN_FREQUENCY);
+    float high = mel(qMax(2 * MIN_FREQUENCY, rate / 2));
+    for (int i = 0; i < MEL_BANDS + 2; ++i)
+        edges[i] = hertz(low + (high - low) * i / (MEL_BANDS + 1)) / binWidth;
+
+    itsWeights.clear();
+    for (int band = 0; band < MEL_BANDS; ++band) {
+        float left = edges[band];
+        float center = edges[band+1];
+        float right = edges[band+2];
+
+        // each filter covers at least one bin, even if narrower
+        int first = qBound(1, (int)ceil(left), bins);
+        int last = qBound(first, (int)floor(right), bins);
+        itsFirstBin[band] = first;
+        itsBinCount[band] = last - first + 1;
+
+        for (int k = first; k <= last; ++k) {
+            float weight;
+            if (k <= center)
+                weight = (center > left) ? (k - left) / (center - left) : 1.0f;
+            else
+                weight = (right > center) ? (right - k) / (right - center) : 1.0f;
+            itsWeights.append(qMax(0.0f, weight));
+        }
+    }
+
+    for (int c = 0; c < MFCC_COUNT; ++c) {
+        for (int band = 0; band < MEL_BANDS; ++band)
+            itsDct[c * MEL_BANDS + band] = cos(M_PI * c * (band + 0.5) / MEL_BANDS);
+    }
+}
+
+
+/*!
+  compute stores the MFCC_COUNT coefficients of the power spectrum of
+  FFT_SIZE/2+1 bins in mfcc.
+*/
+void MfccExtractor::compute(const float *power, float *mfcc) const
+{
+    float energies[MEL_BANDS];
+    const float *weight = itsWeights.constData();
+
+    for (int band = 0; band < MEL_BANDS; ++band) {
+        const float *bin = power + itsFirstBin[band];
+        float sum = 0;
+        for (int k = 0; k < itsBinCount[band]; ++k)
+            sum += weight[k] * bin[k];
+        weight += itsBinCount[band];
+
+        // the offset keeps silence finite
+        energies[band] = log(sum + 1.0f);
+    }
+
+    for (int c = 0; c < MFCC_COUNT; ++c) {
+        const float *dct = itsDct + c * MEL_BANDS;
+        float sum = 0;
+        for (int band = 0; band < MEL_BANDS; ++band)
+            sum += dct[band] * energies[band];
+        mfcc[c] = sum;
+    }
+}
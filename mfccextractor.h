@@ -0,0 +1,60 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MFCCEXTRACTOR_H
+#define MFCCEXTRACTOR_H
+
+#include <QVector>
+
+
+/*!
+  MfccExtractor derives the mel frequency cepstral coefficients of an audio
+  frame from its power spectrum, as computed by SpectralDetector::spectrum.
+
+  The power spectrum is summed up by triangular filters spaced evenly on the
+  mel scale. The logarithms of the filter energies are decorrelated by a
+  DCT-II, of which the first MFCC_COUNT coefficients are kept. Both the filter
+  weights and the DCT table depend on the sample rate only and are computed
+  once by setup.
+*/
+class MfccExtractor
+{
+public:
+    //! number of cepstral coefficients per frame
+    const static int MFCC_COUNT = 13;
+
+    MfccExtractor();
+
+    void setup(int rate);
+    void compute(const float *power, float *mfcc) const;
+
+private:
+    //! number of mel filters
+    const static int MEL_BANDS = 20;
+    //! lowest filter edge in Hz
+    const static int MIN_FREQUENCY = 100;
+
+    //! first bin and number of bins of each filter
+    int itsFirstBin[MEL_BANDS];
+    int itsBinCount[MEL_BANDS];
+    //! the filter weights, consecutive for all filters
+    QVector<float> itsWeights;
+    //! DCT-II coefficients, MFCC_COUNT rows of MEL_BANDS
+    float itsDct[MFCC_COUNT * MEL_BANDS];
+};
+
+#endif // MFCCEXTRACTOR_H
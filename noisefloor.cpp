@@ -0,0 +1,119 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "noisefloor.h"
+
+#include <cmath>
+
+
+/*!
+  The constructor sets up an empty histogram for the values 0 to buckets-1. The
+  given percentile is tracked, while values fade out with the time constant,
+  given in number of values.
+*/
+NoiseFloor::NoiseFloor(int buckets, int percentile, int timeConstant)
+    : itsHistogram(buckets), itsPercentile(qBound(0, percentile, 100))
+{
+    setTimeConstant(timeConstant);
+    reset();
+}
+
+
+/*!
+  setTimeConstant changes the time constant, given in number of values, after
+  which values fade out. The growth factor is below 4, so the product with a
+  weight below 2^MAX_WEIGHT_BITS fits into 64 bits.
+*/
+void NoiseFloor::setTimeConstant(int timeConstant)
+{
+    itsGrowth = (quint64)(exp(1.0 / qMax(1, timeConstant)) * ((quint64)1 << GROWTH_BITS) + 0.5);
+}
+
+
+/*!
+  reset clears the histogram.
+*/
+void NoiseFloor::reset()
+{
+    itsHistogram.fill(0);
+    itsWeight = (quint64)1 << WEIGHT_BITS;
+    itsTotal = 0;
+    itsCursor = 0;
+    itsBelow = 0;
+}
+
+
+/*!
+  add inserts the given value into the histogram and moves the percentile
+  cursor accordingly. Values outside the histogram are clipped.
+*/
+void NoiseFloor::add(int value)
+{
+    int bucket = qBound(0, value, itsHistogram.size()-1);
+
+    itsHistogram[bucket] += itsWeight;
+    itsTotal += itsWeight;
+    if (bucket < itsCursor)
+        itsBelow += itsWeight;
+
+    // move the cursor to the bucket containing the percentile
+    quint64 target = itsTotal / 100 * itsPercentile + itsTotal % 100 * itsPercentile / 100;
+    while ((itsCursor < itsHistogram.size()-1) &&
+           (itsBelow + itsHistogram.at(itsCursor) <= target)) {
+        itsBelow += itsHistogram.at(itsCursor);
+        itsCursor++;
+    }
+    while ((itsCursor > 0) && (itsBelow > target)) {
+        itsCursor--;
+        itsBelow -= itsHistogram.at(itsCursor);
+    }
+
+    // older values fade out as the newer ones get more weight
+    itsWeight = (itsWeight * itsGrowth + ((quint64)1 << (GROWTH_BITS-1))) >> GROWTH_BITS;
+    if (itsWeight > ((quint64)1 << MAX_WEIGHT_BITS))
+        rescale();
+}
+
+
+/*!
+  rescale scales all weights down by 2^(MAX_WEIGHT_BITS-WEIGHT_BITS) to avoid
+  overflow, which happens every 5.5 time constants. The buckets dropping to 0
+  weigh less than 2^-24 of a new value. The totals are summed up again.
+*/
+void NoiseFloor::rescale()
+{
+    const int shift = MAX_WEIGHT_BITS - WEIGHT_BITS;
+
+    itsTotal = 0;
+    itsBelow = 0;
+    for (int i = 0; i < itsHistogram.size(); ++i) {
+        itsHistogram[i] >>= shift;
+        itsTotal += itsHistogram.at(i);
+        if (i < itsCursor)
+            itsBelow += itsHistogram.at(i);
+    }
+    itsWeight >>= shift;
+}
+
+
+/*!
+  level returns the current noise floor, the value of the tracked percentile.
+*/
+int NoiseFloor::level() const
+{
+    return itsCursor;
+}
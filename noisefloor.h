@@ -0,0 +1,75 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef NOISEFLOOR_H
+#define NOISEFLOOR_H
+
+#include <QVector>
+
+
+/*!
+  NoiseFloor estimates the background noise level of a room as a running low
+  percentile of the audio volume values.
+
+  The volume values are collected in a histogram of fixed buckets. Older values
+  fade out with exponential decay. Instead of scaling down all buckets on each
+  update, the weight of new values grows accordingly and the histogram gets
+  rescaled only when the weights become large. The percentile is tracked by a
+  cursor bucket together with the weight below it. As the percentile moves
+  slowly, both updates and queries are O(1).
+
+  The weights are 64 bit integers and the growth factor is fixed point, so the
+  updates use integer arithmetic only. Only setTimeConstant computes the growth
+  factor in floating point.
+*/
+class NoiseFloor
+{
+public:
+    NoiseFloor(int buckets, int percentile, int timeConstant);
+
+    void setTimeConstant(int timeConstant);
+    void add(int value);
+    void reset();
+    int level() const;
+
+private:
+    //! fraction bits of the growth factor
+    const static int GROWTH_BITS = 30;
+    //! initial weight in bits, large enough to keep the growth precise
+    const static int WEIGHT_BITS = 24;
+    //! weight limit in bits, afterwards the histogram gets rescaled
+    const static int MAX_WEIGHT_BITS = 32;
+
+    void rescale();
+
+    //! weighted value histogram
+    QVector<quint64> itsHistogram;
+    //! percentile to track, in percent
+    int itsPercentile;
+    //! growth factor of the weight of new values, inverse of the decay
+    quint64 itsGrowth;
+    //! weight of the next value
+    quint64 itsWeight;
+    //! total weight of the histogram
+    quint64 itsTotal;
+    //! percentile bucket
+    int itsCursor;
+    //! total weight of the buckets below the cursor
+    quint64 itsBelow;
+};
+
+#endif // NOISEFLOOR_H
@@ -0,0 +1,202 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "noisesuppressor.h"
+
+#include <QDebug>
+#include <cmath>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+/*!
+  The constructor sets up a disabled noise suppressor.
+*/
+NoiseSuppressor::NoiseSuppressor()
+    : itsRate(0), itsSubtraction(0), itsProfile(false), itsNoiseFrames(0),
+      itsLearnRemaining(0)
+{
+    // the periodic Hann window sums up to unity at an overlap of half a frame
+    for (int n = 0; n < FRAME_SIZE; ++n)
+        itsWindow[n] = sin(M_PI * n / FRAME_SIZE);
+
+    reset();
+}
+
+
+/*!
+  setup enables the noise suppression for audio of the given sample rate, with
+  the given over-subtraction of the noise power in percent. A rate or
+  subtraction of 0 disables it. Any learned noise profile is dropped.
+*/
+void NoiseSuppressor::setup(int rate, int subtraction)
+{
+    itsRate = (subtraction > 0) ? qMax(0, rate) : 0;
+    itsSubtraction = subtraction / 100.0f;
+    itsProfile = false;
+    itsLearnRemaining = 0;
+
+    reset();
+}
+
+
+/*!
+  isEnabled returns true if the noise suppression is set up for a sample rate.
+*/
+bool NoiseSuppressor::isEnabled() const
+{
+    return itsRate > 0;
+}
+
+
+/*!
+  hasProfile returns true once a noise profile got learned.
+*/
+bool NoiseSuppressor::hasProfile() const
+{
+    return itsProfile;
+}
+
+
+/*!
+  reset drops the buffered audio, as for a new audio stream. The noise profile
+  is kept.
+*/
+void NoiseSuppressor::reset()
+{
+    for (int n = 0; n < FRAME_SIZE; ++n)
+        itsFrame[n] = 0;
+    for (int n = 0; n < HOP_SIZE; ++n) {
+        itsOverlap[n] = 0;
+        itsOutput[n] = 0;
+    }
+    itsFill = 0;
+}
+
+
+/*!
+  learn starts learning a new noise profile from the given number of samples.
+  The previous profile, if any, remains in use until the new one is complete.
+*/
+void NoiseSuppressor::learn(int frames)
+{
+    if (!isEnabled())
+        return;
+
+    for (int k = 0; k < BINS; ++k)
+        itsNoiseSum[k] = 0;
+    itsNoiseFrames = 0;
+    itsLearnRemaining = qMax(0, frames);
+}
+
+
+/*!
+  process suppresses the noise of the given S16 mono samples and writes the
+  same number of samples to output, which may be the input itself. Each time a
+  frame is complete, it is processed and the frame moves on by HOP_SIZE
+  samples. If disabled, the audio is just copied.
+*/
+void NoiseSuppressor::process(const qint16 *input, int frames, qint16 *output)
+{
+    if (!isEnabled()) {
+        if (output != input)
+            memmove(output, input, frames * sizeof(qint16));
+        return;
+    }
+
+    while (frames > 0) {
+        int n = qMin(frames, HOP_SIZE - itsFill);
+
+        // the input is read first, such that it works in place
+        float *frame = itsFrame + HOP_SIZE + itsFill;
+        for (int i = 0; i < n; ++i)
+            frame[i] = input[i];
+        memcpy(output, itsOutput + itsFill, n * sizeof(qint16));
+
+        itsFill += n;
+        input += n;
+        output += n;
+        frames -= n;
+
+        if (itsFill == HOP_SIZE) {
+            processFrame();
+            itsFill = 0;
+        }
+    }
+}
+
+
+/*!
+  processFrame suppresses the noise of the current frame and completes the
+  output samples of its first half. While learning, the power spectrum of the
+  frame is added to the noise profile. The FFT is skipped as long as there is
+  neither a profile to apply nor one to learn.
+*/
+void NoiseSuppressor::processFrame()
+{
+    float samples[FRAME_SIZE];
+    for (int n = 0; n < FRAME_SIZE; ++n)
+        samples[n] = itsWindow[n] * itsFrame[n];
+
+    if (itsProfile || (itsLearnRemaining > 0)) {
+        float re[BINS];
+        float im[BINS];
+        SpectralDetector::transform(samples, re, im);
+
+        if (itsLearnRemaining > 0) {
+            for (int k = 0; k < BINS; ++k)
+                itsNoiseSum[k] += re[k]*re[k] + im[k]*im[k];
+            itsNoiseFrames++;
+
+            itsLearnRemaining -= HOP_SIZE;
+            if (itsLearnRemaining <= 0) {
+                itsLearnRemaining = 0;
+                for (int k = 0; k < BINS; ++k)
+                    itsNoise[k] = itsNoiseSum[k] / itsNoiseFrames;
+                itsProfile = true;
+                qDebug() << "Noise profile learned from" << itsNoiseFrames << "frames";
+            }
+        }
+
+        if (itsProfile) {
+            const float floor = GAIN_FLOOR * GAIN_FLOOR / 10000.0f;
+            for (int k = 0; k < BINS; ++k) {
+                float power = re[k]*re[k] + im[k]*im[k];
+                float gain = floor;
+                if (power > 0)
+                    gain = qMax(floor, 1 - itsSubtraction * itsNoise[k] / power);
+                gain = sqrtf(gain);
+                re[k] *= gain;
+                im[k] *= gain;
+            }
+            SpectralDetector::inverse(re, im, samples);
+        }
+    }
+
+    // overlap-add the first half, keep the second half for the next frame
+    for (int n = 0; n < HOP_SIZE; ++n) {
+        float y = itsOverlap[n] + itsWindow[n] * samples[n];
+        itsOutput[n] = (qint16)qBound(-32768, qRound(y), 32767);
+        itsOverlap[n] = itsWindow[HOP_SIZE + n] * samples[HOP_SIZE + n];
+    }
+
+    // the second half of the frame becomes the first half of the next one
+    memcpy(itsFrame, itsFrame + HOP_SIZE, HOP_SIZE * sizeof(float));
+}
@@ -0,0 +1,96 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef NOISESUPPRESSOR_H
+#define NOISESUPPRESSOR_H
+
+#include <QtGlobal>
+#include "spectraldetector.h"
+
+
+/*!
+  NoiseSuppressor removes stationary background noise, like white noise
+  machines or air purifiers, from the audio by spectral subtraction.
+
+  The S16 mono audio is split into frames of FRAME_SIZE samples, overlapping
+  by half. Each frame gets a square root Hann window and the FFT of the
+  SpectralDetector. The power of each bin is reduced by the learned noise
+  power, scaled by the over-subtraction, but not below GAIN_FLOOR of the
+  original magnitude. After the inverse FFT, the frame gets the window again
+  and is overlap-added to its predecessor. The two windows add up to unity
+  gain, so the audio passes unchanged where there is no noise. The output
+  follows the input with a delay of FRAME_SIZE samples.
+
+  The noise profile is the mean power spectrum of the audio during the learning
+  period requested by learn. Until then, the audio passes unchanged. All
+  buffers are of fixed size, process does not allocate memory.
+*/
+class NoiseSuppressor
+{
+public:
+    //! number of samples of a frame, the FFT size
+    const static int FRAME_SIZE = SpectralDetector::FFT_SIZE;
+
+    NoiseSuppressor();
+
+    void setup(int rate, int subtraction);
+    bool isEnabled() const;
+    bool hasProfile() const;
+    void reset();
+
+    void learn(int frames);
+    void process(const qint16 *input, int frames, qint16 *output);
+
+private:
+    //! number of new samples per frame, half the frame size
+    const static int HOP_SIZE = FRAME_SIZE / 2;
+    //! number of bins from DC to the Nyquist frequency
+    const static int BINS = FRAME_SIZE / 2 + 1;
+    //! minimum gain of a bin in percent, limits the musical noise
+    const static int GAIN_FLOOR = 10;
+
+    void processFrame();
+
+    //! sample rate, 0 if disabled
+    int itsRate;
+    //! factor of the noise power subtracted from each bin
+    float itsSubtraction;
+
+    //! square root Hann window, applied before and after the FFT
+    float itsWindow[FRAME_SIZE];
+    //! samples of the current frame, its second half still filling
+    float itsFrame[FRAME_SIZE];
+    //! number of new samples of the current frame
+    int itsFill;
+    //! second half of the previous output frame, to be overlap-added
+    float itsOverlap[HOP_SIZE];
+    //! completed output samples, delivered while the current frame fills
+    qint16 itsOutput[HOP_SIZE];
+
+    //! mean noise power of each bin
+    float itsNoise[BINS];
+    //! determines whether itsNoise holds a learned profile
+    bool itsProfile;
+    //! summed power of each bin during learning
+    float itsNoiseSum[BINS];
+    //! number of frames summed in itsNoiseSum
+    int itsNoiseFrames;
+    //! number of samples still to learn from, 0 if not learning
+    int itsLearnRemaining;
+};
+
+#endif // NOISESUPPRESSOR_H
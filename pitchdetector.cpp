@@ -0,0 +1,234 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "pitchdetector.h"
+
+#include <string.h>
+
+// determine the SIMD instruction set we can build
+#if defined(__SSE__) || defined(__x86_64__)
+  #define PITCHDETECTOR_SSE
+  #include <xmmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define PITCHDETECTOR_NEON
+  #include <arm_neon.h>
+#endif
+
+
+// about the value recommended by the YIN authors
+const float PitchDetector::YIN_THRESHOLD = 0.15f;
+
+
+/*!
+  difference returns the sum of the squared differences between the given
+  number of samples and the samples shifted by lag. The count needs to be a
+  multiple of 4.
+*/
+static float difference(const float *samples, int count, int lag)
+{
+    const float *shifted = samples + lag;
+
+#if defined(PITCHDETECTOR_SSE)
+    __m128 sum = _mm_setzero_ps();
+    for (int j = 0; j < count; j += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(samples + j), _mm_loadu_ps(shifted + j));
+        sum = _mm_add_ps(sum, _mm_mul_ps(d, d));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(PITCHDETECTOR_NEON)
+    float32x4_t sum = vdupq_n_f32(0);
+    for (int j = 0; j < count; j += 4) {
+        float32x4_t d = vsubq_f32(vld1q_f32(samples + j), vld1q_f32(shifted + j));
+        sum = vmlaq_f32(sum, d, d);
+    }
+    float32x2_t half = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    return vget_lane_f32(vpadd_f32(half, half), 0);
+#else
+    float lanes[4] = { 0, 0, 0, 0 };
+    for (int j = 0; j < count; j += 4) {
+        for (int l = 0; l < 4; ++l) {
+            float d = samples[j+l] - shifted[j+l];
+            lanes[l] += d * d;
+        }
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+}
+
+
+/*!
+  The constructor sets up a disabled detector.
+*/
+PitchDetector::PitchDetector()
+    : itsRate(0), itsMinLag(0), itsMaxLag(0)
+{
+    reset();
+}
+
+
+/*!
+  setup enables the detector for audio of the given sample rate. A rate of 0
+  disables it. The pitch range is limited to the periods from 2 to MAX_LAG
+  samples.
+*/
+void PitchDetector::setup(int rate)
+{
+    itsRate = qMax(0, rate);
+    if (itsRate > 0) {
+        itsMaxLag = qBound(2, itsRate / MIN_PITCH, (int)MAX_LAG);
+        itsMinLag = qBound(2, itsRate / MAX_PITCH, itsMaxLag);
+    }
+
+    reset();
+}
+
+
+/*!
+  isEnabled returns true if the detector is set up for a sample rate.
+*/
+bool PitchDetector::isEnabled() const
+{
+    return itsRate > 0;
+}
+
+
+/*!
+  reset drops the current frame and the collected frame results.
+*/
+void PitchDetector::reset()
+{
+    itsFill = 0;
+    itsPitch = 0;
+    itsHarmonicity = 0;
+    itsPeriodicCount = 0;
+    itsFrameCount = 0;
+    itsScore = 0;
+}
+
+
+/*!
+  write adds the given S16 mono samples. Each time a frame and the samples of
+  the longest period are complete, the frame is analysed and moves on by
+  HOP_SIZE samples.
+*/
+void PitchDetector::write(const qint16 *data, int frames)
+{
+    if (!isEnabled())
+        return;
+
+    const int length = FRAME_SIZE + itsMaxLag;
+
+    while (frames > 0) {
+        int n = qMin(frames, length - itsFill);
+        for (int i = 0; i < n; ++i)
+            itsFrame[itsFill + i] = data[i];
+        itsFill += n;
+        data += n;
+        frames -= n;
+
+        if (itsFill == length) {
+            analyzeFrame();
+
+            // the frames overlap by half
+            memmove(itsFrame, itsFrame + HOP_SIZE, (length - HOP_SIZE) * sizeof(float));
+            itsFill = length - HOP_SIZE;
+        }
+    }
+}
+
+
+/*!
+  score returns the share of periodic frames since the last call, in percent.
+  If no frame got completed since, the previous score is returned.
+*/
+int PitchDetector::score()
+{
+    if (itsFrameCount > 0) {
+        itsScore = (100 * itsPeriodicCount + itsFrameCount/2) / itsFrameCount;
+        itsPeriodicCount = 0;
+        itsFrameCount = 0;
+    }
+
+    return itsScore;
+}
+
+
+/*!
+  pitch returns the pitch of the latest frame in Hz, or 0 if it was aperiodic.
+*/
+int PitchDetector::pitch() const
+{
+    return itsPitch;
+}
+
+
+/*!
+  harmonicity returns how periodic the latest frame was, between 0 for noise
+  and 1 for a perfectly periodic signal.
+*/
+float PitchDetector::harmonicity() const
+{
+    return itsHarmonicity;
+}
+
+
+/*!
+  analyzeFrame determines the pitch and the harmonicity of the current frame.
+  The difference function is normalized by its cumulative mean, the first
+  minimum below YIN_THRESHOLD in the period range is taken as period. Without
+  such a minimum, the frame is aperiodic and its harmonicity is derived from
+  the global minimum of the range.
+*/
+void PitchDetector::analyzeFrame()
+{
+    float normalized[MAX_LAG + 1];
+    float cumulative = 0;
+
+    for (int lag = 1; lag <= itsMaxLag; ++lag) {
+        float d = difference(itsFrame, FRAME_SIZE, lag);
+        cumulative += d;
+        // silence counts as aperiodic
+        normalized[lag] = (cumulative > 0) ? d * lag / cumulative : 1.0f;
+    }
+
+    int period = 0;
+    int best = itsMinLag;
+    for (int lag = itsMinLag; lag <= itsMaxLag; ++lag) {
+        if (normalized[lag] < normalized[best])
+            best = lag;
+        if ( (period == 0) && (normalized[lag] < YIN_THRESHOLD) ) {
+            // follow the dip to its minimum
+            period = lag;
+            while ( (period < itsMaxLag) && (normalized[period+1] < normalized[period]) )
+                period++;
+            break;
+        }
+    }
+
+    itsFrameCount++;
+    if (period > 0) {
+        itsPeriodicCount++;
+        itsPitch = itsRate / period;
+        itsHarmonicity = qMax(0.0f, 1.0f - normalized[period]);
+    }
+    else {
+        itsPitch = 0;
+        itsHarmonicity = qMax(0.0f, 1.0f - normalized[best]);
+    }
+}
@@ -0,0 +1,97 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PITCHDETECTOR_H
+#define PITCHDETECTOR_H
+
+#include <QtGlobal>
+
+
+/*!
+  PitchDetector tells periodic audio in the pitch range of infant vocalization
+  apart from broadband noise, using the YIN algorithm.
+
+  The S16 mono audio is split into frames of FRAME_SIZE samples, which overlap
+  by half. For each frame the difference function d(tau), the sum of the
+  squared differences between the frame and the frame shifted by tau, is
+  computed up to the longest period of the pitch range. This is the costly
+  part and runs four samples at a time with SSE or NEON where available.
+  The cumulative mean normalized difference of the shortest period below
+  YIN_THRESHOLD within the pitch range gives the pitch and the harmonicity of
+  the frame.
+
+  Instead of a value per frame, the caller gets the share of periodic frames
+  since the last query, in percent.
+*/
+class PitchDetector
+{
+public:
+    //! number of samples of a frame
+    const static int FRAME_SIZE = 256;
+    //! processing time budget of a frame on the target devices, in microseconds
+    const static int FRAME_BUDGET = 100;
+
+    PitchDetector();
+
+    void setup(int rate);
+    bool isEnabled() const;
+    void reset();
+
+    void write(const qint16 *data, int frames);
+    int score();
+
+    int pitch() const;
+    float harmonicity() const;
+
+private:
+    //! number of new samples per frame, half the frame size
+    const static int HOP_SIZE = FRAME_SIZE / 2;
+    //! infant vocalization pitch range in Hz
+    const static int MIN_PITCH = 200;
+    const static int MAX_PITCH = 1000;
+    //! longest supported period in samples, covers MIN_PITCH at 8 kHz
+    const static int MAX_LAG = 64;
+    //! normalized difference below which a frame counts as periodic
+    static const float YIN_THRESHOLD;
+
+    void analyzeFrame();
+
+    //! sample rate, 0 if disabled
+    int itsRate;
+    //! period range in samples
+    int itsMinLag;
+    int itsMaxLag;
+
+    //! samples of the current frame, followed by the samples of the longest period
+    float itsFrame[FRAME_SIZE + MAX_LAG];
+    //! number of samples of the current frame
+    int itsFill;
+
+    //! pitch of the latest frame in Hz, 0 if aperiodic
+    int itsPitch;
+    //! harmonicity of the latest frame, between 0 and 1
+    float itsHarmonicity;
+
+    //! number of periodic frames since the last query
+    int itsPeriodicCount;
+    //! number of frames since the last query
+    int itsFrameCount;
+    //! latest score, repeated if no frame completed in between
+    int itsScore;
+};
+
+#endif // PITCHDETECTOR_H
@@ -0,0 +1,1198 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QCoreApplication>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QDir>
+#include <QFile>
+#include <QDataStream>
+#include <QSettings>
+#include <QVector>
+#include <QThread>
+#include <cmath>
+
+#include "settings.h"
+#include "levelkernel.h"
+#include "formatkernel.h"
+#include "volumescale.h"
+#include "levelstore.h"
+#include "spectraldetector.h"
+#include "goertzelbank.h"
+#include "pitchdetector.h"
+#include "cryclassifier.h"
+#include "dspgraph.h"
+#include "biquadchain.h"
+#include "noisesuppressor.h"
+#include "taskpool.h"
+#include "fingerprintindex.h"
+#include "fingerprinter.h"
+#include "wavfile.h"
+#include "replaysession.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+static void usage(QTextStream &err)
+{
+    err << "usage: babyphone-replay [options] FILE\n"
+           "\n"
+           "Replays a WAV or raw S16LE recording through the babyphone audio\n"
+           "detection and prints the update and trigger series.\n"
+           "\n"
+           "  --raw                  input is headerless S16LE audio\n"
+           "  --rate HZ              sample rate of raw input (default 8000)\n"
+           "  --channels N           channel count of raw input (default 1)\n"
+           "  --volume N             audio volume setting\n"
+           "  --duration N           audio duration setting\n"
+           "  --activation-delay S   activation delay in seconds\n"
+           "  --recall-timeout S     recall timeout in seconds\n"
+           "  --call-duration S      assumed notification call duration in seconds\n"
+           "  --kernel NAME          level analysis kernel (scalar, sse2, avx2, neon)\n"
+           "  --check-kernels        compare the output of all available kernels\n"
+           "  --volume-scale NAME    volume computation (float, fixed)\n"
+           "  --check-fixed-point    compare the fixed point to the float output\n"
+           "  --window MS            sliding detection window length, 0 for fixed\n"
+           "                         intervals (default 0)\n"
+           "  --hop MS               sliding detection window step (default 100)\n"
+           "  --clips DIR            save the audio history of each trigger to DIR\n"
+           "  --history S            audio history duration in seconds (default 60)\n"
+           "  --level-store FILE     store the updates in the level series FILE, its\n"
+           "                         time starts at the epoch (use a new file)\n"
+           "  --spectral PERCENT     minimum spectral cry score for loud audio to\n"
+           "                         count, 0 to disable (default 0)\n"
+           "  --tones HZ,HZ,...      rate the spectral score by Goertzel filters of\n"
+           "                         these frequencies instead of the full FFT\n"
+           "  --pitch PERCENT        minimum share of periodic frames for loud audio\n"
+           "                         to count, 0 to disable (default 0)\n"
+           "  --classifier FILE      rate the audio by the cry classifier model FILE,\n"
+           "                         the probability is appended to the updates\n"
+           "  --classifier-threshold PERCENT\n"
+           "                         minimum cry probability for loud audio to count,\n"
+           "                         0 to only report it (default 0)\n"
+           "  --pipeline FILE        rate the audio by the detector pipeline FILE\n"
+           "                         instead of the detector options above\n"
+           "  --cascade-window S     run the detectors and the classifier only for S\n"
+           "                         seconds once woken, 0 to run them all the time\n"
+           "                         (default 0)\n"
+           "  --cascade-level PERCENT\n"
+           "                         counter level waking the detectors, in percent\n"
+           "                         of the threshold (default 50)\n"
+           "  --dc-block             remove DC ahead of the level analysis\n"
+           "  --high-pass HZ         high pass the audio of the level analysis at HZ,\n"
+           "                         0 to disable (default 0)\n"
+           "  --a-weighting          A-weight the audio of the level analysis\n"
+           "  --noise-suppression PERCENT\n"
+           "                         subtract the noise learned during the activation\n"
+           "                         delay from the audio of the detection, scaled by\n"
+           "                         PERCENT, 0 to disable (default 0)\n"
+           "  --ensemble RULE        combine the detectors with the volume threshold\n"
+           "                         by all, any, vote or mean (default all)\n"
+           "  --detector-threads N   run the detectors in parallel on N additional\n"
+           "                         threads (default 0)\n"
+           "  --ignore-sounds FILE   ignore loud audio recognized as one of the sounds\n"
+           "                         of FILE\n"
+           "  --learn-sound          add the last seconds of the recording to the\n"
+           "                         sounds of --ignore-sounds\n"
+           "  --compare-window       compare the trigger times of the sliding window\n"
+           "                         to the fixed intervals\n"
+           "  --check-graph          check the buffer assignment of detector graphs\n"
+           "                         and their parallel against their sequential\n"
+           "                         decisions, no FILE needed\n"
+           "  --check-fft            compare the FFT to a direct DFT and its inverse\n"
+           "                         to the input, no FILE needed\n"
+           "  --check-biquad         compare the block to the scalar level filter,\n"
+           "                         no FILE needed\n"
+           "  --check-suppressor     check that the noise suppression passes audio\n"
+           "                         unchanged without noise, no FILE needed\n"
+           "  --benchmark-volume     measure the float and fixed point volume\n"
+           "                         computation, no FILE needed\n"
+           "  --benchmark-spectral   measure the FFT, Goertzel, pitch and classifier\n"
+           "                         detectors, their parallel ensemble, the noise\n"
+           "                         suppression, the fingerprinter and the level\n"
+           "                         filter against the level analysis, no FILE\n"
+           "                         needed\n";
+}
+
+
+/*!
+  benchmarkVolume measures the speed of the volume computations on a fixed
+  series of pseudo random interval energies.
+*/
+static void benchmarkVolume(const Settings &settings, QTextStream &out)
+{
+    const int count = 1000000;
+    const int intervalFrames = 8000 * settings.AUDIO_SAMPLE_INTERVAL / 1000;
+    const int blockSize = settings.AUDIO_SAMPLE_SUBINTERVAL;
+
+    QVector<quint64> energies(count);
+    quint32 random = 1;
+    for (int i = 0; i < count; ++i) {
+        random = random * 1103515245 + 12345;
+        // up to the maximum energy of 400 subintervals of full scale audio
+        energies[i] = random % (400 * 32768);
+    }
+
+    for (int type = 0; type < VolumeScale::TYPE_COUNT; ++type) {
+        QElapsedTimer timer;
+        timer.start();
+
+        // the sum keeps the compiler from dropping the computation
+        qint64 sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += VolumeScale::volume((VolumeScale::Type)type, settings.itsAudioAmplify,
+                                       energies.at(i), blockSize, intervalFrames);
+        qint64 elapsed = timer.elapsed();
+
+        out << VolumeScale::name((VolumeScale::Type)type) << ": "
+            << elapsed * 1000000 / count << " ns per interval (checksum " << sum << ")\n";
+    }
+}
+
+
+/*!
+  writeRandomModel writes a cry classifier model of pseudo random weights with
+  the given context frames and layer widths. It is meant for benchmarks only
+  and documents the model format by example.
+*/
+static bool writeRandomModel(const QString &fileName, int context,
+                             const QList<int> &widths)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 random = 1;
+    int inputs = context * MfccExtractor::MFCC_COUNT;
+    out.writeRawData("BPCC", 4);
+    out << (quint32)1 << (quint32)context;
+    for (int i = 0; i < inputs; ++i)
+        out << 0.0f;
+    for (int i = 0; i < inputs; ++i)
+        out << 0.1f;
+
+    out << (quint32)(widths.size() + 1);
+    for (int l = 0; l <= widths.size(); ++l) {
+        int outputs = (l < widths.size()) ? widths.at(l) : 1;
+        out << (quint32)inputs << (quint32)outputs << 0.05f;
+        for (int o = 0; o < outputs; ++o)
+            out << 0.002f;
+        for (int o = 0; o < outputs; ++o)
+            out << (qint32)0;
+        for (int i = 0; i < outputs * inputs; ++i) {
+            random = random * 1103515245 + 12345;
+            out << (qint8)((int)((random >> 16) % 255) - 127);
+        }
+        inputs = outputs;
+    }
+
+    return out.status() == QDataStream::Ok;
+}
+
+
+/*!
+  benchmarkSpectral measures the processing time of one minute of pseudo random
+  audio at the analysis rate, by the level analysis kernels of the peak
+  detection, by the FFT spectral detector, by Goertzel filter banks of
+  increasing size, by the pitch detector, by a detector pipeline, by the noise
+  suppression, by the fingerprinter against a full index of ignored sounds, by
+  a cry classifier of typical size, by an ensemble of these detectors and by
+  the level filter. The saving and loading of the index is timed as well. The
+  spectral detector and the filter are checked against the scalar level
+  analysis, the pitch detector against its frame budget, the classifier against
+  a share of one core and the parallel ensemble against its slowest detector.
+*/
+static void benchmarkSpectral(const Settings &settings, QTextStream &out)
+{
+    const int rate = settings.AUDIO_ANALYSIS_RATE;
+    const int frames = 60 * rate;
+    const int blockSize = settings.AUDIO_SAMPLE_SUBINTERVAL;
+    const int repeat = 20;
+
+    QVector<qint16> samples(frames);
+    quint32 random = 1;
+    for (int i = 0; i < frames; ++i) {
+        random = random * 1103515245 + 12345;
+        samples[i] = (qint16)(random >> 16);
+    }
+
+    // the level analysis kernels, the scalar one is the budget of the
+    // spectral detector and of the level filter
+    QElapsedTimer timer;
+    QVector<LevelBlock> blocks(frames / blockSize);
+    qint64 levelTime = 0;
+    for (int type = 0; type < LevelKernel::TYPE_COUNT; ++type) {
+        if (!LevelKernel::isAvailable((LevelKernel::Type)type, blockSize))
+            continue;
+
+        LevelKernel::Function analyze = LevelKernel::get((LevelKernel::Type)type);
+        timer.start();
+        quint64 sum = 0;
+        for (int r = 0; r < repeat; ++r) {
+            analyze(samples.constData(), blocks.size(), blockSize, blocks.data());
+            sum += blocks.at(r).energy;
+        }
+        qint64 elapsed = timer.elapsed();
+        if (type == LevelKernel::TYPE_SCALAR)
+            levelTime = elapsed;
+        out << "level " << LevelKernel::name((LevelKernel::Type)type) << ": "
+            << elapsed * 1000 / (60 * repeat)
+            << " us per second of audio (checksum " << sum << ")\n";
+    }
+
+    SpectralDetector detector;
+    detector.setup(rate);
+    timer.start();
+    int score = 0;
+    for (int r = 0; r < repeat; ++r) {
+        detector.write(samples.constData(), frames);
+        score += detector.score();
+    }
+    qint64 elapsed = timer.elapsed();
+    out << "spectral: " << elapsed * 1000 / (60 * repeat) << " us per second of audio, budget "
+        << levelTime * 1000 / (60 * repeat) << " us"
+        << (elapsed <= levelTime ? ": ok" : ": EXCEEDED")
+        << " (checksum " << score << ")\n";
+
+    // frequencies spread evenly below the Nyquist frequency
+    for (int bins = 4; bins <= GoertzelBank::MAX_BINS; bins *= 2) {
+        QList<int> frequencies;
+        for (int i = 1; i <= bins; ++i)
+            frequencies.append(i * rate / (2 * (bins+1)));
+
+        GoertzelBank bank;
+        bank.setup(rate, frequencies);
+        timer.start();
+        score = 0;
+        for (int r = 0; r < repeat; ++r) {
+            bank.write(samples.constData(), frames);
+            score += bank.score();
+        }
+        out << "goertzel " << bank.bins() << " bins: "
+            << timer.elapsed() * 1000 / (60 * repeat)
+            << " us per second of audio (checksum " << score << ")\n";
+    }
+
+    PitchDetector pitch;
+    pitch.setup(rate);
+    timer.start();
+    score = 0;
+    for (int r = 0; r < repeat; ++r) {
+        pitch.write(samples.constData(), frames);
+        score += pitch.score();
+    }
+    elapsed = timer.elapsed();
+    // the frames overlap by half
+    qint64 pitchFrames = (qint64)frames * repeat * 2 / PitchDetector::FRAME_SIZE;
+    qint64 frameTime = elapsed * 1000000 / pitchFrames;
+    out << "pitch: " << elapsed * 1000 / (60 * repeat)
+        << " us per second of audio, " << frameTime << " ns per frame, budget "
+        << PitchDetector::FRAME_BUDGET << " us"
+        << (frameTime <= PitchDetector::FRAME_BUDGET * 1000 ? ": ok" : ": EXCEEDED")
+        << " (checksum " << score << ")\n";
+
+    // spectral and pitch detector behind a DC filter, written in chunks of an
+    // analysis interval as by the audio monitor
+    DspGraph pipeline;
+    pipeline.setup(rate);
+    QVariantMap parameters;
+    pipeline.addNode("clean", "dcblock", parameters);
+    parameters.insert("input", "clean");
+    pipeline.addNode("spectral", "spectral", parameters);
+    pipeline.addNode("pitch", "pitch", parameters);
+    pipeline.schedule(QString(), QString());
+    const int chunk = rate * settings.AUDIO_SAMPLE_INTERVAL / 1000;
+    timer.start();
+    for (int r = 0; r < repeat; ++r) {
+        for (int pos = 0; pos < frames; pos += chunk)
+            pipeline.write(samples.constData() + pos, qMin(chunk, frames - pos));
+        pipeline.evaluate();
+    }
+    out << "pipeline of dcblock, spectral and pitch: " << timer.elapsed() * 1000 / (60 * repeat)
+        << " us per second of audio, " << pipeline.buffers() << " buffers\n";
+
+    // noise suppression with a profile of the first half
+    NoiseSuppressor suppressor;
+    suppressor.setup(rate, 200);
+    suppressor.learn(frames / 2);
+    QVector<qint16> suppressed(frames);
+    timer.start();
+    for (int r = 0; r < repeat; ++r)
+        suppressor.process(samples.constData(), frames, suppressed.data());
+    out << "noise suppression: " << timer.elapsed() * 1000 / (60 * repeat)
+        << " us per second of audio (checksum " << suppressed.at(frames-1) << ")\n";
+
+    // the fingerprinter against the maximum number of sounds of random
+    // landmarks, about ten seconds each, on noise bursts of half a second
+    FingerprintIndex index(rate);
+    QVector<Landmark> landmarks(5000);
+    for (int sound = 0; sound < FingerprintIndex::MAX_SOUNDS; ++sound) {
+        for (int i = 0; i < landmarks.size(); ++i) {
+            random = random * 1103515245 + 12345;
+            landmarks[i].hash = random >> 12;
+            landmarks[i].time = i / 10;
+        }
+        index.addSound(landmarks);
+    }
+    QVector<qint16> bursts(samples);
+    for (int i = 0; i < frames; ++i)
+        if ((i / (rate / 2)) % 2 == 0)
+            bursts[i] = 0;
+    Fingerprinter fingerprinter;
+    fingerprinter.setup(rate, &index);
+    timer.start();
+    score = 0;
+    for (int r = 0; r < repeat; ++r) {
+        for (int pos = 0; pos < frames; pos += chunk) {
+            fingerprinter.write(bursts.constData() + pos, qMin(chunk, frames - pos));
+            score += fingerprinter.isMatching();
+        }
+    }
+    out << "fingerprinter against " << index.sounds() << " sounds of " << index.size()
+        << " landmarks: " << timer.elapsed() * 1000 / (60 * repeat)
+        << " us per second of audio (checksum " << score << ")\n";
+
+    QString sounds = QDir::tempPath() + "/babyphone-benchmark-sounds";
+    timer.start();
+    bool saved = index.save(sounds);
+    qint64 saveTime = timer.elapsed();
+    timer.start();
+    bool loaded = saved && index.load(sounds);
+    out << "ignored sounds file: saved in " << saveTime << " ms, loaded in "
+        << timer.elapsed() << " ms" << (loaded ? "" : ": FAILED") << "\n";
+    QFile::remove(sounds);
+
+    // 8 frames of context, two hidden layers
+    QString model = QDir::tempPath() + "/babyphone-benchmark-model";
+    QList<int> widths;
+    widths << 64 << 32;
+    CryClassifier classifier;
+    if (writeRandomModel(model, 8, widths) && classifier.load(model, rate)) {
+        timer.start();
+        score = 0;
+        for (int r = 0; r < repeat; ++r) {
+            classifier.write(samples.constData(), frames);
+            score += classifier.probability();
+        }
+        elapsed = timer.elapsed();
+        // a few percent of one core at most
+        qint64 load = elapsed * 100000 / (60 * repeat * 1000);
+        out << "classifier: " << elapsed * 1000 / (60 * repeat)
+            << " us per second of audio, " << load / 1000.0
+            << "% of one core, budget 3%" << (load <= 3000 ? ": ok" : ": EXCEEDED")
+            << " (checksum " << score << ")\n";
+    }
+    else
+        out << "classifier: cannot create benchmark model\n";
+
+    // the FFT, pitch and classifier detectors of an ensemble, written in chunks
+    // of an analysis interval, one after the other and on the remaining cores
+    if (classifier.isEnabled()) {
+        const char * const types[] = { "spectral", "pitch", "classifier" };
+        const int count = sizeof(types) / sizeof(types[0]);
+        TaskPool pool(qMax(0, QThread::idealThreadCount() - 1));
+        QVariantMap parameters;
+        parameters.insert("model", model);
+
+        // the slowest detector on its own, the ensemble without and with pool
+        qint64 slowest = 0;
+        qint64 times[2];
+        for (int run = 0; run < count + 2; ++run) {
+            DspGraph ensemble;
+            ensemble.setup(rate);
+            for (int k = 0; k < count; ++k)
+                if ( (run == k) || (run >= count) )
+                    ensemble.addNode(types[k], types[k], parameters);
+            ensemble.schedule(QString(), QString());
+            if (run == count + 1)
+                ensemble.setPool(&pool);
+
+            timer.start();
+            for (int r = 0; r < repeat; ++r) {
+                for (int pos = 0; pos < frames; pos += chunk)
+                    ensemble.write(samples.constData() + pos, qMin(chunk, frames - pos));
+                ensemble.evaluate();
+            }
+            elapsed = timer.elapsed();
+            if (run < count)
+                slowest = qMax(slowest, elapsed);
+            else
+                times[run - count] = elapsed;
+        }
+
+        // the parallel ensemble may exceed its slowest detector by a quarter
+        out << "ensemble of spectral, pitch and classifier: "
+            << times[0] * 1000 / (60 * repeat) << " us per second of audio, "
+            << times[1] * 1000 / (60 * repeat) << " us on " << pool.threads()
+            << " detector threads, slowest detector " << slowest * 1000 / (60 * repeat)
+            << " us";
+        if (pool.threads() > 0)
+            out << (times[1] * 4 <= slowest * 5 ? ": ok" : ": EXCEEDED");
+        out << "\n";
+    }
+    QFile::remove(model);
+
+    // DC blocker, high pass and high pass with A-weighting
+    for (int config = 0; config < 3; ++config) {
+        BiquadChain filter;
+        filter.setup(rate, config == 0, config > 0 ? 100 : 0, config == 2);
+        QVector<qint16> audio(samples);
+        timer.start();
+        for (int r = 0; r < repeat; ++r)
+            filter.process(audio.data(), frames);
+        elapsed = timer.elapsed();
+        out << "filter of " << filter.sections() << " sections: "
+            << elapsed * 1000 / (60 * repeat) << " us per second of audio, budget "
+            << levelTime * 1000 / (60 * repeat) << " us"
+            << (elapsed <= levelTime ? ": ok" : ": EXCEEDED")
+            << " (checksum " << audio.at(frames-1) << ")\n";
+    }
+}
+
+
+/*!
+  randomAudio fills the given samples with pseudo random audio, which gets
+  quieter every second over four seconds.
+*/
+static void randomAudio(QVector<qint16> *samples, int rate)
+{
+    quint32 random = 1;
+    for (int i = 0; i < samples->size(); ++i) {
+        random = random * 1103515245 + 12345;
+        (*samples)[i] = (qint16)(random >> 16) / (1 + (i / rate) % 4);
+    }
+}
+
+
+/*!
+  checkFft compares the FFT of the SpectralDetector on pseudo random frames to
+  a direct DFT in double precision, and the inverse FFT to the input frame. The
+  errors are relative to the largest bin and to the largest sample. It returns
+  0 if both stay below 1e-5.
+*/
+static int checkFft(QTextStream &out)
+{
+    const int size = SpectralDetector::FFT_SIZE;
+    const int bins = size / 2 + 1;
+    const double limit = 1e-5;
+
+    QVector<qint16> samples(8 * size);
+    randomAudio(&samples, size);
+
+    double transformError = 0;
+    double inverseError = 0;
+    for (int frame = 0; frame < samples.size() / size; ++frame) {
+        float data[size];
+        float maxSample = 0;
+        for (int n = 0; n < size; ++n) {
+            data[n] = samples.at(frame * size + n);
+            maxSample = qMax(maxSample, qAbs(data[n]));
+        }
+
+        float re[bins];
+        float im[bins];
+        SpectralDetector::transform(data, re, im);
+
+        double dftRe[bins];
+        double dftIm[bins];
+        double maxBin = 0;
+        for (int k = 0; k < bins; ++k) {
+            dftRe[k] = 0;
+            dftIm[k] = 0;
+            for (int n = 0; n < size; ++n) {
+                double phase = 2 * M_PI * ((k * n) % size) / size;
+                dftRe[k] += data[n] * cos(phase);
+                dftIm[k] -= data[n] * sin(phase);
+            }
+            maxBin = qMax(maxBin, sqrt(dftRe[k]*dftRe[k] + dftIm[k]*dftIm[k]));
+        }
+        for (int k = 0; k < bins; ++k) {
+            double error = sqrt((re[k] - dftRe[k]) * (re[k] - dftRe[k]) +
+                                (im[k] - dftIm[k]) * (im[k] - dftIm[k]));
+            transformError = qMax(transformError, error / maxBin);
+        }
+
+        float result[size];
+        SpectralDetector::inverse(re, im, result);
+        for (int n = 0; n < size; ++n)
+            inverseError = qMax(inverseError, (double)qAbs(result[n] - data[n]) / maxSample);
+    }
+
+    bool ok = (transformError < limit) && (inverseError < limit);
+    out << "fft of " << size << " samples: error " << transformError
+        << ", inverse error " << inverseError << (ok ? ": ok" : ": FAILED") << "\n";
+    return ok ? 0 : 1;
+}
+
+
+/*!
+  checkBiquad compares the block filtering of the BiquadChain to its plain
+  recursion, for the filter configurations of the level analysis at the
+  analysis rate and at half of it. A single sample is always filtered by the
+  recursion. Both run in single precision, and the pole of the DC blocker
+  close to 1 amplifies their rounding differently, so a difference of a few
+  LSB is tolerated. It returns 0 if all configurations pass.
+*/
+static int checkBiquad(const Settings &settings, QTextStream &out)
+{
+    const int rates[] = { settings.AUDIO_ANALYSIS_RATE, settings.AUDIO_ANALYSIS_RATE / 2 };
+    const int limit = 8;
+    int result = 0;
+    for (int r = 0; r < 2; ++r) {
+        // an odd length, such that the block filter ends with the recursion
+        QVector<qint16> samples(10 * rates[r] + 3);
+        randomAudio(&samples, rates[r]);
+
+        // DC blocker, high pass and high pass with A-weighting
+        for (int config = 0; config < 3; ++config) {
+            BiquadChain block;
+            BiquadChain scalar;
+            block.setup(rates[r], config == 0, config > 0 ? 100 : 0, config == 2);
+            scalar.setup(rates[r], config == 0, config > 0 ? 100 : 0, config == 2);
+
+            QVector<qint16> blockOut(samples);
+            QVector<qint16> scalarOut(samples);
+            block.process(blockOut.data(), blockOut.size());
+            for (int i = 0; i < scalarOut.size(); ++i)
+                scalar.process(scalarOut.data() + i, 1);
+
+            int maxDifference = 0;
+            for (int i = 0; i < samples.size(); ++i)
+                maxDifference = qMax(maxDifference, qAbs(blockOut.at(i) - scalarOut.at(i)));
+
+            bool ok = (maxDifference <= limit);
+            out << "filter of " << block.sections() << " sections at " << rates[r]
+                << " Hz: maximum difference " << maxDifference << (ok ? ": ok" : ": FAILED")
+                << "\n";
+            if (!ok)
+                result = 1;
+        }
+    }
+
+    return result;
+}
+
+
+/*!
+  checkSuppressor checks that the NoiseSuppressor passes pseudo random audio
+  unchanged, delayed by a frame, without a noise profile and with the profile of
+  silence. The latter runs each frame through the FFT and its inverse, a
+  difference by the rounding of a sample is tolerated. It returns 0 if both
+  pass.
+*/
+static int checkSuppressor(const Settings &settings, QTextStream &out)
+{
+    const int rate = settings.AUDIO_ANALYSIS_RATE;
+    const int delay = NoiseSuppressor::FRAME_SIZE;
+    const int chunk = rate * settings.AUDIO_SAMPLE_INTERVAL / 1000;
+    QVector<qint16> samples(10 * rate);
+    randomAudio(&samples, rate);
+
+    int result = 0;
+    for (int profile = 0; profile < 2; ++profile) {
+        NoiseSuppressor suppressor;
+        suppressor.setup(rate, 200);
+        if (profile) {
+            // a frame more than learned, such that the learning is complete
+            QVector<qint16> silence(rate + delay);
+            suppressor.learn(rate);
+            suppressor.process(silence.constData(), silence.size(), silence.data());
+            suppressor.reset();
+        }
+
+        QVector<qint16> output(samples.size());
+        for (int pos = 0; pos < samples.size(); pos += chunk) {
+            int n = qMin(chunk, samples.size() - pos);
+            suppressor.process(samples.constData() + pos, n, output.data() + pos);
+        }
+
+        int maxDifference = 0;
+        for (int i = 0; i < delay; ++i)
+            maxDifference = qMax(maxDifference, qAbs((int)output.at(i)));
+        for (int i = delay; i < samples.size(); ++i)
+            maxDifference = qMax(maxDifference, qAbs(output.at(i) - samples.at(i - delay)));
+
+        bool ok = (suppressor.hasProfile() == (profile != 0)) && (maxDifference <= profile);
+        out << "noise suppression " << (profile ? "with the profile of silence" : "without profile")
+            << ": maximum difference " << maxDifference << (ok ? ": ok" : ": FAILED") << "\n";
+        if (!ok)
+            result = 1;
+    }
+
+    return result;
+}
+
+
+/*!
+  checkGraph schedules detector graphs with shared filter outputs and checks
+  that the filter outputs in use at the same time never share a buffer. Each
+  graph is run on pseudo random audio once sequentially and once on a task
+  pool, their decisions need to be equal. It returns 0 if all graphs pass.
+*/
+static int checkGraph(const Settings &settings, QTextStream &out)
+{
+    // nodes of the graphs as name, type, input and filter cutoff, each graph
+    // ends with an empty name; the detectors get gated by any of them
+    struct Node {
+        const char *name;
+        const char *type;
+        const char *input;
+        int cutoff;
+    };
+    static const Node nodes[] = {
+        // a filter output read by several filters and detectors
+        { "dc", "dcblock", 0, 20 }, { "pitch", "pitch", "dc", 0 },
+        { "dc2", "dcblock", "dc", 200 }, { "dc3", "dcblock", "dc", 300 },
+        { "fa", "dcblock", "dc2", 100 }, { "fb", "dcblock", "dc2", 400 },
+        { "spec", "spectral", "dc2", 0 }, { "sa", "spectral", "fa", 0 },
+        { "sb", "spectral", "fb", 0 }, { 0, 0, 0, 0 },
+        // the same with a detector instead of the unused filter
+        { "dc", "dcblock", 0, 20 }, { "pitch", "pitch", "dc", 0 },
+        { "dc2", "dcblock", "dc", 200 }, { "sd", "spectral", "dc", 0 },
+        { "fa", "dcblock", "dc2", 100 }, { "fb", "dcblock", "dc2", 400 },
+        { "spec", "spectral", "dc2", 0 }, { "sa", "spectral", "fa", 0 },
+        { "sb", "spectral", "fb", 0 }, { 0, 0, 0, 0 },
+        // a chain of filters working in place
+        { "c1", "dcblock", 0, 20 }, { "c2", "dcblock", "c1", 100 },
+        { "c3", "dcblock", "c2", 200 }, { "spec", "spectral", "c3", 0 },
+        { "pitch", "pitch", "c1", 0 }, { 0, 0, 0, 0 },
+        // the stock graph
+        { "clean", "dcblock", 0, 20 }, { "spectral", "spectral", "clean", 0 },
+        { "pitch", "pitch", "clean", 0 }, { 0, 0, 0, 0 }
+    };
+    const int graphs = 4;
+
+    const int rate = settings.AUDIO_ANALYSIS_RATE;
+    const int frames = 10 * rate;
+    const int chunk = rate * settings.AUDIO_SAMPLE_INTERVAL / 1000;
+    QVector<qint16> samples(frames);
+    randomAudio(&samples, rate);
+
+    TaskPool pool(2);
+    int result = 0;
+    const Node *node = nodes;
+    for (int graph = 0; graph < graphs; ++graph, ++node) {
+        DspGraph sequential;
+        DspGraph parallel;
+        DspGraph *both[2] = { &sequential, &parallel };
+        const Node *first = node;
+        for (int g = 0; g < 2; ++g) {
+            both[g]->setup(rate);
+            QStringList gates;
+            for (node = first; node->name; ++node) {
+                QVariantMap parameters;
+                if (node->input)
+                    parameters.insert("input", node->input);
+                if (node->cutoff > 0)
+                    parameters.insert("cutoff", node->cutoff);
+                both[g]->addNode(node->name, node->type, parameters);
+                if (QString(node->type) != "dcblock") {
+                    QVariantMap gate;
+                    gate.insert("input", node->name);
+                    gate.insert("threshold", 10);
+                    gates.append(QString(node->name) + "Gate");
+                    both[g]->addNode(gates.last(), "threshold", gate);
+                }
+            }
+            QVariantMap parameters;
+            parameters.insert("inputs", gates);
+            both[g]->addNode("gate", "any", parameters);
+            both[g]->schedule("gate", QString());
+        }
+        parallel.setPool(&pool);
+
+        int mismatches = 0;
+        for (int pos = 0; pos < frames; pos += chunk) {
+            for (int g = 0; g < 2; ++g) {
+                both[g]->write(samples.constData() + pos, qMin(chunk, frames - pos));
+                both[g]->evaluate();
+            }
+            if (sequential.passes() != parallel.passes())
+                mismatches++;
+        }
+
+        bool distinct = sequential.checkBuffers();
+        out << "graph " << graph << ": " << sequential.levels() << " levels, "
+            << sequential.buffers() << " buffers"
+            << (distinct ? "" : ", SHARED BUFFERS") << ", " << mismatches
+            << " mismatching decisions" << ((distinct && mismatches == 0) ? ": ok" : ": FAILED")
+            << "\n";
+        if ( !distinct || (mismatches > 0) )
+            result = 1;
+    }
+
+    return result;
+}
+
+
+/*!
+  reportLevelStore prints the entry count of each tier of the level series and
+  measures a query of the whole replay at screen resolution.
+*/
+static void reportLevelStore(const LevelStore &store, qint64 duration, QTextStream &out)
+{
+    const int points = 854;
+
+    for (int tier = 0; tier < LevelStore::TIER_COUNT; ++tier)
+        out << "level store tier " << tier << ": "
+            << store.count((LevelStore::Tier)tier) << " entries\n";
+
+    LevelStore::Tier tier = LevelStore::tierFor(0, duration, points);
+    QVector<LevelEntry> result(store.count(tier));
+    QElapsedTimer timer;
+    timer.start();
+    int count = store.query(tier, 0, duration, result.data(), result.size());
+    out << "level store query of " << duration << " ms: tier " << tier << ", "
+        << count << " entries in " << timer.elapsed() << " ms\n";
+}
+
+
+/*!
+  triggerTimes extracts the trigger times of a replay output.
+*/
+static QList<qint64> triggerTimes(const QString &output)
+{
+    QList<qint64> times;
+    foreach (const QString &line, output.split('\n', QString::SkipEmptyParts)) {
+        QStringList fields = line.split(' ');
+        if (fields.at(0) == "trigger")
+            times.append(fields.at(1).toLongLong());
+    }
+    return times;
+}
+
+
+/*!
+  compareTriggers reports the triggers of the sliding window output together
+  with the latency gain against the closest fixed interval trigger. Triggers
+  more than maxDistance milliseconds apart are considered unrelated.
+*/
+static void compareTriggers(const QString &reference, const QString &output,
+                            qint64 maxDistance, QTextStream &out)
+{
+    QList<qint64> referenceTimes = triggerTimes(reference);
+    QList<qint64> times = triggerTimes(output);
+
+    int matched = 0;
+    qint64 gain = 0;
+    foreach (qint64 time, times) {
+        qint64 closest = -1;
+        foreach (qint64 referenceTime, referenceTimes) {
+            if ( (qAbs(referenceTime - time) <= maxDistance) &&
+                 ((closest < 0) || (qAbs(referenceTime - time) < qAbs(closest - time))) )
+                closest = referenceTime;
+        }
+
+        if (closest < 0) {
+            out << "trigger " << time << " only in sliding window\n";
+            continue;
+        }
+        out << "trigger " << time << " fixed interval " << closest
+            << " gain " << closest - time << "\n";
+        matched++;
+        gain += closest - time;
+    }
+
+    out << "fixed interval triggers " << referenceTimes.size()
+        << ", sliding window triggers " << times.size()
+        << ", matched " << matched;
+    if (matched > 0)
+        out << ", mean latency gain " << gain / matched << " ms";
+    out << "\n";
+}
+
+
+/*!
+  compareOutput compares the float and the fixed point replay output line by
+  line. It returns the maximum volume difference, or -1 if the update series
+  got out of step.
+*/
+static int compareOutput(const QString &reference, const QString &output,
+                         int *differences, int *updates)
+{
+    QStringList referenceLines = reference.split('\n', QString::SkipEmptyParts);
+    QStringList outputLines = output.split('\n', QString::SkipEmptyParts);
+    if (referenceLines.size() != outputLines.size())
+        return -1;
+
+    int maxDifference = 0;
+    *differences = 0;
+    *updates = 0;
+    for (int i = 0; i < referenceLines.size(); ++i) {
+        QStringList a = referenceLines.at(i).split(' ');
+        QStringList b = outputLines.at(i).split(' ');
+        if ((a.size() != b.size()) || (a.at(0) != b.at(0)) || (a.at(1) != b.at(1)))
+            return -1;
+        if (a.at(0) != "update")
+            continue;
+
+        (*updates)++;
+        if (a != b) {
+            (*differences)++;
+            maxDifference = qMax(maxDifference, qAbs(a.at(3).toInt() - b.at(3).toInt()));
+        }
+    }
+
+    return maxDifference;
+}
+
+
+/*!
+  The replay tool uses the built-in default settings unless overridden by
+  command line options, such that the output does not depend on the settings
+  of the user.
+*/
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    // never read the user's application settings
+    QString defaults = QDir::tempPath() + "/babyphone-replay-defaults";
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, defaults);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::SystemScope, defaults);
+    Settings settings;
+
+    QAudioFormat format;
+    format.setFrequency(8000);
+    format.setChannels(1);
+    format.setSampleSize(16);
+    format.setSampleType(QAudioFormat::SignedInt);
+    format.setByteOrder(QAudioFormat::LittleEndian);
+    format.setCodec("audio/pcm");
+
+    bool raw = false;
+    bool checkKernels = false;
+    bool checkFixedPoint = false;
+    bool compareWindow = false;
+    bool learnSound = false;
+    int detectorThreads = 0;
+    QString ignoredSoundsFile;
+    QString clipDirectory;
+    QString levelStoreFile;
+    VolumeScale::Type volumeScale = VolumeScale::defaultType();
+    int callDuration = -1;
+    LevelKernel::Type kernel = LevelKernel::best(settings.AUDIO_SAMPLE_SUBINTERVAL);
+    QString fileName;
+
+    // parse command line
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        const QString &arg = args.at(i);
+        bool hasValue = (i+1 < args.size());
+
+        if (arg == "--raw")
+            raw = true;
+        else if (arg == "--check-kernels")
+            checkKernels = true;
+        else if (arg == "--check-fixed-point")
+            checkFixedPoint = true;
+        else if (arg == "--compare-window")
+            compareWindow = true;
+        else if ((arg == "--window") && hasValue)
+            settings.itsAudioWindow = args.at(++i).toInt();
+        else if ((arg == "--hop") && hasValue)
+            settings.itsAudioHop = args.at(++i).toInt();
+        else if ((arg == "--clips") && hasValue)
+            clipDirectory = args.at(++i);
+        else if ((arg == "--history") && hasValue)
+            settings.itsHistoryDuration = args.at(++i).toInt();
+        else if ((arg == "--level-store") && hasValue)
+            levelStoreFile = args.at(++i);
+        else if ((arg == "--spectral") && hasValue)
+            settings.itsSpectralThreshold = args.at(++i).toInt();
+        else if ((arg == "--pitch") && hasValue)
+            settings.itsPitchThreshold = args.at(++i).toInt();
+        else if ((arg == "--classifier") && hasValue)
+            settings.itsClassifierFile = args.at(++i);
+        else if ((arg == "--classifier-threshold") && hasValue)
+            settings.itsClassifierThreshold = args.at(++i).toInt();
+        else if ((arg == "--pipeline") && hasValue)
+            settings.itsPipelineFile = args.at(++i);
+        else if ((arg == "--cascade-window") && hasValue)
+            settings.itsCascadeWindow = args.at(++i).toInt();
+        else if ((arg == "--cascade-level") && hasValue)
+            settings.itsCascadeLevel = args.at(++i).toInt();
+        else if (arg == "--dc-block")
+            settings.itsFilterDcBlock = true;
+        else if ((arg == "--high-pass") && hasValue)
+            settings.itsFilterHighPass = args.at(++i).toInt();
+        else if (arg == "--a-weighting")
+            settings.itsFilterAWeighting = true;
+        else if ((arg == "--noise-suppression") && hasValue)
+            settings.itsNoiseSuppression = args.at(++i).toInt();
+        else if ((arg == "--ensemble") && hasValue)
+            settings.itsEnsembleRule = args.at(++i);
+        else if ((arg == "--detector-threads") && hasValue)
+            detectorThreads = args.at(++i).toInt();
+        else if ((arg == "--ignore-sounds") && hasValue)
+            ignoredSoundsFile = args.at(++i);
+        else if (arg == "--learn-sound")
+            learnSound = true;
+        else if ((arg == "--tones") && hasValue) {
+            settings.itsToneFrequencies.clear();
+            foreach (const QString &frequency, args.at(++i).split(','))
+                settings.itsToneFrequencies.append(frequency.toInt());
+        }
+        else if (arg == "--check-graph")
+            return checkGraph(settings, out);
+        else if (arg == "--check-fft")
+            return checkFft(out);
+        else if (arg == "--check-biquad")
+            return checkBiquad(settings, out);
+        else if (arg == "--check-suppressor")
+            return checkSuppressor(settings, out);
+        else if (arg == "--benchmark-volume") {
+            benchmarkVolume(settings, out);
+            return 0;
+        }
+        else if (arg == "--benchmark-spectral") {
+            benchmarkSpectral(settings, out);
+            return 0;
+        }
+        else if ((arg == "--rate") && hasValue)
+            format.setFrequency(args.at(++i).toInt());
+        else if ((arg == "--channels") && hasValue)
+            format.setChannels(args.at(++i).toInt());
+        else if ((arg == "--volume") && hasValue)
+            settings.itsAudioAmplify = args.at(++i).toInt();
+        else if ((arg == "--duration") && hasValue)
+            settings.itsDurationInfluence = args.at(++i).toInt();
+        else if ((arg == "--activation-delay") && hasValue)
+            settings.itsActivationDelay = args.at(++i).toInt();
+        else if ((arg == "--recall-timeout") && hasValue)
+            settings.itsRecallTimer = args.at(++i).toInt();
+        else if ((arg == "--call-duration") && hasValue)
+            callDuration = args.at(++i).toInt()*1000;
+        else if ((arg == "--kernel") && hasValue) {
+            QString name = args.at(++i);
+            int type;
+            for (type = 0; type < LevelKernel::TYPE_COUNT; ++type)
+                if (name == LevelKernel::name((LevelKernel::Type)type))
+                    break;
+            if (type == LevelKernel::TYPE_COUNT) {
+                err << "unknown kernel " << name << "\n";
+                return 2;
+            }
+            kernel = (LevelKernel::Type)type;
+        }
+        else if ((arg == "--volume-scale") && hasValue) {
+            QString name = args.at(++i);
+            int type;
+            for (type = 0; type < VolumeScale::TYPE_COUNT; ++type)
+                if (name == VolumeScale::name((VolumeScale::Type)type))
+                    break;
+            if (type == VolumeScale::TYPE_COUNT) {
+                err << "unknown volume computation " << name << "\n";
+                return 2;
+            }
+            volumeScale = (VolumeScale::Type)type;
+        }
+        else if (!arg.startsWith("--") && fileName.isEmpty())
+            fileName = arg;
+        else {
+            usage(err);
+            return 2;
+        }
+    }
+    if ( fileName.isEmpty() || (learnSound && ignoredSoundsFile.isEmpty()) ) {
+        usage(err);
+        return 2;
+    }
+
+    // the audio history is only kept if the clips are saved, the replay
+    // saves them itself without the disk quota of the event recorder
+    if (clipDirectory.isEmpty())
+        settings.itsHistoryDuration = 0;
+    else if (!QDir().mkpath(clipDirectory)) {
+        err << clipDirectory << ": cannot create directory\n";
+        return 1;
+    }
+    else
+        settings.itsClipQuota = qMax(settings.itsClipQuota, 1);
+
+    // open recording
+    WavFile file;
+    bool opened = raw ? file.openRaw(fileName, format) : file.open(fileName);
+    if (!opened) {
+        err << fileName << ": " << file.errorString() << "\n";
+        return 1;
+    }
+
+    // the block size of the level kernels scales with lower sample rates,
+    // higher ones get decimated
+    FormatKernel formatKernel;
+    if (!formatKernel.setup(file.format(), LevelKernel::TYPE_SCALAR)) {
+        err << fileName << ": unsupported audio format\n";
+        return 1;
+    }
+    int rate = qMin(file.format().frequency(), settings.AUDIO_ANALYSIS_RATE);
+    int blockSize = qMax(1, settings.AUDIO_SAMPLE_SUBINTERVAL * rate / settings.AUDIO_ANALYSIS_RATE);
+
+    TaskPool pool(detectorThreads);
+    ReplaySession session(&settings);
+    session.setClipDirectory(clipDirectory);
+    session.setTaskPool(&pool);
+    if (callDuration >= 0)
+        session.setCallDuration(callDuration);
+
+    // a missing file of ignored sounds is created by learning a sound
+    FingerprintIndex ignoredSounds(settings.AUDIO_ANALYSIS_RATE);
+    if (!ignoredSoundsFile.isEmpty()) {
+        if (!ignoredSounds.load(ignoredSoundsFile)) {
+            err << ignoredSoundsFile << ": cannot load ignored sounds\n";
+            return 1;
+        }
+        session.setFingerprintIndex(&ignoredSounds);
+    }
+
+    // compare all kernels against the scalar reference
+    if (checkKernels) {
+        QString reference;
+        QTextStream referenceOut(&reference);
+        session.setKernel(LevelKernel::TYPE_SCALAR);
+        session.run(&file, &referenceOut);
+        referenceOut.flush();
+
+        int result = 0;
+        for (int type = LevelKernel::TYPE_SCALAR+1; type < LevelKernel::TYPE_COUNT; ++type) {
+            if (!LevelKernel::isAvailable((LevelKernel::Type)type, blockSize))
+                continue;
+
+            QString output;
+            QTextStream kernelOut(&output);
+            file.rewind();
+            session.setKernel((LevelKernel::Type)type);
+            session.run(&file, &kernelOut);
+            kernelOut.flush();
+
+            bool equal = (output == reference);
+            err << "kernel " << LevelKernel::name((LevelKernel::Type)type)
+                << (equal ? ": ok" : ": MISMATCH") << "\n";
+            if (!equal)
+                result = 1;
+        }
+        return result;
+    }
+
+    // compare the fixed point against the float volume computation, a volume
+    // difference of 1 is tolerated
+    if (checkFixedPoint) {
+        QString reference;
+        QTextStream referenceOut(&reference);
+        session.setKernel(kernel);
+        session.setVolumeScale(VolumeScale::TYPE_FLOAT);
+        session.run(&file, &referenceOut);
+        referenceOut.flush();
+
+        QString output;
+        QTextStream fixedOut(&output);
+        file.rewind();
+        session.setVolumeScale(VolumeScale::TYPE_FIXED);
+        session.run(&file, &fixedOut);
+        fixedOut.flush();
+
+        int differences;
+        int updates;
+        int maxDifference = compareOutput(reference, output, &differences, &updates);
+        if (maxDifference < 0) {
+            err << "fixed point: MISMATCH, update or trigger series differs\n";
+            return 1;
+        }
+        err << "fixed point: " << differences << " of " << updates
+            << " updates differ, maximum volume difference " << maxDifference
+            << (maxDifference <= 1 ? ": ok" : ": MISMATCH") << "\n";
+        return (maxDifference <= 1) ? 0 : 1;
+    }
+
+    // compare the trigger times of the sliding window against the fixed
+    // intervals, by default with a window of one interval
+    if (compareWindow) {
+        session.setKernel(kernel);
+        session.setVolumeScale(volumeScale);
+
+        int window = settings.itsAudioWindow;
+        if (window <= 0)
+            window = settings.AUDIO_SAMPLE_INTERVAL;
+
+        QString reference;
+        QTextStream referenceOut(&reference);
+        settings.itsAudioWindow = 0;
+        session.run(&file, &referenceOut);
+        referenceOut.flush();
+
+        QString output;
+        QTextStream windowOut(&output);
+        file.rewind();
+        settings.itsAudioWindow = window;
+        session.run(&file, &windowOut);
+        windowOut.flush();
+
+        compareTriggers(reference, output, settings.itsRecallTimer*1000 / 2, out);
+        return 0;
+    }
+
+    // replay recording
+    LevelStore levelStore;
+    if (!levelStoreFile.isEmpty()) {
+        if (!levelStore.open(levelStoreFile)) {
+            err << levelStoreFile << ": cannot open level store\n";
+            return 1;
+        }
+        session.setLevelStore(&levelStore);
+    }
+
+    session.setKernel(kernel);
+    session.setVolumeScale(volumeScale);
+    QElapsedTimer timer;
+    timer.start();
+    qint64 frames = session.run(&file, &out);
+    out.flush();
+    qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+
+    err << "processed " << frames << " frames ("
+        << frames / file.format().frequency() << " s of audio) in "
+        << elapsed << " ms: " << frames * 1000 / elapsed << " samples/s\n";
+    if (settings.itsCascadeWindow > 0)
+        err << "detector duty cycle: " << session.dutyCycle() / 10.0 << "%\n";
+    if (!session.detectorStatistics().isEmpty())
+        err << session.detectorStatistics() << "\n";
+    if (!ignoredSoundsFile.isEmpty())
+        err << "ignored decisions: " << session.ignoredDecisions() << "\n";
+
+    if (learnSound) {
+        int sound = ignoredSounds.addSound(session.fingerprint());
+        if ( (sound < 0) || !ignoredSounds.save(ignoredSoundsFile) ) {
+            err << ignoredSoundsFile << ": cannot add the sound\n";
+            return 1;
+        }
+        err << "ignoring sound " << sound << " of " << ignoredSounds.sounds() << "\n";
+    }
+
+    if (levelStore.isOpen())
+        reportLevelStore(levelStore, frames * 1000 / file.format().frequency(), err);
+
+    return 0;
+}
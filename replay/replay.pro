@@ -0,0 +1,49 @@
+# babyphone - A baby monitor application for Maemo/MeeGo (Nokia N900, N950, N9).
+#     Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+#
+#     This program is free software: you can redistribute it and/or modify
+#     it under the terms of the GNU General Public License as published by
+#     the Free Software Foundation, either version 3 of the License, or
+#     (at your option) any later version.
+#
+#     This program is distributed in the hope that it will be useful,
+#     but WITHOUT ANY WARRANTY; without even the implied warranty of
+#     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#     GNU General Public License for more details.
+#
+#     You should have received a copy of the GNU General Public License
+#     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Offline replay tool. It runs recordings through the audio detection of
+# babyphone and is built by "make babyphone-replay" of the main project.
+
+TARGET = babyphone-replay
+TEMPLATE = app
+
+QT       += core
+QT       -= gui
+CONFIG   += console
+CONFIG   -= app_bundle
+
+CONFIG   += mobility
+
+# the audio support is either located in Qt directly or in QtMobility
+maemo5 {
+  QT       += multimedia
+}
+else {
+  MOBILITY += multimedia
+}
+
+# the audio analysis core
+include(../babyphone-core.pri)
+
+
+SOURCES += \
+    main.cpp \
+    wavfile.cpp \
+    replaysession.cpp
+
+HEADERS += \
+    wavfile.h \
+    replaysession.h
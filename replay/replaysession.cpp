@@ -0,0 +1,237 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "replaysession.h"
+
+#include <QDir>
+
+
+/*!
+  The constructor sets up the replay with the given application settings.
+*/
+ReplaySession::ReplaySession(const Settings *settings, QObject *parent)
+    : QObject(parent), itsSettings(settings), itsAudioTrigger(settings),
+      itsKernel(LevelKernel::best(settings->AUDIO_SAMPLE_SUBINTERVAL)),
+      itsVolumeScale(VolumeScale::defaultType()),
+      itsCallDuration(settings->itsCallSetupTimer*1000),
+      itsLevelStore(0), itsTaskPool(0), itsFingerprintIndex(0), itsAudioMonitor(0),
+      itsOut(0), itsTime(0), itsActiveTime(0), itsResumeTime(0), itsDutyCycle(0),
+      itsIgnoredDecisions(0)
+{
+}
+
+
+/*!
+  setKernel selects the level analysis kernel of the audio monitor.
+*/
+void ReplaySession::setKernel(LevelKernel::Type kernel)
+{
+    itsKernel = kernel;
+}
+
+
+/*!
+  setVolumeScale selects the float or fixed point volume computation of the
+  audio monitor.
+*/
+void ReplaySession::setVolumeScale(VolumeScale::Type type)
+{
+    itsVolumeScale = type;
+}
+
+
+/*!
+  setCallDuration sets the assumed duration of notification calls in
+  milliseconds.
+*/
+void ReplaySession::setCallDuration(int duration)
+{
+    itsCallDuration = duration;
+}
+
+
+/*!
+  setClipDirectory sets the directory to which the audio history is saved on
+  each trigger, as done by the application. The audio history needs to be
+  enabled by the settings.
+*/
+void ReplaySession::setClipDirectory(const QString &directory)
+{
+    itsClipDirectory = directory;
+}
+
+
+/*!
+  setLevelStore sets the level series to which the updates are appended, using
+  the virtual clock as milliseconds since the epoch.
+*/
+void ReplaySession::setLevelStore(LevelStore *store)
+{
+    itsLevelStore = store;
+}
+
+
+/*!
+  setTaskPool sets the pool on which the detectors of the audio monitor run in
+  parallel.
+*/
+void ReplaySession::setTaskPool(TaskPool *pool)
+{
+    itsTaskPool = pool;
+}
+
+
+/*!
+  setFingerprintIndex sets the sounds the audio monitor ignores, as the
+  application does for the sounds marked by the user.
+*/
+void ReplaySession::setFingerprintIndex(const FingerprintIndex *index)
+{
+    itsFingerprintIndex = index;
+}
+
+
+/*!
+  run replays the whole audio file and writes the results to the given stream.
+  The file is processed in chunks of AUDIO_SAMPLE_INTERVAL, as delivered by the
+  audio device. It returns the number of processed audio frames.
+*/
+qint64 ReplaySession::run(WavFile *file, QTextStream *out)
+{
+    const QAudioFormat &format = file->format();
+    int frameSize = format.channels() * format.sampleSize() / 8;
+    qint64 chunkFrames = (qint64)format.frequency() * itsSettings->AUDIO_SAMPLE_INTERVAL / 1000;
+    QByteArray buffer(chunkFrames * frameSize, 0);
+
+    // setup a fresh monitor and state
+    AudioMonitor monitor(itsSettings, format, this);
+    monitor.setKernel(itsKernel);
+    monitor.setVolumeScale(itsVolumeScale);
+    monitor.setTaskPool(itsTaskPool);
+    monitor.setFingerprintIndex(itsFingerprintIndex);
+    connect(&monitor, SIGNAL(update(int, int, int, int)),
+            this, SLOT(refreshAudioData(int, int, int, int)));
+    monitor.start();
+    // the background noise is learned during the activation delay
+    monitor.learnNoise(itsSettings->itsActivationDelay);
+
+    itsAudioMonitor = &monitor;
+    itsOut = out;
+    itsTime = 0;
+    itsActiveTime = itsSettings->itsActivationDelay*1000;
+    itsResumeTime = 0;
+
+    qint64 frames = 0;
+    qint64 len;
+    while ((len = file->read(buffer.data(), buffer.size())) > 0) {
+        frames += len / frameSize;
+        itsTime = frames * 1000 / format.frequency();
+
+        // audio capturing is stopped during notifications
+        if (itsTime <= itsResumeTime)
+            continue;
+
+        monitor.write(buffer.constData(), len);
+    }
+
+    itsDutyCycle = monitor.dutyCycle();
+    itsDetectorStatistics = monitor.detectorStatistics();
+    itsIgnoredDecisions = monitor.ignoredDecisions();
+    itsFingerprint = monitor.fingerprint();
+    itsAudioMonitor = 0;
+    itsOut = 0;
+
+    return frames;
+}
+
+
+/*!
+  dutyCycle returns the share of the audio of the last run analysed by the
+  detectors and the classifier, in per mille.
+*/
+int ReplaySession::dutyCycle() const
+{
+    return itsDutyCycle;
+}
+
+
+/*!
+  detectorStatistics returns the processing time of the detectors and their
+  agreement with the decisions of the last run, empty without detectors.
+*/
+QString ReplaySession::detectorStatistics() const
+{
+    return itsDetectorStatistics;
+}
+
+
+/*!
+  ignoredDecisions returns the number of loud decisions of the last run which
+  did not count, as the audio was recognized as a sound to be ignored.
+*/
+int ReplaySession::ignoredDecisions() const
+{
+    return itsIgnoredDecisions;
+}
+
+
+/*!
+  fingerprint returns the landmarks of the last RECENT_DURATION seconds of the
+  last run, empty without index of ignored sounds.
+*/
+QVector<Landmark> ReplaySession::fingerprint() const
+{
+    return itsFingerprint;
+}
+
+
+/*!
+  refreshAudioData receives the audio samples from the AudioMonitor and
+  performs the threshold check as done by Babyphone::refreshAudioData. The cry
+  probability is only written with a classifier, such that the output of the
+  other settings stays unchanged.
+*/
+void ReplaySession::refreshAudioData(int counter, int value, int floor, int probability)
+{
+    *itsOut << "update " << itsTime << " " << counter << " " << value << " "
+            << floor;
+    if (probability >= 0)
+        *itsOut << " " << probability;
+    *itsOut << "\n";
+    if (itsLevelStore)
+        itsLevelStore->append(itsTime, counter, value);
+
+    // check for noise
+    if ( (itsTime >= itsActiveTime) &&
+         (itsAudioTrigger.isTriggered(counter)) )
+    {
+        *itsOut << "trigger " << itsTime << "\n";
+
+        // keep the audio that led to the trigger
+        if (!itsClipDirectory.isEmpty())
+            itsAudioMonitor->saveHistory(QDir(itsClipDirectory).filePath(
+                    QString("trigger-%1.wav").arg(itsTime)));
+
+        // reset audio monitor warning
+        itsAudioMonitor->resetCounter();
+
+        // audio stays off until the phone application finished, the recall
+        // timer starts as the call is finished
+        itsResumeTime = itsTime + itsCallDuration + itsSettings->REFOCUS_TIMER;
+        itsActiveTime = itsTime + itsCallDuration + itsSettings->itsRecallTimer*1000;
+    }
+}
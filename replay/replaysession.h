@@ -0,0 +1,123 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef REPLAYSESSION_H
+#define REPLAYSESSION_H
+
+#include <QObject>
+#include <QTextStream>
+
+#include "settings.h"
+#include "audiomonitor.h"
+#include "audiotrigger.h"
+#include "levelstore.h"
+#include "wavfile.h"
+
+
+/*!
+  ReplaySession pushes a recording through AudioMonitor and the AudioTrigger
+  check of Babyphone. Instead of the wall clock it uses a virtual clock derived
+  from the number of processed audio frames, such that a whole night is
+  replayed as fast as the CPU allows.
+
+  The notification handling of Babyphone is emulated: after a trigger the audio
+  data of the assumed call duration is skipped and the recall timeout has to
+  pass before the next trigger can occur.
+
+  Each audio update and each trigger is written as one line to the output
+  stream. This output only depends on the recording and the settings and can
+  be compared to saved golden files.
+*/
+class ReplaySession : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReplaySession(const Settings *settings, QObject *parent = 0);
+
+    void setKernel(LevelKernel::Type kernel);
+    void setVolumeScale(VolumeScale::Type type);
+    void setCallDuration(int duration);
+    void setClipDirectory(const QString &directory);
+    void setLevelStore(LevelStore *store);
+    void setTaskPool(TaskPool *pool);
+    void setFingerprintIndex(const FingerprintIndex *index);
+
+    qint64 run(WavFile *file, QTextStream *out);
+    int dutyCycle() const;
+    QString detectorStatistics() const;
+    int ignoredDecisions() const;
+    QVector<Landmark> fingerprint() const;
+
+private slots:
+    void refreshAudioData(int counter, int value, int floor, int probability);
+
+private:
+    //! reference to global application settings
+    const Settings * const itsSettings;
+
+    //! the threshold check of the audio counter
+    AudioTrigger itsAudioTrigger;
+
+    //! the level analysis kernel to use
+    LevelKernel::Type itsKernel;
+    //! the volume computation to use
+    VolumeScale::Type itsVolumeScale;
+
+    //! assumed duration of a notification call in milliseconds
+    int itsCallDuration;
+
+    //! directory for the audio history clips of the triggers, none if empty
+    QString itsClipDirectory;
+
+    //! the level series receiving the updates, if any
+    LevelStore *itsLevelStore;
+
+    //! the pool running the detectors in parallel, if any
+    TaskPool *itsTaskPool;
+
+    //! the sounds to be ignored, if any
+    const FingerprintIndex *itsFingerprintIndex;
+
+    //! the audio monitor of the current run
+    AudioMonitor *itsAudioMonitor;
+
+    //! output stream of the current run
+    QTextStream *itsOut;
+
+    //! virtual clock in milliseconds
+    qint64 itsTime;
+
+    //! virtual time at which the monitor gets active
+    qint64 itsActiveTime;
+
+    //! virtual time at which audio capturing resumes after a notification
+    qint64 itsResumeTime;
+
+    //! detector duty cycle of the last run in per mille
+    int itsDutyCycle;
+
+    //! detector latency and agreement of the last run
+    QString itsDetectorStatistics;
+
+    //! loud decisions of the last run ignored as known sounds
+    int itsIgnoredDecisions;
+
+    //! landmarks of the end of the last run
+    QVector<Landmark> itsFingerprint;
+};
+
+#endif // REPLAYSESSION_H
@@ -0,0 +1,193 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "wavfile.h"
+
+#include <string.h>
+
+#include <QtEndian>
+
+
+// WAVE format tags
+#define WAVE_FORMAT_PCM         0x0001
+#define WAVE_FORMAT_FLOAT       0x0003
+#define WAVE_FORMAT_EXTENSIBLE  0xFFFE
+
+
+/*!
+  The constructor sets up an empty file.
+*/
+WavFile::WavFile()
+    : itsDataStart(0), itsDataSize(0), itsDataRead(0)
+{
+}
+
+
+/*!
+  open opens a RIFF WAVE file and determines its audio format from the file
+  header. It returns false if the file cannot be read or is no PCM WAVE file.
+*/
+bool WavFile::open(const QString &fileName)
+{
+    itsFile.setFileName(fileName);
+    if (!itsFile.open(QIODevice::ReadOnly)) {
+        itsError = itsFile.errorString();
+        return false;
+    }
+
+    return parseHeader();
+}
+
+
+/*!
+  openRaw opens a headerless audio file of the given format.
+*/
+bool WavFile::openRaw(const QString &fileName, const QAudioFormat &format)
+{
+    itsFile.setFileName(fileName);
+    if (!itsFile.open(QIODevice::ReadOnly)) {
+        itsError = itsFile.errorString();
+        return false;
+    }
+
+    itsFormat = format;
+    itsDataStart = 0;
+    itsDataSize = itsFile.size();
+    itsDataRead = 0;
+    return true;
+}
+
+
+/*!
+  rewind restarts reading at the first audio sample.
+*/
+bool WavFile::rewind()
+{
+    itsDataRead = 0;
+    return itsFile.seek(itsDataStart);
+}
+
+
+/*!
+  read reads up to maxlen bytes of audio data. It returns the number of bytes
+  read, 0 at the end of the audio data and -1 on errors.
+*/
+qint64 WavFile::read(char *data, qint64 maxlen)
+{
+    qint64 len = qMin(maxlen, itsDataSize - itsDataRead);
+    if (len <= 0)
+        return 0;
+
+    len = itsFile.read(data, len);
+    if (len > 0)
+        itsDataRead += len;
+    return len;
+}
+
+
+/*!
+  format returns the audio format of the file content.
+*/
+const QAudioFormat &WavFile::format() const
+{
+    return itsFormat;
+}
+
+
+/*!
+  errorString returns a description of the last error.
+*/
+QString WavFile::errorString() const
+{
+    return itsError;
+}
+
+
+/*!
+  parseHeader walks through the RIFF chunks up to the data chunk. The format
+  chunk determines the audio format.
+*/
+bool WavFile::parseHeader()
+{
+    uchar riff[12];
+    if ( (itsFile.read((char*)riff, sizeof(riff)) != sizeof(riff)) ||
+         (memcmp(riff, "RIFF", 4) != 0) ||
+         (memcmp(riff+8, "WAVE", 4) != 0) ) {
+        itsError = "no RIFF WAVE file";
+        return false;
+    }
+
+    bool formatFound = false;
+    uchar chunk[8];
+    while (itsFile.read((char*)chunk, sizeof(chunk)) == sizeof(chunk)) {
+        quint32 size = qFromLittleEndian<quint32>(chunk+4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            // chunks are padded to even size
+            QByteArray fmt = itsFile.read(size + (size & 1));
+            if (fmt.size() < 16) {
+                itsError = "truncated format chunk";
+                return false;
+            }
+            const uchar *data = (const uchar*)fmt.constData();
+            quint16 tag = qFromLittleEndian<quint16>(data);
+            quint16 bits = qFromLittleEndian<quint16>(data+14);
+
+            // the extensible format stores the actual tag in the sub format
+            if ((tag == WAVE_FORMAT_EXTENSIBLE) && (fmt.size() >= 26))
+                tag = qFromLittleEndian<quint16>(data+24);
+
+            itsFormat.setChannels(qFromLittleEndian<quint16>(data+2));
+            itsFormat.setFrequency(qFromLittleEndian<quint32>(data+4));
+            itsFormat.setSampleSize(bits);
+            itsFormat.setByteOrder(QAudioFormat::LittleEndian);
+            itsFormat.setCodec("audio/pcm");
+
+            if (tag == WAVE_FORMAT_FLOAT)
+                itsFormat.setSampleType(QAudioFormat::Float);
+            else if (tag != WAVE_FORMAT_PCM) {
+                itsError = QString("unsupported WAVE format %1").arg(tag);
+                return false;
+            }
+            else if (bits == 8)
+                itsFormat.setSampleType(QAudioFormat::UnSignedInt);
+            else
+                itsFormat.setSampleType(QAudioFormat::SignedInt);
+
+            formatFound = true;
+        }
+        else if (memcmp(chunk, "data", 4) == 0) {
+            if (!formatFound) {
+                itsError = "data chunk before format chunk";
+                return false;
+            }
+
+            itsDataStart = itsFile.pos();
+            itsDataSize = qMin<qint64>(size, itsFile.size() - itsDataStart);
+            itsDataRead = 0;
+            return true;
+        }
+        else {
+            // skip unknown chunk
+            if (!itsFile.seek(itsFile.pos() + size + (size & 1)))
+                break;
+        }
+    }
+
+    itsError = "no data chunk found";
+    return false;
+}
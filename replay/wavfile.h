@@ -0,0 +1,62 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <QFile>
+#include <QAudioFormat>
+
+
+/*!
+  WavFile provides the audio data of a recording for the offline replay. It
+  reads RIFF WAVE files with PCM content as well as headerless raw files, for
+  which the audio format has to be given by the caller.
+*/
+class WavFile
+{
+public:
+    WavFile();
+
+    bool open(const QString &fileName);
+    bool openRaw(const QString &fileName, const QAudioFormat &format);
+    bool rewind();
+
+    qint64 read(char *data, qint64 maxlen);
+
+    const QAudioFormat &format() const;
+    QString errorString() const;
+
+private:
+    bool parseHeader();
+
+private:
+    //! the audio file
+    QFile itsFile;
+    //! audio format of the file content
+    QAudioFormat itsFormat;
+    //! file offset of the first audio sample
+    qint64 itsDataStart;
+    //! number of audio bytes in the file
+    qint64 itsDataSize;
+    //! number of audio bytes already read
+    qint64 itsDataRead;
+    //! description of the last error
+    QString itsError;
+};
+
+#endif // WAVFILE_H
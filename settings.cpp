@@ -17,6 +17,9 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
 */
 #include "settings.h"
 
+#include <QDir>
+#include <QFileInfo>
+
 
 // settings keys and default values
 #define COMPANY                         "morawek.at"
@@ -31,6 +34,44 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
 #define AUDIO_AMPLIFY_DEFAULT           16
 #define AUDIO_TIMER_KEY                 "audio/timer"
 #define AUDIO_TIMER_DEFAULT             10
+#define AUDIO_DEVICES_KEY               "audio/devices"
+#define AUDIO_WINDOW_KEY                "audio/window"
+#define AUDIO_WINDOW_DEFAULT            0
+#define AUDIO_HOP_KEY                   "audio/hop"
+#define AUDIO_HOP_DEFAULT               100
+#define AUDIO_HISTORY_KEY               "audio/history"
+#define AUDIO_HISTORY_DEFAULT           60
+#define CLIP_DIRECTORY_KEY              "audio/clipDirectory"
+#define CLIP_QUOTA_KEY                  "audio/clipQuota"
+#define CLIP_QUOTA_DEFAULT              0
+#define LEVEL_STORE_KEY                 "audio/levelStore"
+#define LEVEL_STORE_DEFAULT             ""
+#define SPECTRAL_THRESHOLD_KEY          "audio/spectralThreshold"
+#define SPECTRAL_THRESHOLD_DEFAULT      0
+#define TONE_FREQUENCIES_KEY            "audio/toneFrequencies"
+#define PITCH_THRESHOLD_KEY             "audio/pitchThreshold"
+#define PITCH_THRESHOLD_DEFAULT         0
+#define CLASSIFIER_FILE_KEY             "audio/classifier"
+#define CLASSIFIER_FILE_DEFAULT         ""
+#define CLASSIFIER_THRESHOLD_KEY        "audio/classifierThreshold"
+#define CLASSIFIER_THRESHOLD_DEFAULT    0
+#define PIPELINE_FILE_KEY               "audio/pipeline"
+#define PIPELINE_FILE_DEFAULT           ""
+#define ENSEMBLE_RULE_KEY               "audio/ensembleRule"
+#define ENSEMBLE_RULE_DEFAULT           "all"
+#define CASCADE_WINDOW_KEY              "audio/cascadeWindow"
+#define CASCADE_WINDOW_DEFAULT          0
+#define CASCADE_LEVEL_KEY               "audio/cascadeLevel"
+#define CASCADE_LEVEL_DEFAULT           50
+#define FILTER_DC_BLOCK_KEY             "audio/filterDcBlock"
+#define FILTER_DC_BLOCK_DEFAULT         false
+#define FILTER_HIGH_PASS_KEY            "audio/filterHighPass"
+#define FILTER_HIGH_PASS_DEFAULT        0
+#define FILTER_A_WEIGHTING_KEY          "audio/filterAWeighting"
+#define FILTER_A_WEIGHTING_DEFAULT      false
+#define NOISE_SUPPRESSION_KEY           "audio/noiseSuppression"
+#define NOISE_SUPPRESSION_DEFAULT       0
+#define IGNORED_SOUNDS_KEY              "audio/ignoredSounds"
 #define CALL_SETUP_TIMER_KEY            "call/setupTimer"
 #define CALL_SETUP_TIMER_DEFAULT        30
 #define ACTIVATION_DELAY_KEY            "application/activationDelay"
@@ -68,10 +109,37 @@ Settings::Settings(QObject *parent) :
     REFOCUS_TIMER(2000),        // 2s after the call is finished
     AUDIO_SAMPLE_INTERVAL(800),
     AUDIO_SAMPLE_SUBINTERVAL(16),
+    AUDIO_ANALYSIS_RATE(8000),  // higher device rates get decimated
+    NOISE_FLOOR_PERCENTILE(20),
+    NOISE_FLOOR_TIME_CONSTANT(300),
+    NOISE_FLOOR_MARGIN(16),     // about 9 dB at default amplification
     AUDIO_RETRY_TIMER(5000)
 {
     itsAudioAmplify = value(AUDIO_AMPLIFY_KEY, AUDIO_AMPLIFY_DEFAULT).toInt();
     itsDurationInfluence = value(AUDIO_TIMER_KEY, AUDIO_TIMER_DEFAULT).toInt();
+    itsAudioDevices = value(AUDIO_DEVICES_KEY).toStringList();
+    itsAudioWindow = value(AUDIO_WINDOW_KEY, AUDIO_WINDOW_DEFAULT).toInt();
+    itsAudioHop = value(AUDIO_HOP_KEY, AUDIO_HOP_DEFAULT).toInt();
+    itsHistoryDuration = value(AUDIO_HISTORY_KEY, AUDIO_HISTORY_DEFAULT).toInt();
+    itsClipDirectory = value(CLIP_DIRECTORY_KEY, QDir::homePath() + "/MyDocs/babyphone").toString();
+    itsClipQuota = value(CLIP_QUOTA_KEY, CLIP_QUOTA_DEFAULT).toInt();
+    itsLevelStoreFile = value(LEVEL_STORE_KEY, LEVEL_STORE_DEFAULT).toString();
+    itsSpectralThreshold = value(SPECTRAL_THRESHOLD_KEY, SPECTRAL_THRESHOLD_DEFAULT).toInt();
+    foreach (const QString &frequency, value(TONE_FREQUENCIES_KEY).toStringList())
+        itsToneFrequencies.append(frequency.toInt());
+    itsPitchThreshold = value(PITCH_THRESHOLD_KEY, PITCH_THRESHOLD_DEFAULT).toInt();
+    itsClassifierFile = value(CLASSIFIER_FILE_KEY, CLASSIFIER_FILE_DEFAULT).toString();
+    itsClassifierThreshold = value(CLASSIFIER_THRESHOLD_KEY, CLASSIFIER_THRESHOLD_DEFAULT).toInt();
+    itsPipelineFile = value(PIPELINE_FILE_KEY, PIPELINE_FILE_DEFAULT).toString();
+    itsEnsembleRule = value(ENSEMBLE_RULE_KEY, ENSEMBLE_RULE_DEFAULT).toString();
+    itsCascadeWindow = value(CASCADE_WINDOW_KEY, CASCADE_WINDOW_DEFAULT).toInt();
+    itsCascadeLevel = value(CASCADE_LEVEL_KEY, CASCADE_LEVEL_DEFAULT).toInt();
+    itsFilterDcBlock = value(FILTER_DC_BLOCK_KEY, FILTER_DC_BLOCK_DEFAULT).toBool();
+    itsFilterHighPass = value(FILTER_HIGH_PASS_KEY, FILTER_HIGH_PASS_DEFAULT).toInt();
+    itsFilterAWeighting = value(FILTER_A_WEIGHTING_KEY, FILTER_A_WEIGHTING_DEFAULT).toBool();
+    itsNoiseSuppression = value(NOISE_SUPPRESSION_KEY, NOISE_SUPPRESSION_DEFAULT).toInt();
+    // the ignored sounds are kept beside the settings
+    itsIgnoredSoundsFile = value(IGNORED_SOUNDS_KEY, QFileInfo(fileName()).dir().filePath(PRODUCT "-ignored-sounds")).toString();
     itsContact.itsPhoneNumber = value(CONTACT_PHONENUMBER_KEY, CONTACT_PHONENUMBER_DEFAULT).toString();
     itsContact.itsName = value(CONTACT_NAME_KEY, CONTACT_NAME_DEFAULT).toString();
     itsUserNotifyScript = value(USER_NOTIFY_SCRIPT_KEY, USER_NOTIFY_SCRIPT_DEFAULT).toString();
@@ -96,6 +164,30 @@ void Settings::Save()
     setValue(FIRST_RUN_KEY, false);
     setValue(AUDIO_AMPLIFY_KEY, itsAudioAmplify);
     setValue(AUDIO_TIMER_KEY, itsDurationInfluence);
+    setValue(AUDIO_DEVICES_KEY, itsAudioDevices);
+    setValue(AUDIO_WINDOW_KEY, itsAudioWindow);
+    setValue(AUDIO_HOP_KEY, itsAudioHop);
+    setValue(AUDIO_HISTORY_KEY, itsHistoryDuration);
+    setValue(CLIP_DIRECTORY_KEY, itsClipDirectory);
+    setValue(CLIP_QUOTA_KEY, itsClipQuota);
+    setValue(LEVEL_STORE_KEY, itsLevelStoreFile);
+    setValue(SPECTRAL_THRESHOLD_KEY, itsSpectralThreshold);
+    QStringList frequencies;
+    foreach (int frequency, itsToneFrequencies)
+        frequencies.append(QString::number(frequency));
+    setValue(TONE_FREQUENCIES_KEY, frequencies);
+    setValue(PITCH_THRESHOLD_KEY, itsPitchThreshold);
+    setValue(CLASSIFIER_FILE_KEY, itsClassifierFile);
+    setValue(CLASSIFIER_THRESHOLD_KEY, itsClassifierThreshold);
+    setValue(PIPELINE_FILE_KEY, itsPipelineFile);
+    setValue(ENSEMBLE_RULE_KEY, itsEnsembleRule);
+    setValue(CASCADE_WINDOW_KEY, itsCascadeWindow);
+    setValue(CASCADE_LEVEL_KEY, itsCascadeLevel);
+    setValue(FILTER_DC_BLOCK_KEY, itsFilterDcBlock);
+    setValue(FILTER_HIGH_PASS_KEY, itsFilterHighPass);
+    setValue(FILTER_A_WEIGHTING_KEY, itsFilterAWeighting);
+    setValue(NOISE_SUPPRESSION_KEY, itsNoiseSuppression);
+    setValue(IGNORED_SOUNDS_KEY, itsIgnoredSoundsFile);
     setValue(CONTACT_PHONENUMBER_KEY, itsContact.itsPhoneNumber);
     setValue(CONTACT_NAME_KEY, itsContact.itsName);
     setValue(USER_NOTIFY_SCRIPT_KEY, itsUserNotifyScript);
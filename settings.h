@@ -19,6 +19,7 @@ babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
 #define SETTINGS_H
 
 #include <QSettings>
+#include <QStringList>
 #include "contact.h"
 
 
@@ -50,6 +51,48 @@ public:
     int itsAudioAmplify;
     //! the time based audio weight factor
     int itsDurationInfluence;
+    //! names of the audio input devices to monitor, the default device if empty
+    QStringList itsAudioDevices;
+    //! length of the sliding detection window in milliseconds, 0 for fixed intervals
+    int itsAudioWindow;
+    //! step of the sliding detection window in milliseconds
+    int itsAudioHop;
+    //! duration of the audio history in seconds, recorded as event clip
+    int itsHistoryDuration;
+    //! directory of the saved audio clips
+    QString itsClipDirectory;
+    //! disk quota of all event clips in MB, 0 to disable event recording
+    int itsClipQuota;
+    //! file of the persistent audio level series, none if empty
+    QString itsLevelStoreFile;
+    //! minimum spectral cry score in percent for loud audio to count, 0 to disable
+    int itsSpectralThreshold;
+    //! frequencies in Hz rating the cry score instead of the full spectrum, if any
+    QList<int> itsToneFrequencies;
+    //! minimum share of periodic frames in percent for loud audio to count, 0 to disable
+    int itsPitchThreshold;
+    //! model file of the cry classifier, none if empty
+    QString itsClassifierFile;
+    //! minimum cry probability in percent for loud audio to count, 0 to only report it
+    int itsClassifierThreshold;
+    //! pipeline file of the detectors, replacing the detector settings above if set
+    QString itsPipelineFile;
+    //! rule combining the detectors with the volume threshold: all, any, vote or mean
+    QString itsEnsembleRule;
+    //! seconds the detectors and the classifier run once woken, 0 to run them all the time
+    int itsCascadeWindow;
+    //! counter level in percent of the threshold waking the detectors and the classifier
+    int itsCascadeLevel;
+    //! determines whether DC is removed from the audio ahead of the level analysis
+    bool itsFilterDcBlock;
+    //! cutoff frequency in Hz of the high pass ahead of the level analysis, 0 to disable
+    int itsFilterHighPass;
+    //! determines whether the level analysis is A-weighted
+    bool itsFilterAWeighting;
+    //! over-subtraction in percent of the noise learned during the activation delay, 0 to disable
+    int itsNoiseSuppression;
+    //! file of the sounds the user marked to be ignored, none if empty
+    QString itsIgnoredSoundsFile;
 
     //! timeout until a call needs to be setup, otherwise it is aborted
     int itsCallSetupTimer;
@@ -101,6 +144,15 @@ public:
     const int AUDIO_SAMPLE_INTERVAL;
     //! subset of samples for which to determine their maximum to sum up in total value
     const int AUDIO_SAMPLE_SUBINTERVAL;
+    //! sample rate in Hz at which the audio analysis is performed
+    const int AUDIO_ANALYSIS_RATE;
+
+    //! percentile of the audio volume values taken as noise floor
+    const int NOISE_FLOOR_PERCENTILE;
+    //! time constant in seconds after which old volume values fade out of the noise floor
+    const int NOISE_FLOOR_TIME_CONSTANT;
+    //! distance of the volume threshold above the noise floor
+    const int NOISE_FLOOR_MARGIN;
 
     //! timeout until which audio sampling will be retried in case of establishment errors
     const int AUDIO_RETRY_TIMER;
@@ -0,0 +1,67 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "slidingwindow.h"
+
+
+/*!
+  The constructor sets up a window of a single subinterval.
+*/
+SlidingWindow::SlidingWindow()
+{
+    setup(1);
+}
+
+
+/*!
+  setup allocates a window of the given number of subintervals and clears it.
+*/
+void SlidingWindow::setup(int length)
+{
+    itsPeaks.fill(0, qMax(1, length));
+    reset();
+}
+
+
+/*!
+  reset clears the window.
+*/
+void SlidingWindow::reset()
+{
+    itsPos = 0;
+    itsCount = 0;
+    itsEnergy = 0;
+}
+
+
+/*!
+  add appends the peak of a new subinterval. If the window is full, the oldest
+  peak drops out.
+*/
+void SlidingWindow::add(int peak)
+{
+    if (itsCount == itsPeaks.size())
+        itsEnergy -= itsPeaks.at(itsPos);
+    else
+        itsCount++;
+
+    itsPeaks[itsPos] = peak;
+    itsEnergy += peak;
+
+    if (++itsPos == itsPeaks.size())
+        itsPos = 0;
+}
@@ -0,0 +1,70 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SLIDINGWINDOW_H
+#define SLIDINGWINDOW_H
+
+#include <QVector>
+
+
+/*!
+  SlidingWindow keeps the subinterval peaks of the most recent audio window
+  together with their running sum. Each new peak replaces the oldest one, so
+  the sum of the window is updated at O(1) cost per subinterval.
+*/
+class SlidingWindow
+{
+public:
+    SlidingWindow();
+
+    void setup(int length);
+    void reset();
+    void add(int peak);
+
+    int count() const;
+    quint64 energy() const;
+
+private:
+    //! the peaks of the window, as ring buffer
+    QVector<int> itsPeaks;
+    //! index of the oldest peak
+    int itsPos;
+    //! number of peaks in the window, until it is filled the first time
+    int itsCount;
+    //! sum of all peaks of the window
+    quint64 itsEnergy;
+};
+
+
+/*!
+  count returns the number of subinterval peaks in the window.
+*/
+inline int SlidingWindow::count() const
+{
+    return itsCount;
+}
+
+
+/*!
+  energy returns the sum of the subinterval peaks in the window.
+*/
+inline quint64 SlidingWindow::energy() const
+{
+    return itsEnergy;
+}
+
+#endif // SLIDINGWINDOW_H
@@ -0,0 +1,348 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "spectraldetector.h"
+
+#include <string.h>
+
+
+// the complex FFT of half size, on which the real FFT is based
+#define HALF_SIZE       (SpectralDetector::FFT_SIZE / 2)
+// offset of the cosine in SINE_TABLE
+#define COSINE_OFFSET   (SpectralDetector::FFT_SIZE / 4)
+
+
+// sin(2*pi*k/FFT_SIZE) for k = 0 .. 3/4 FFT_SIZE, the cosine is taken from the
+// same table at an offset of a quarter period
+static const float SINE_TABLE[SpectralDetector::FFT_SIZE*3/4 + 1] = {
+    0.000000000f, 0.024541229f, 0.049067674f, 0.073564564f, 0.098017140f, 0.122410675f,
+    0.146730474f, 0.170961889f, 0.195090322f, 0.219101240f, 0.242980180f, 0.266712757f,
+    0.290284677f, 0.313681740f, 0.336889853f, 0.359895037f, 0.382683432f, 0.405241314f,
+    0.427555093f, 0.449611330f, 0.471396737f, 0.492898192f, 0.514102744f, 0.534997620f,
+    0.555570233f, 0.575808191f, 0.595699304f, 0.615231591f, 0.634393284f, 0.653172843f,
+    0.671558955f, 0.689540545f, 0.707106781f, 0.724247083f, 0.740951125f, 0.757208847f,
+    0.773010453f, 0.788346428f, 0.803207531f, 0.817584813f, 0.831469612f, 0.844853565f,
+    0.857728610f, 0.870086991f, 0.881921264f, 0.893224301f, 0.903989293f, 0.914209756f,
+    0.923879533f, 0.932992799f, 0.941544065f, 0.949528181f, 0.956940336f, 0.963776066f,
+    0.970031253f, 0.975702130f, 0.980785280f, 0.985277642f, 0.989176510f, 0.992479535f,
+    0.995184727f, 0.997290457f, 0.998795456f, 0.999698819f, 1.000000000f, 0.999698819f,
+    0.998795456f, 0.997290457f, 0.995184727f, 0.992479535f, 0.989176510f, 0.985277642f,
+    0.980785280f, 0.975702130f, 0.970031253f, 0.963776066f, 0.956940336f, 0.949528181f,
+    0.941544065f, 0.932992799f, 0.923879533f, 0.914209756f, 0.903989293f, 0.893224301f,
+    0.881921264f, 0.870086991f, 0.857728610f, 0.844853565f, 0.831469612f, 0.817584813f,
+    0.803207531f, 0.788346428f, 0.773010453f, 0.757208847f, 0.740951125f, 0.724247083f,
+    0.707106781f, 0.689540545f, 0.671558955f, 0.653172843f, 0.634393284f, 0.615231591f,
+    0.595699304f, 0.575808191f, 0.555570233f, 0.534997620f, 0.514102744f, 0.492898192f,
+    0.471396737f, 0.449611330f, 0.427555093f, 0.405241314f, 0.382683432f, 0.359895037f,
+    0.336889853f, 0.313681740f, 0.290284677f, 0.266712757f, 0.242980180f, 0.219101240f,
+    0.195090322f, 0.170961889f, 0.146730474f, 0.122410675f, 0.098017140f, 0.073564564f,
+    0.049067674f, 0.024541229f, 0.000000000f, -0.024541229f, -0.049067674f, -0.073564564f,
+    -0.098017140f, -0.122410675f, -0.146730474f, -0.170961889f, -0.195090322f, -0.219101240f,
+    -0.242980180f, -0.266712757f, -0.290284677f, -0.313681740f, -0.336889853f, -0.359895037f,
+    -0.382683432f, -0.405241314f, -0.427555093f, -0.449611330f, -0.471396737f, -0.492898192f,
+    -0.514102744f, -0.534997620f, -0.555570233f, -0.575808191f, -0.595699304f, -0.615231591f,
+    -0.634393284f, -0.653172843f, -0.671558955f, -0.689540545f, -0.707106781f, -0.724247083f,
+    -0.740951125f, -0.757208847f, -0.773010453f, -0.788346428f, -0.803207531f, -0.817584813f,
+    -0.831469612f, -0.844853565f, -0.857728610f, -0.870086991f, -0.881921264f, -0.893224301f,
+    -0.903989293f, -0.914209756f, -0.923879533f, -0.932992799f, -0.941544065f, -0.949528181f,
+    -0.956940336f, -0.963776066f, -0.970031253f, -0.975702130f, -0.980785280f, -0.985277642f,
+    -0.989176510f, -0.992479535f, -0.995184727f, -0.997290457f, -0.998795456f, -0.999698819f,
+    -1.000000000f
+};
+
+// bit reversed indices of the complex FFT of HALF_SIZE points
+static const quint8 BIT_REVERSE[HALF_SIZE] = {
+      0,  64,  32,  96,  16,  80,  48, 112,   8,  72,  40, 104,  24,  88,  56, 120,
+      4,  68,  36, 100,  20,  84,  52, 116,  12,  76,  44, 108,  28,  92,  60, 124,
+      2,  66,  34,  98,  18,  82,  50, 114,  10,  74,  42, 106,  26,  90,  58, 122,
+      6,  70,  38, 102,  22,  86,  54, 118,  14,  78,  46, 110,  30,  94,  62, 126,
+      1,  65,  33,  97,  17,  81,  49, 113,   9,  73,  41, 105,  25,  89,  57, 121,
+      5,  69,  37, 101,  21,  85,  53, 117,  13,  77,  45, 109,  29,  93,  61, 125,
+      3,  67,  35,  99,  19,  83,  51, 115,  11,  75,  43, 107,  27,  91,  59, 123,
+      7,  71,  39, 103,  23,  87,  55, 119,  15,  79,  47, 111,  31,  95,  63, 127
+};
+
+
+/*!
+  The constructor sets up a disabled detector.
+*/
+SpectralDetector::SpectralDetector()
+    : itsRate(0), itsMinBin(0), itsMaxBin(0)
+{
+    reset();
+}
+
+
+/*!
+  setup enables the detector for audio of the given sample rate. A rate of 0
+  disables it. The harmonics are limited to the bins below the Nyquist
+  frequency.
+*/
+void SpectralDetector::setup(int rate)
+{
+    itsRate = qMax(0, rate);
+    if (itsRate > 0) {
+        itsMinBin = qMax(1, MIN_PITCH * FFT_SIZE / itsRate);
+        itsMaxBin = qBound(itsMinBin, (MAX_PITCH * FFT_SIZE + itsRate-1) / itsRate,
+                           FFT_SIZE/2 - HARMONIC_WIDTH - 1);
+    }
+
+    reset();
+}
+
+
+/*!
+  isEnabled returns true if the detector is set up for a sample rate.
+*/
+bool SpectralDetector::isEnabled() const
+{
+    return itsRate > 0;
+}
+
+
+/*!
+  reset drops the current frame and the collected frame scores.
+*/
+void SpectralDetector::reset()
+{
+    itsFill = 0;
+    itsScoreSum = 0;
+    itsScoreCount = 0;
+    itsScore = 0;
+}
+
+
+/*!
+  write adds the given S16 mono samples. Each time a frame is complete, it is
+  analysed and the frame moves on by HOP_SIZE samples.
+*/
+void SpectralDetector::write(const qint16 *data, int frames)
+{
+    if (!isEnabled())
+        return;
+
+    while (frames > 0) {
+        int n = qMin(frames, FFT_SIZE - itsFill);
+        memcpy(itsFrame + itsFill, data, n * sizeof(qint16));
+        itsFill += n;
+        data += n;
+        frames -= n;
+
+        if (itsFill == FFT_SIZE) {
+            itsScoreSum += analyzeFrame();
+            itsScoreCount++;
+
+            // the frames overlap by half
+            memcpy(itsFrame, itsFrame + HOP_SIZE, (FFT_SIZE - HOP_SIZE) * sizeof(qint16));
+            itsFill = FFT_SIZE - HOP_SIZE;
+        }
+    }
+}
+
+
+/*!
+  score returns the mean frame score since the last call, in percent. If no
+  frame got completed since, the previous score is returned.
+*/
+int SpectralDetector::score()
+{
+    if (itsScoreCount > 0) {
+        itsScore = (int)(100 * itsScoreSum / itsScoreCount + 0.5f);
+        itsScoreSum = 0;
+        itsScoreCount = 0;
+    }
+
+    return itsScore;
+}
+
+
+/*!
+  analyzeFrame returns the score of the current frame, between 0 and 1. It is
+  the energy of the strongest pitch in the fundamental band and of its
+  harmonics, relative to the total energy without the DC component.
+*/
+float SpectralDetector::analyzeFrame() const
+{
+    float power[FFT_SIZE/2 + 1];
+    spectrum(itsFrame, power);
+
+    float total = 0;
+    for (int k = 1; k <= FFT_SIZE/2; ++k)
+        total += power[k];
+    // silence has no pitch
+    if (total < 1.0f)
+        return 0;
+
+    int pitch = itsMinBin;
+    for (int k = itsMinBin+1; k <= itsMaxBin; ++k) {
+        if (power[k] > power[pitch])
+            pitch = k;
+    }
+
+    float harmonic = 0;
+    for (int h = 1; h <= HARMONICS; ++h) {
+        int center = h * pitch;
+        if (center + HARMONIC_WIDTH > FFT_SIZE/2)
+            break;
+        for (int k = center - HARMONIC_WIDTH; k <= center + HARMONIC_WIDTH; ++k)
+            harmonic += power[k];
+    }
+
+    return qMin(1.0f, harmonic / total);
+}
+
+
+/*!
+  butterflies performs the complex FFT of HALF_SIZE points in place, on input
+  in bit reversed order.
+*/
+static void butterflies(float *re, float *im)
+{
+    // radix-2 butterflies, W = exp(-2*pi*i*t/FFT_SIZE)
+    for (int size = 2; size <= HALF_SIZE; size *= 2) {
+        int half = size / 2;
+        int step = SpectralDetector::FFT_SIZE / size;
+        for (int j = 0; j < half; ++j) {
+            float wr = SINE_TABLE[COSINE_OFFSET + j*step];
+            float wi = -SINE_TABLE[j*step];
+            for (int a = j; a < HALF_SIZE; a += size) {
+                int b = a + half;
+                float tr = wr * re[b] - wi * im[b];
+                float ti = wr * im[b] + wi * re[b];
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+
+/*!
+  split converts the complex FFT of the even and odd samples into the
+  FFT_SIZE/2+1 bins of the real signal from DC to the Nyquist frequency,
+  X = (Z[k] + Z*[-k])/2 - i/2 W^k (Z[k] - Z*[-k]).
+*/
+static void split(const float *re, const float *im, float *xr, float *xi)
+{
+    for (int k = 0; k <= HALF_SIZE; ++k) {
+        int a = k % HALF_SIZE;
+        int b = (HALF_SIZE - k) % HALF_SIZE;
+        float evenRe = 0.5f * (re[a] + re[b]);
+        float evenIm = 0.5f * (im[a] - im[b]);
+        float oddRe = 0.5f * (im[a] + im[b]);
+        float oddIm = -0.5f * (re[a] - re[b]);
+
+        float wr = SINE_TABLE[COSINE_OFFSET + k];
+        float wi = -SINE_TABLE[k];
+        xr[k] = evenRe + wr * oddRe - wi * oddIm;
+        xi[k] = evenIm + wr * oddIm + wi * oddRe;
+    }
+}
+
+
+/*!
+  spectrum computes the power spectrum of FFT_SIZE samples with Hann window.
+  The FFT_SIZE/2+1 bins from DC to the Nyquist frequency are stored in power.
+
+  The even and odd samples form the real and imaginary part of a complex FFT of
+  HALF_SIZE points. Its result is split into the spectrum of the real signal.
+*/
+void SpectralDetector::spectrum(const qint16 *data, float *power)
+{
+    float re[HALF_SIZE];
+    float im[HALF_SIZE];
+
+    // apply the symmetric window, in bit reversed order
+    for (int n = 0; n < HALF_SIZE; ++n) {
+        int even = 2*n;
+        int odd = 2*n + 1;
+        float wEven = 0.5f - 0.5f * SINE_TABLE[COSINE_OFFSET + qMin(even, FFT_SIZE - even)];
+        float wOdd = 0.5f - 0.5f * SINE_TABLE[COSINE_OFFSET + qMin(odd, FFT_SIZE - odd)];
+
+        int r = BIT_REVERSE[n];
+        re[r] = wEven * data[even];
+        im[r] = wOdd * data[odd];
+    }
+    butterflies(re, im);
+
+    float xr[HALF_SIZE + 1];
+    float xi[HALF_SIZE + 1];
+    split(re, im, xr, xi);
+    for (int k = 0; k <= HALF_SIZE; ++k)
+        power[k] = xr[k]*xr[k] + xi[k]*xi[k];
+}
+
+
+/*!
+  transform computes the FFT of FFT_SIZE real samples, without window. The
+  real and imaginary parts of the FFT_SIZE/2+1 bins from DC to the Nyquist
+  frequency are stored in re and im.
+*/
+void SpectralDetector::transform(const float *data, float *re, float *im)
+{
+    float zr[HALF_SIZE];
+    float zi[HALF_SIZE];
+    for (int n = 0; n < HALF_SIZE; ++n) {
+        int r = BIT_REVERSE[n];
+        zr[r] = data[2*n];
+        zi[r] = data[2*n + 1];
+    }
+    butterflies(zr, zi);
+    split(zr, zi, re, im);
+}
+
+
+/*!
+  inverse computes the FFT_SIZE real samples of the given FFT_SIZE/2+1 bins,
+  the inverse of transform. The bins are combined into the complex FFT of the
+  even and odd samples, E[k] + i O[k] with E[k] = (X[k] + X*[N/2-k])/2 and
+  O[k] = W^-k (X[k] - X*[N/2-k])/2. Its inverse is the conjugate of the FFT of
+  the conjugate, divided by HALF_SIZE.
+*/
+void SpectralDetector::inverse(const float *re, const float *im, float *data)
+{
+    float zr[HALF_SIZE];
+    float zi[HALF_SIZE];
+    for (int k = 0; k < HALF_SIZE; ++k) {
+        float ar = re[k];
+        float ai = im[k];
+        float br = re[HALF_SIZE - k];
+        float bi = -im[HALF_SIZE - k];
+        float evenRe = 0.5f * (ar + br);
+        float evenIm = 0.5f * (ai + bi);
+        float diffRe = 0.5f * (ar - br);
+        float diffIm = 0.5f * (ai - bi);
+
+        float wr = SINE_TABLE[COSINE_OFFSET + k];
+        float wi = SINE_TABLE[k];
+        float oddRe = diffRe * wr - diffIm * wi;
+        float oddIm = diffRe * wi + diffIm * wr;
+
+        int r = BIT_REVERSE[k];
+        zr[r] = evenRe - oddIm;
+        zi[r] = -(evenIm + oddRe);
+    }
+    butterflies(zr, zi);
+
+    const float scale = 1.0f / HALF_SIZE;
+    for (int n = 0; n < HALF_SIZE; ++n) {
+        data[2*n] = scale * zr[n];
+        data[2*n + 1] = -scale * zi[n];
+    }
+}
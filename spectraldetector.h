@@ -0,0 +1,90 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SPECTRALDETECTOR_H
+#define SPECTRALDETECTOR_H
+
+#include <QtGlobal>
+
+
+/*!
+  SpectralDetector rates how much the audio resembles a crying infant, as
+  opposed to broadband noise like door slams or sounds of other pitch.
+
+  The S16 mono audio is split into overlapping frames of FFT_SIZE samples,
+  which get a Hann window and a real FFT of fixed size. The FFT works on a
+  complex FFT of half size and uses constant twiddle and bit reversal tables.
+  For each frame, the strongest bin within the cry fundamental band is taken
+  as pitch. The energy of this pitch and of its harmonics relative to the total
+  energy of the frame forms the frame score.
+
+  The score reported to the caller is the mean frame score since the last
+  query, in percent. The FFT and its inverse are available to other stages as
+  well.
+*/
+class SpectralDetector
+{
+public:
+    //! number of samples of a frame
+    const static int FFT_SIZE = 256;
+
+    SpectralDetector();
+
+    void setup(int rate);
+    bool isEnabled() const;
+    void reset();
+
+    void write(const qint16 *data, int frames);
+    int score();
+
+    static void spectrum(const qint16 *data, float *power);
+    static void transform(const float *data, float *re, float *im);
+    static void inverse(const float *re, const float *im, float *data);
+
+private:
+    //! number of new samples per frame, half the frame size
+    const static int HOP_SIZE = FFT_SIZE / 2;
+    //! infant cry fundamental band in Hz
+    const static int MIN_PITCH = 250;
+    const static int MAX_PITCH = 650;
+    //! number of harmonics including the fundamental
+    const static int HARMONICS = 4;
+    //! bins on each side of a harmonic added to its energy
+    const static int HARMONIC_WIDTH = 1;
+
+    float analyzeFrame() const;
+
+    //! sample rate, 0 if disabled
+    int itsRate;
+    //! bin range of the fundamental band
+    int itsMinBin;
+    int itsMaxBin;
+
+    //! samples of the current frame
+    qint16 itsFrame[FFT_SIZE];
+    //! number of samples of the current frame
+    int itsFill;
+
+    //! sum of the frame scores since the last query
+    float itsScoreSum;
+    //! number of frames since the last query
+    int itsScoreCount;
+    //! latest score, repeated if no frame completed in between
+    int itsScore;
+};
+
+#endif // SPECTRALDETECTOR_H
@@ -0,0 +1,215 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "taskpool.h"
+
+#include <QThread>
+
+
+/*!
+  TaskWorker is a worker thread of the TaskPool.
+*/
+class TaskWorker : public QThread
+{
+public:
+    TaskWorker(TaskPool *pool, int index) : itsPool(pool), itsIndex(index) {}
+
+protected:
+    void run() { itsPool->work(itsIndex); }
+
+private:
+    TaskPool *itsPool;
+    int itsIndex;
+};
+
+
+/*!
+  The constructor starts the given number of worker threads, which may be 0.
+*/
+TaskPool::TaskPool(int threads, QObject *parent)
+    : QObject(parent), itsQueued(0), itsStopRequest(0)
+{
+    threads = qMax(0, threads);
+    itsQueues = new Queue[qMax(1, threads)];
+    for (int i = 0; i < qMax(1, threads); ++i) {
+        itsQueues[i].head = 0;
+        itsQueues[i].count = 0;
+    }
+
+    // the workers read the number of workers, it is complete before they start
+    for (int i = 0; i < threads; ++i)
+        itsWorkers.append(new TaskWorker(this, i));
+    foreach (TaskWorker *worker, itsWorkers)
+        worker->start(QThread::HighPriority);
+}
+
+
+/*!
+  The destructor terminates the worker threads and waits for their end.
+*/
+TaskPool::~TaskPool()
+{
+    itsStopRequest = 1;
+    {
+        QMutexLocker locker(&itsLock);
+        itsWork.wakeAll();
+    }
+
+    foreach (TaskWorker *worker, itsWorkers) {
+        worker->wait();
+        delete worker;
+    }
+    delete[] itsQueues;
+}
+
+
+/*!
+  threads returns the number of worker threads.
+*/
+int TaskPool::threads() const
+{
+    return itsWorkers.size();
+}
+
+
+/*!
+  run executes the given tasks and returns as all of them are complete. The
+  calling thread runs tasks as well, the tasks of a full queue directly.
+*/
+void TaskPool::run(QRunnable * const *tasks, int count)
+{
+    const int threads = itsWorkers.size();
+    if ( (threads == 0) || (count == 1) ) {
+        for (int i = 0; i < count; ++i)
+            tasks[i]->run();
+        return;
+    }
+
+    QAtomicInt pending(count);
+    for (int i = 0; i < count; ++i) {
+        Item item;
+        item.task = tasks[i];
+        item.pending = &pending;
+        if (!push(i % threads, item))
+            execute(item);
+    }
+    {
+        QMutexLocker locker(&itsLock);
+        itsWork.wakeAll();
+    }
+
+    // help until the batch is complete, the last tasks may still be running;
+    // the acquiring read makes the results of the tasks visible to the caller
+    Item item;
+    while (pending.fetchAndAddAcquire(0) != 0) {
+        if (take(-1, &item)) {
+            execute(item);
+            continue;
+        }
+
+        QMutexLocker locker(&itsLock);
+        while ( (pending != 0) && (itsQueued == 0) )
+            itsDone.wait(&itsLock);
+    }
+}
+
+
+/*!
+  push appends the given item to the given queue. It returns false if the
+  queue is full.
+*/
+bool TaskPool::push(int queue, const Item &item)
+{
+    Queue &q = itsQueues[queue];
+    QMutexLocker locker(&q.lock);
+    if (q.count == QUEUE_SIZE)
+        return false;
+
+    q.items[(q.head + q.count) % QUEUE_SIZE] = item;
+    q.count++;
+    itsQueued.ref();
+    return true;
+}
+
+
+/*!
+  take removes a task to run by the given worker: the most recent one of its
+  own queue or else the oldest one of another queue. The calling thread of run
+  is worker -1, it only steals. It returns false if all queues are empty.
+*/
+bool TaskPool::take(int worker, Item *item)
+{
+    const int threads = itsWorkers.size();
+    if (worker >= 0) {
+        Queue &own = itsQueues[worker];
+        QMutexLocker locker(&own.lock);
+        if (own.count > 0) {
+            own.count--;
+            *item = own.items[(own.head + own.count) % QUEUE_SIZE];
+            itsQueued.deref();
+            return true;
+        }
+    }
+
+    for (int i = 1; i <= threads; ++i) {
+        Queue &other = itsQueues[(worker + i + threads) % threads];
+        QMutexLocker locker(&other.lock);
+        if (other.count > 0) {
+            *item = other.items[other.head];
+            other.head = (other.head + 1) % QUEUE_SIZE;
+            other.count--;
+            itsQueued.deref();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/*!
+  execute runs the task of the given item and signals the completion of its
+  batch. The batch counter may be gone as soon as it got decremented.
+*/
+void TaskPool::execute(const Item &item)
+{
+    item.task->run();
+    if (!item.pending->deref()) {
+        QMutexLocker locker(&itsLock);
+        itsDone.wakeAll();
+    }
+}
+
+
+/*!
+  work runs the tasks of the given worker until the pool terminates. It waits
+  while all queues are empty.
+*/
+void TaskPool::work(int worker)
+{
+    Item item;
+    while (!itsStopRequest) {
+        if (take(worker, &item)) {
+            execute(item);
+            continue;
+        }
+
+        QMutexLocker locker(&itsLock);
+        while ( (itsQueued == 0) && !itsStopRequest )
+            itsWork.wait(&itsLock);
+    }
+}
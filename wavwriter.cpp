@@ -0,0 +1,197 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "wavwriter.h"
+
+#include <string.h>
+
+#include <QtEndian>
+#include <QVarLengthArray>
+
+
+/*!
+  The constructor sets up a closed writer.
+*/
+WavWriter::WavWriter()
+    : itsRate(0), itsBlockBytes(0), itsBlockSamples(0), itsSamples(0),
+      itsDataSize(0)
+{
+}
+
+
+/*!
+  The destructor completes an open file.
+*/
+WavWriter::~WavWriter()
+{
+    if (itsFile.isOpen())
+        close();
+}
+
+
+/*!
+  open creates the given file for S16 audio of the given sample rate. It
+  returns false on errors.
+*/
+bool WavWriter::open(const QString &fileName, int rate)
+{
+    return openAdpcm(fileName, rate, 0, 0);
+}
+
+
+/*!
+  openAdpcm creates the given file for IMA ADPCM audio of the given sample rate
+  and block layout. A block size of 0 selects S16 audio. It returns false on
+  errors.
+*/
+bool WavWriter::openAdpcm(const QString &fileName, int rate, int blockBytes,
+                          int blockSamples)
+{
+    itsFile.setFileName(fileName);
+    if (!itsFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    itsRate = rate;
+    itsBlockBytes = blockBytes;
+    itsBlockSamples = blockSamples;
+    itsSamples = 0;
+    itsDataSize = 0;
+
+    // the header gets rewritten with the final sizes on close
+    return writeHeader();
+}
+
+
+/*!
+  write appends the given samples. It returns false on errors.
+*/
+bool WavWriter::write(const qint16 *samples, int count)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    qint64 len = count * sizeof(qint16);
+    if (itsFile.write((const char*)samples, len) != len)
+        return false;
+#else
+    QVarLengthArray<qint16, 1024> buffer(count);
+    for (int i = 0; i < count; ++i)
+        buffer[i] = qToLittleEndian(samples[i]);
+    qint64 len = count * sizeof(qint16);
+    if (itsFile.write((const char*)buffer.constData(), len) != len)
+        return false;
+#endif
+
+    itsSamples += count;
+    itsDataSize += count * sizeof(qint16);
+    return true;
+}
+
+
+/*!
+  writeBlocks appends the given number of IMA ADPCM blocks. It returns false
+  on errors.
+*/
+bool WavWriter::writeBlocks(const char *blocks, int count)
+{
+    qint64 len = (qint64)count * itsBlockBytes;
+    if (itsFile.write(blocks, len) != len)
+        return false;
+
+    itsSamples += count * itsBlockSamples;
+    itsDataSize += len;
+    return true;
+}
+
+
+/*!
+  size returns the size of the file written so far.
+*/
+qint64 WavWriter::size() const
+{
+    return itsFile.size();
+}
+
+
+/*!
+  close writes the final header and closes the file. It returns false on
+  errors.
+*/
+bool WavWriter::close()
+{
+    bool result = itsFile.seek(0) && writeHeader();
+    itsFile.close();
+
+    return result;
+}
+
+
+/*!
+  errorString returns a description of the last error.
+*/
+QString WavWriter::errorString() const
+{
+    return itsFile.errorString();
+}
+
+
+/*!
+  writeHeader writes the RIFF WAVE header for the audio written so far. The
+  ADPCM format additionally needs the samples per block and a fact chunk with
+  the number of samples.
+*/
+bool WavWriter::writeHeader()
+{
+    bool adpcm = (itsBlockBytes > 0);
+    int formatSize = adpcm ? 20 : 16;
+    int headerSize = adpcm ? 60 : 44;
+
+    uchar header[60];
+    uchar *p = header;
+    memcpy(p, "RIFF", 4);
+    qToLittleEndian<quint32>(headerSize - 8 + itsDataSize, p+4);
+    memcpy(p+8, "WAVEfmt ", 8);
+    qToLittleEndian<quint32>(formatSize, p+16);
+    p += 20;
+
+    if (adpcm) {
+        qToLittleEndian<quint16>(0x11, p);              // IMA ADPCM
+        qToLittleEndian<quint16>(1, p+2);               // mono
+        qToLittleEndian<quint32>(itsRate, p+4);
+        qToLittleEndian<quint32>((qint64)itsRate * itsBlockBytes / itsBlockSamples, p+8);
+        qToLittleEndian<quint16>(itsBlockBytes, p+12);
+        qToLittleEndian<quint16>(4, p+14);              // bits per sample
+        qToLittleEndian<quint16>(2, p+16);              // extra format bytes
+        qToLittleEndian<quint16>(itsBlockSamples, p+18);
+        memcpy(p+20, "fact", 4);
+        qToLittleEndian<quint32>(4, p+24);
+        qToLittleEndian<quint32>(itsSamples, p+28);
+        p += 32;
+    }
+    else {
+        qToLittleEndian<quint16>(1, p);                 // PCM
+        qToLittleEndian<quint16>(1, p+2);               // mono
+        qToLittleEndian<quint32>(itsRate, p+4);
+        qToLittleEndian<quint32>(itsRate * sizeof(qint16), p+8);
+        qToLittleEndian<quint16>(sizeof(qint16), p+12);
+        qToLittleEndian<quint16>(16, p+14);             // bits per sample
+        p += 16;
+    }
+
+    memcpy(p, "data", 4);
+    qToLittleEndian<quint32>(itsDataSize, p+4);
+
+    return itsFile.write((const char*)header, headerSize) == headerSize;
+}
@@ -0,0 +1,63 @@
+/*
+babyphone - A baby monitor application for Maemo / MeeGo (Nokia N900, N950, N9).
+    Copyright (C) 2011  Roman Morawek <maemo@morawek.at>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <QFile>
+
+
+/*!
+  WavWriter writes mono audio to a RIFF WAVE file, either as S16 samples or as
+  IMA ADPCM blocks. The sizes in the header are filled in as the file gets
+  closed, so the audio can be written piecewise.
+*/
+class WavWriter
+{
+public:
+    WavWriter();
+    ~WavWriter();
+
+    bool open(const QString &fileName, int rate);
+    bool openAdpcm(const QString &fileName, int rate, int blockBytes, int blockSamples);
+    bool write(const qint16 *samples, int count);
+    bool writeBlocks(const char *blocks, int count);
+    bool close();
+
+    qint64 size() const;
+
+    QString errorString() const;
+
+private:
+    bool writeHeader();
+
+private:
+    //! the audio file
+    QFile itsFile;
+    //! sample rate in Hz
+    int itsRate;
+    //! size of an ADPCM block in bytes, 0 for S16 samples
+    int itsBlockBytes;
+    //! number of samples of an ADPCM block
+    int itsBlockSamples;
+    //! number of samples written
+    qint64 itsSamples;
+    //! number of audio data bytes written
+    qint64 itsDataSize;
+};
+
+#endif // WAVWRITER_H